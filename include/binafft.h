@@ -9,11 +9,25 @@
 #ifndef BINA_FFT_BINAFFT_H
 #define BINA_FFT_BINAFFT_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef void *bina_transform;
+typedef void *bina_plan_cache;
+typedef void *bina_convolver;
+typedef void *bina_partitioned_convolver;
+typedef void *bina_stft;
+typedef void *bina_welch;
+typedef void *bina_sdft;
+typedef void *bina_sparse_fft;
+typedef void *bina_nufft;
+typedef void *bina_mdct;
+typedef void *bina_ntt_convolver;
+typedef void *bina_file_fft;
 
 /* Use C99 Complex if complex.h is included prior to this file */
 #if defined(_Complex_I) && defined(complex) && defined(I)
@@ -35,6 +49,69 @@ typedef void *bina_transform;
 
 BINA_DECL_TYPE(double, );
 
+/* Plan flags */
+
+/* Store only the first octant of the twiddle factors (N/8 + 1 values) and
+ * rebuild the rest of the unit circle from symmetry while executing. Trades a
+ * little arithmetic for a table that is 8x smaller, for very large problems.
+ * Only the twiddle table shrinks: the plan still keeps an N-point work
+ * buffer and an N/2-entry permutation table, so a double precision plan
+ * takes about 20N bytes instead of 34N.
+ */
+#define BINA_FFT_COMPACT_TWIDDLE (1 << 0)
+
+/* Inverse transform, x[n] = sum X[k] exp(+2 pi i n k / N). The result is not
+ * divided by N.
+ */
+#define BINA_FFT_INVERSE (1 << 1)
+
+/* Zero padded input: only the first 2^lg_m inputs can be nonzero, and the
+ * rest are not read. The first lg(N / 2^lg_m) stages then only copy and
+ * rotate, for about N lg(2^lg_m) work instead of N lg N.
+ */
+#define BINA_FFT_NONZERO_INPUTS(lg_m) ((((lg_m) + 1) & 0x1f) << 16)
+#define BINA_FFT_NONZERO_INPUTS_MASK (0x1f << 16)
+
+/* Scrambled spectrum, for transforms that only multiply it: the forward
+ * transform leaves it in bit reversed order, and the inverse (with
+ * BINA_FFT_INVERSE) takes it in that order and returns natural order.
+ * Neither pays for a permutation. The inverse reads the whole spectrum, so
+ * it cannot be combined with BINA_FFT_NONZERO_INPUTS(): plan creation fails.
+ */
+#define BINA_FFT_SCRAMBLED (1 << 12)
+
+/* Analysis windows (periodic) */
+#define BINA_WINDOW_RECTANGULAR (0)
+#define BINA_WINDOW_HANN (1)
+#define BINA_WINDOW_HAMMING (2)
+#define BINA_WINDOW_BLACKMAN (3)
+
+/* MDCT windows, symmetric, with w[n]^2 + w[n + N]^2 = 1 over 2N points */
+#define BINA_WINDOW_SINE (4)
+#define BINA_WINDOW_KBD (5)
+
+/* STFT output: power spectrum |X|^2 or 10 lg |X|^2 (dB) instead of the
+ * spectrum, as fft_length doubles per frame.
+ */
+#define BINA_STFT_POWER (1 << 8)
+#define BINA_STFT_LOG_POWER (1 << 9)
+
+/* NUFFT gridding kernel: Kaiser-Bessel instead of exponential of
+ * semicircle
+ */
+#define BINA_NUFFT_KAISER_BESSEL (1 << 10)
+
+/* Half precision transforms: bfloat16 storage instead of IEEE binary16 */
+#define BINA_FFT_BFLOAT16 (1 << 11)
+
+/* Real-to-real transform kinds */
+#define BINA_DCT_I (0)
+#define BINA_DCT_II (1)
+#define BINA_DCT_III (2)
+#define BINA_DCT_IV (3)
+#define BINA_DST_II (4)
+#define BINA_DST_III (5)
+
 int bina_transform_execute(bina_transform);
 int bina_transform_free(bina_transform);
 
@@ -43,6 +120,202 @@ bina_transform bina_transform_create_radix2_c2c_fft
 		(bina_complex *in, bina_complex *out,
 		int fft_length, int flags);
 
+/* Runs a radix-2 complex FFT on a frame split in two, such as one that
+ * wraps around the end of a ring buffer, without copying it together. The
+ * output goes to the buffer the transform was created with.
+ */
+int bina_transform_execute_segments(bina_transform,
+		const bina_complex *head, int head_length,
+		const bina_complex *tail, int tail_length);
+
+/* Complex FFT of up to 2^60 points. Past 2^20 points, it runs as four
+ * steps of shorter transforms; out of place, the input is then overwritten.
+ */
+bina_transform bina_transform_create_radix2_c2c_fft_64
+		(bina_complex *in, bina_complex *out,
+		size_t fft_length, int flags);
+
+/* Real transforms, n real samples <-> n/2 + 1 bins. The complex-to-real
+ * transform is not divided by N.
+ */
+bina_transform bina_transform_create_radix2_r2c_fft
+		(bina_real *in, bina_complex *out,
+		int fft_length, int flags);
+
+bina_transform bina_transform_create_radix2_c2r_fft
+		(bina_complex *in, bina_real *out,
+		int fft_length, int flags);
+
+/* Cosine and sine transforms of N points (N + 1 for DCT-I), N a power of
+ * two. Not normalized: DCT-III undoes DCT-II and DST-III undoes DST-II,
+ * DCT-I and DCT-IV undo themselves, all times N/2.
+ */
+bina_transform bina_transform_create_r2r
+		(bina_real *in, bina_real *out,
+		int length, int kind, int flags);
+
+/* Selected bins only: out[j] = X[bins[j]] for 0 <= j < num_bins */
+bina_transform bina_transform_create_pruned_dft
+		(bina_complex *in, bina_complex *out, int fft_length,
+		const int *bins, int num_bins, int flags);
+
+/* Chirp-Z transform, X[k] = sum x[n] exp(-2 pi i n (start + k step)) for
+ * 0 <= k < output_length, with frequencies in cycles per sample.
+ */
+bina_transform bina_transform_create_czt
+		(bina_complex *in, bina_complex *out, int input_length,
+		int output_length, double start, double step, int flags);
+
+bina_transform bina_transform_create_radix2_c2c_fft_2d
+		(bina_complex *in, bina_complex *out,
+		int rows, int columns, int flags);
+
+/* Plan cache: precomputed tables in a file shared by many processes */
+int bina_plan_cache_write(const char *path, const int *fft_lengths,
+		int count, int flags);
+bina_plan_cache bina_plan_cache_open(const char *path);
+int bina_plan_cache_close(bina_plan_cache);
+
+bina_transform bina_transform_create_radix2_c2c_fft_cached
+		(bina_plan_cache cache, bina_complex *in, bina_complex *out,
+		int fft_length, int flags);
+
+/* Streaming fast convolution (FIR filter), overlap-save. A zero fft_length
+ * picks the block size automatically.
+ */
+bina_convolver bina_convolver_create(const bina_complex *filter,
+		int filter_length, int fft_length, int flags);
+int bina_convolver_process(bina_convolver, const bina_complex *in,
+		bina_complex *out, int length);
+int bina_convolver_latency(bina_convolver);
+int bina_convolver_free(bina_convolver);
+
+/* Partitioned convolution of real signals for long filters: the output of
+ * each block comes out of the call that takes it, and the work of every
+ * call is bounded. Partitions grow from block_length to
+ * max_partition_length (zero for uniform partitions).
+ */
+bina_partitioned_convolver bina_partitioned_convolver_create
+		(const bina_real *filter, int filter_length,
+		int block_length, int max_partition_length, int flags);
+int bina_partitioned_convolver_process(bina_partitioned_convolver,
+		const bina_real *in, bina_real *out);
+int bina_partitioned_convolver_free(bina_partitioned_convolver);
+
+/* Short time Fourier transform of a sample stream: a frame of fft_length
+ * samples every `hop' samples, windowed and transformed.
+ */
+bina_stft bina_stft_create(int fft_length, int hop, int window, int flags);
+int bina_stft_frame_count(bina_stft, int length);
+int bina_stft_process(bina_stft, const bina_complex *in, int length,
+		void *frames);
+int bina_stft_spectrogram(bina_stft, const bina_complex *signal,
+		int length, void *frames);
+int bina_stft_free(bina_stft);
+
+/* Welch power spectral density of a real sample stream: segments of
+ * segment_length samples every `hop' samples, windowed, and their power
+ * averaged. alpha = 0 averages all segments alike, 0 < alpha <= 1 averages
+ * exponentially with that weight for the newest segment.
+ */
+bina_welch bina_welch_create(int segment_length, int hop, int window,
+		double alpha, int flags);
+int bina_welch_process(bina_welch, const bina_real *in, int length);
+int bina_welch_psd(bina_welch, bina_real *psd);
+int bina_welch_free(bina_welch);
+
+/* Sliding DFT: bins of the last fft_length samples, updated every sample.
+ * `bins' lists the tracked bins (NULL for all). A damping below 1 weights
+ * the sample m steps back by damping^m and keeps the recursion stable; the
+ * bins are recomputed with a full transform every resync_interval samples
+ * (0 for fft_length).
+ */
+bina_sdft bina_sdft_create(int fft_length, const int *bins, int num_bins,
+		double damping, int resync_interval, int flags);
+int bina_sdft_seed(bina_sdft, const bina_complex *frame);
+int bina_sdft_process(bina_sdft, const bina_complex *in, int length,
+		bina_complex *out);
+int bina_sdft_free(bina_sdft);
+
+/* Experimental sparse FFT: the k largest bins of a spectrum with about k
+ * significant bins (on the bin grid), from O(k lg N) samples per round.
+ * The confidence is near 1 when the bins explain the signal; fall back to a
+ * dense transform otherwise.
+ */
+bina_sparse_fft bina_sparse_fft_create(int fft_length, int sparsity,
+		int flags);
+int bina_sparse_fft_execute(bina_sparse_fft, const bina_complex *in,
+		int *bins, bina_complex *values, double *confidence);
+int bina_sparse_fft_free(bina_sparse_fft);
+
+/* Non-uniform FFT of N modes -N/2 <= k < N/2 (N even) and M points x[j]
+ * (radians), to the given relative tolerance. Type 1 sums the points into
+ * the modes, f[k] = sum c[j] exp(-i k x[j]), type 2 the modes into the
+ * points, c[j] = sum f[k] exp(-i k x[j]); BINA_FFT_INVERSE flips the sign.
+ */
+bina_nufft bina_nufft_create(int type, int modes, const double *points,
+		int num_points, double tolerance, int flags);
+int bina_nufft_execute(bina_nufft, const bina_complex *in,
+		bina_complex *out);
+int bina_nufft_free(bina_nufft);
+
+/* MDCT of a real sample stream: N coefficients for every N samples, from
+ * 2N windowed samples. The inverse overlap-adds its frames and returns the
+ * stream N samples late, with the aliasing cancelled and scaled back.
+ */
+bina_mdct bina_mdct_create(int frame_length, int window, int flags);
+int bina_mdct_forward(bina_mdct, const bina_real *in, int length,
+		bina_real *coefficients);
+int bina_mdct_inverse(bina_mdct, const bina_real *coefficients,
+		int frames, bina_real *out);
+int bina_mdct_free(bina_mdct);
+
+/* 16-bit fixed-point complex FFT, (re, im) pairs in and out, with block
+ * floating point scaling: the transform is out 2^exponent, the exponent of
+ * the last run given by bina_fixed_fft_exponent().
+ */
+bina_transform bina_transform_create_fixed_c2c_fft(int16_t *in,
+		int16_t *out, int fft_length, int flags);
+int bina_fixed_fft_exponent(bina_transform);
+
+/* Complex FFT on 16-bit floating point (re, im) pairs, IEEE binary16 or
+ * with BINA_FFT_BFLOAT16 bfloat16, computed in double precision. Samples
+ * are widened in the first stage and rounded in the permutation, so the
+ * only double precision array is the scratch buffer of the stages. Binary16
+ * overflows to infinity above 65504: scale the input to suit the length.
+ */
+bina_transform bina_transform_create_half_c2c_fft(uint16_t *in,
+		uint16_t *out, int fft_length, int flags);
+
+/* Number-theoretic transforms, exact, over the integers modulo one of three
+ * primes below 2^62 (prime 0 to 2). Residues in and out are below the
+ * modulus; BINA_FFT_INVERSE is not divided by n.
+ */
+uint64_t bina_ntt_modulus(int prime);
+bina_transform bina_transform_create_ntt(uint64_t *in, uint64_t *out,
+		int length, int prime, int flags);
+
+/* Exact linear convolution of 64-bit unsigned sequences, with 192-bit
+ * results (three words each, least significant first), for big integer and
+ * polynomial products.
+ */
+bina_ntt_convolver bina_ntt_convolver_create(int max_length);
+int bina_ntt_convolve(bina_ntt_convolver, const uint64_t *a, int a_length,
+		const uint64_t *b, int b_length, uint64_t *out);
+int bina_ntt_convolver_free(bina_ntt_convolver);
+
+/* Out-of-core complex FFT of a file of N bina_complex into another, for
+ * files larger than memory. The data in memory takes at most memory_budget
+ * bytes, the O(sqrt N) twiddle tables and plans aside; each of the two
+ * passes reads and writes the files once.
+ */
+bina_file_fft bina_file_fft_create(size_t fft_length, size_t memory_budget,
+		int flags);
+int bina_file_fft_execute(bina_file_fft, int in_fd, int out_fd);
+int bina_file_fft_execute_path(bina_file_fft, const char *in_path,
+		const char *out_path);
+int bina_file_fft_free(bina_file_fft);
+
 #undef BINA_DECL_TYPE
 
 #ifdef __cplusplus
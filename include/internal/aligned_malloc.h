@@ -4,8 +4,21 @@
 #define BINA_FFT_ALIGNED_MALLOC_H
 
 void *aligned_calloc(size_t alignment, size_t elements, size_t size);
+void *aligned_malloc(size_t alignment, size_t elements, size_t size);
 void *aligned_2d_calloc(size_t alignment, size_t rows, size_t columns,
 			size_t element_size);
+
+/* Cache geometry used to pick 2-D row pitches */
+#define ALIGNED_CACHE_LINE (64U)
+#define ALIGNED_ALIASING_PERIOD (512U)
+
+/* Pad row pitches to spread the rows of a column over the cache sets */
+#define ALIGNED_PITCH_AVOID_ALIASING (1 << 0)
+
+size_t aligned_pitch(size_t alignment, size_t columns, size_t element_size,
+		     int flags);
+void *aligned_pitched_calloc(size_t alignment, size_t rows, size_t columns,
+			     size_t element_size, int flags, size_t *pitch);
 void aligned_free(void *ptr);
 
 #endif				/* BINA_FFT_ALIGNED_MALLOC_H */
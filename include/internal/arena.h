@@ -0,0 +1,38 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* arena.h - Single block allocator that a plan carves all of its tables and
+* scratch buffers from.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_ARENA_H
+#define BINA_FFT_INTERNAL_ARENA_H
+
+#include <stddef.h>
+
+/* Every carved buffer starts on a cache line */
+#define ARENA_ALIGNMENT (64U)
+
+/* Arenas of at least this size are backed by huge pages when possible */
+#ifndef ARENA_HUGE_PAGE_SIZE
+#define ARENA_HUGE_PAGE_SIZE ((size_t) 2 << 20)
+#endif
+
+struct arena {
+	unsigned char *base;            /* First usable byte */
+	size_t size;                    /* Usable bytes */
+	size_t used;                    /* Bytes carved so far */
+	void *mapping;                  /* Memory to give back */
+	size_t mapping_size;            /* Size of `mapping' if mmap()ed,
+					 * zero if it came from the heap.
+					 */
+};
+
+size_t arena_size(size_t bytes);
+int arena_create(struct arena *arena, size_t size);
+void *arena_carve(struct arena *arena, size_t bytes);
+void arena_release(struct arena *arena);
+
+#endif /* BINA_FFT_INTERNAL_ARENA_H */
@@ -0,0 +1,98 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* complex_kernels.h - Element-wise kernels on interleaved complex arrays,
+* used by the transforms that work in the frequency domain.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_COMPLEX_KERNELS_H
+#define BINA_FFT_INTERNAL_COMPLEX_KERNELS_H
+
+#include <stddef.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+/* All kernels take arrays of interleaved (re, im) doubles, so they work with
+ * either flavour of bina_complex. Products are written out by hand: C99
+ * complex multiplication has to handle infinities and does not vectorize.
+ */
+
+#if defined(__AVX__)
+/* [a0 a1] * [b0 b1] for two complex numbers per register */
+static inline __m256d complex_mul_pd(__m256d a, __m256d b)
+{
+	__m256d b_re = _mm256_movedup_pd(b);
+	__m256d b_im = _mm256_permute_pd(b, 0xf);
+	__m256d a_swap = _mm256_permute_pd(a, 0x5);
+
+#	if defined(__FMA__)
+	return _mm256_fmaddsub_pd(a, b_re, _mm256_mul_pd(a_swap, b_im));
+#	else
+	return _mm256_addsub_pd(_mm256_mul_pd(a, b_re),
+			_mm256_mul_pd(a_swap, b_im));
+#	endif
+}
+#endif
+
+/* dst[i] = a[i] * b[i], dst may alias a or b.
+ *
+ * @dst Destination, n complex numbers.
+ * @a First factor, n complex numbers.
+ * @b Second factor, n complex numbers.
+ * @n Number of complex numbers.
+ */
+static inline void complex_multiply(double *dst, const double *a,
+		const double *b, size_t n)
+{
+	size_t i = 0;
+
+#	if defined(__AVX__)
+	for (; i + 2 <= n; i += 2) {
+		__m256d x = _mm256_loadu_pd(a + 2 * i);
+		__m256d y = _mm256_loadu_pd(b + 2 * i);
+		_mm256_storeu_pd(dst + 2 * i, complex_mul_pd(x, y));
+	}
+#	endif
+
+	for (; i < n; i++) {
+		double re = a[2 * i] * b[2 * i] - a[2 * i + 1] * b[2 * i + 1];
+		double im = a[2 * i] * b[2 * i + 1] + a[2 * i + 1] * b[2 * i];
+		dst[2 * i] = re;
+		dst[2 * i + 1] = im;
+	}
+}
+
+/* acc[i] += a[i] * b[i]
+ *
+ * @acc Accumulator, n complex numbers.
+ * @a First factor, n complex numbers.
+ * @b Second factor, n complex numbers.
+ * @n Number of complex numbers.
+ */
+static inline void complex_multiply_accumulate(double *acc, const double *a,
+		const double *b, size_t n)
+{
+	size_t i = 0;
+
+#	if defined(__AVX__)
+	for (; i + 2 <= n; i += 2) {
+		__m256d x = _mm256_loadu_pd(a + 2 * i);
+		__m256d y = _mm256_loadu_pd(b + 2 * i);
+		__m256d z = _mm256_loadu_pd(acc + 2 * i);
+		_mm256_storeu_pd(acc + 2 * i,
+				_mm256_add_pd(z, complex_mul_pd(x, y)));
+	}
+#	endif
+
+	for (; i < n; i++) {
+		acc[2 * i] += a[2 * i] * b[2 * i] - a[2 * i + 1] * b[2 * i + 1];
+		acc[2 * i + 1] += a[2 * i] * b[2 * i + 1]
+			+ a[2 * i + 1] * b[2 * i];
+	}
+}
+
+#endif /* BINA_FFT_INTERNAL_COMPLEX_KERNELS_H */
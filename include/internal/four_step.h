@@ -0,0 +1,47 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* four_step.h - Tables and plans of the four step algorithm, N = N1 N2,
+* shared by the in-memory and the out-of-core transforms. Both take the
+* input as a matrix of N2 rows of N1 points, transform its columns, rotate
+* them by w_N^(n1 k2), and transform its rows.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_FOUR_STEP_H
+#define BINA_FFT_INTERNAL_FOUR_STEP_H
+
+#include <stddef.h>
+
+#include "binafft.h"
+
+struct four_step_worker {
+	bina_transform column_fft;      /* N2 point transform */
+	bina_transform row_fft;         /* N1 point transform */
+	bina_complex *buffer;           /* Scratch of the caller, or NULL */
+};
+
+struct four_step {
+	size_t fft_length;              /* N */
+	size_t columns;                 /* N1 */
+	size_t rows;                    /* N2 */
+	int lg_columns;                 /* lg N1 */
+	bina_complex *fine;             /* w_N^j, j < N1 */
+	bina_complex *coarse;           /* w_N^(j N1), j < N2 */
+	bina_complex *column_twiddle;   /* Tables shared by all workers */
+	unsigned int *column_perm;
+	bina_complex *row_twiddle;
+	unsigned int *row_perm;
+	int num_workers;                /* One per OpenMP thread */
+	struct four_step_worker *workers;
+};
+
+void four_step_split(size_t fft_length, size_t *columns, size_t *rows);
+int four_step_create(struct four_step *self, size_t fft_length, int flags,
+		size_t worker_points);
+void four_step_rotate(const struct four_step *self, bina_complex *column,
+		size_t n1);
+void four_step_release(struct four_step *self);
+
+#endif /* BINA_FFT_INTERNAL_FOUR_STEP_H */
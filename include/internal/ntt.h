@@ -0,0 +1,60 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* ntt.h - Internal interface of the number-theoretic transform, and the
+* modular arithmetic it runs on. Residues are kept lazily in [0, 2p) between
+* butterflies, which the moduli, below 2^62, leave room for.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_NTT_H
+#define BINA_FFT_INTERNAL_NTT_H
+
+#include <stdint.h>
+
+#include "binafft.h"
+
+/* Number of NTT moduli, see bina_ntt_modulus() */
+#define NTT_MODULI (3)
+
+typedef unsigned __int128 ntt_wide;
+
+/* Shoup's product a w mod p, in [0, 2p), for a fixed w with its companion
+ * w' = floor(w 2^64 / p). Any 64-bit a works.
+ */
+static inline uint64_t ntt_mul_shoup(uint64_t a, uint64_t w,
+		uint64_t w_shoup, uint64_t p)
+{
+	uint64_t q = (uint64_t) (((ntt_wide) a * w_shoup) >> 64);
+
+	return a * w - q * p;
+}
+
+/* Companion of w for ntt_mul_shoup() */
+static inline uint64_t ntt_shoup(uint64_t w, uint64_t p)
+{
+	return (uint64_t) (((ntt_wide) w << 64) / p);
+}
+
+/* a b mod p, for tables made at plan time */
+static inline uint64_t ntt_mul_mod(uint64_t a, uint64_t b, uint64_t p)
+{
+	return (uint64_t) (((ntt_wide) a * b) % p);
+}
+
+/* [0, 2p) to [0, p) */
+static inline uint64_t ntt_reduce(uint64_t a, uint64_t p)
+{
+	return (a >= p) ? a - p : a;
+}
+
+uint64_t ntt_modulus(bina_transform base);
+
+int ntt_forward_on(bina_transform base, uint64_t *data);
+
+int ntt_inverse_on(bina_transform base, uint64_t *data);
+
+void ntt_multiply(bina_transform base, uint64_t *a, const uint64_t *b);
+
+#endif /* BINA_FFT_INTERNAL_NTT_H */
@@ -0,0 +1,22 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* r2r.h - Internal interface of the real-to-real transforms: the DCT-IV
+* kernel, shared with the MDCT, which folds its frames into one.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_R2R_H
+#define BINA_FFT_INTERNAL_R2R_H
+
+#include "binafft.h"
+
+void r2r_dct4_fill_rotation(bina_complex *rotation, bina_complex *shift,
+		int length);
+
+void r2r_dct4_paired(bina_transform half, const bina_complex *rotation,
+		bina_complex shift, bina_complex *work, int length,
+		bina_real *out);
+
+#endif /* BINA_FFT_INTERNAL_R2R_H */
@@ -0,0 +1,73 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* radix2_c2c_fft.h - Internal interface of the radix-2 complex FFT, for code
+* that builds on top of it.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_RADIX2_C2C_FFT_H
+#define BINA_FFT_INTERNAL_RADIX2_C2C_FFT_H
+
+#include <stddef.h>
+
+#include "binafft.h"
+
+int radix2_c2c_fft_tables(int fft_length, int flags, bina_complex **twiddle,
+		size_t *twiddle_count, unsigned int **perm, size_t *perm_count);
+
+void radix2_c2c_fft_permutation(unsigned int *perm, int fft_length);
+
+int radix2_c2c_fft_table_layout(int fft_length, int flags,
+		size_t *twiddle_count, size_t *perm_count);
+
+bina_transform radix2_c2c_fft_create_with_tables(bina_complex *in,
+		bina_complex *out, int fft_length, int flags,
+		const bina_complex *twiddle, const unsigned int *perm);
+
+int radix2_c2c_fft_execute_on(bina_transform base, bina_complex *src,
+		bina_complex *dst);
+
+void radix2_c2c_fft_bit_reverse(bina_transform base, const bina_complex *src,
+		bina_complex *dst);
+
+/* Overrides the length past which the stages go depth first */
+int radix2_c2c_fft_set_cache_length(bina_transform base, int length);
+
+/* Outputs of radix2_c2c_fft_execute_fused() */
+#define RADIX2_C2C_FFT_SPECTRUM (0)
+#define RADIX2_C2C_FFT_POWER (1)
+#define RADIX2_C2C_FFT_LOG_POWER (2)
+
+int radix2_c2c_fft_execute_fused(bina_transform base, const bina_complex *src,
+		const double *window, bina_complex *dst, double *power,
+		int output);
+
+/* Transforms with the input fed and the output taken in blocks, for
+ * callers that convert them on the way, see
+ * radix2_c2c_fft_first_stage_pairs()
+ */
+void radix2_c2c_fft_first_stage_pairs(bina_transform base,
+		const bina_complex *top, const bina_complex *bottom,
+		int first, int count);
+
+int radix2_c2c_fft_later_stages_in_place(bina_transform base);
+
+void radix2_c2c_fft_gather(bina_transform base, int first, int count,
+		bina_complex *dst);
+
+/* Transforms in slices, see radix2_c2c_fft_execute_step() */
+int radix2_c2c_fft_steps(bina_transform base);
+
+int radix2_c2c_fft_step_units(bina_transform base);
+
+int radix2_c2c_fft_execute_step(bina_transform base, const bina_complex *src,
+		bina_complex *dst, int step, int first, int count);
+
+/* Runs butterflies of a single stage between buffers of the caller */
+int radix2_c2c_fft_execute_butterflies(bina_transform base,
+		const bina_complex *in, bina_complex *out, int stage,
+		int first, int count);
+
+#endif /* BINA_FFT_INTERNAL_RADIX2_C2C_FFT_H */
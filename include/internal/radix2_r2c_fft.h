@@ -0,0 +1,33 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* radix2_r2c_fft.h - Internal interface of the real FFT: an n point real
+* transform is an n/2 point complex transform of the samples taken as
+* (even, odd) pairs, plus a pass that splits (or merges) the two halves.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_RADIX2_R2C_FFT_H
+#define BINA_FFT_INTERNAL_RADIX2_R2C_FFT_H
+
+#include "binafft.h"
+
+/* Number of twiddle factors, and of units of the split and merge passes */
+#define RADIX2_R2C_FFT_PAIRS(fft_length) ((fft_length) / 4 + 1)
+
+void radix2_r2c_fft_fill_twiddle(bina_complex *twiddle, int fft_length);
+
+void radix2_r2c_fft_split(bina_complex *spectrum,
+		const bina_complex *twiddle, int fft_length,
+		int first, int count);
+
+void radix2_r2c_fft_merge(const bina_complex *spectrum, bina_complex *dst,
+		const bina_complex *twiddle, int fft_length,
+		int first, int count);
+
+void radix2_r2c_fft_split_power(const bina_complex *spectrum,
+		const bina_complex *twiddle, int fft_length, double weight,
+		double *power);
+
+#endif /* BINA_FFT_INTERNAL_RADIX2_R2C_FFT_H */
@@ -0,0 +1,16 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* window.h - Analysis windows for the spectral estimators.
+*******************************************************************************/
+
+#ifndef BINA_FFT_INTERNAL_WINDOW_H
+#define BINA_FFT_INTERNAL_WINDOW_H
+
+int window_fill(double *window, int length, int type);
+
+double window_bessel_i0(double x);
+
+#endif /* BINA_FFT_INTERNAL_WINDOW_H */
@@ -17,6 +17,9 @@ typedef unsigned char byte_t;
 typedef uintptr_t address_t;
 typedef size_t offset_t;
 
+static void *aligned_alloc_common(size_t alignment, size_t elements,
+		size_t size, int zero);
+
 /* Allocates an aligned segment of memory of `elements' numbers of `size'
  * chunks.
  *
@@ -24,6 +27,24 @@ typedef size_t offset_t;
  * since this stored the original pointer before the returned aligned pointer.
  */
 void *aligned_calloc(size_t alignment, size_t elements, size_t size)
+{
+	return aligned_alloc_common(alignment, elements, size, 1);
+}
+
+/* Same as aligned_calloc(), but leaves the memory uninitialized, for buffers
+ * that are about to be overwritten anyway.
+ */
+void *aligned_malloc(size_t alignment, size_t elements, size_t size)
+{
+	return aligned_alloc_common(alignment, elements, size, 0);
+}
+
+/* Does the work of aligned_calloc() and aligned_malloc().
+ *
+ * @zero Nonzero to clear the memory.
+ */
+static void *aligned_alloc_common(size_t alignment, size_t elements,
+		size_t size, int zero)
 {
 	/* Local variables */
 	pointer_t head = NULL;
@@ -53,7 +74,11 @@ void *aligned_calloc(size_t alignment, size_t elements, size_t size)
 	total_size = size + (2 * alignment) + sizeof(address_t);
 
 	/* allocate the data */
-	head = calloc(total_size, sizeof(byte_t));
+	if (zero) {
+		head = calloc(total_size, sizeof(byte_t));
+	} else {
+		head = malloc(total_size);
+	}
 
 	/* If calloc fails, then return NULL */
 	if (head == NULL) {
@@ -94,6 +119,81 @@ static pointer_t get_aligned_pointer_up(pointer_t ptr, size_t alignment)
 	return (pointer_t) p;
 }
 
+/*
+ * Computes the distance in bytes between the starts of two consecutive rows
+ * of a 2-D array: the row size rounded up to the alignment.
+ *
+ * With ALIGNED_PITCH_AVOID_ALIASING, a pitch that is a multiple of
+ * ALIGNED_ALIASING_PERIOD is padded by one more cache line (or alignment,
+ * whichever is larger). Otherwise walking down a column touches only a
+ * handful of cache sets, e.g. every row of a 4096 byte pitch maps to the
+ * same set, and column passes thrash the cache.
+ *
+ * @alignment Alignment of every row (power of two).
+ * @columns Number of elements in a row.
+ * @element_size Size of an element.
+ * @flags Zero, or ALIGNED_PITCH_AVOID_ALIASING.
+ *
+ * @return Pitch in bytes.
+ */
+size_t aligned_pitch(size_t alignment, size_t columns, size_t element_size,
+		     int flags)
+{
+	size_t pitch = columns * element_size;
+
+	pitch = (pitch + alignment - 1) & ~(alignment - 1);
+
+	if ((flags & ALIGNED_PITCH_AVOID_ALIASING)
+	    && (pitch % ALIGNED_ALIASING_PERIOD) == 0) {
+		pitch += (alignment > ALIGNED_CACHE_LINE) ?
+		    alignment : ALIGNED_CACHE_LINE;
+	}
+
+	return pitch;
+}
+
+/*
+ * Allocates a contiguous two dimentional array, `rows' rows of `columns'
+ * elements each. Row r starts at ((unsigned char *) ptr) + r * (*pitch),
+ * every row is aligned, and only the padding at the end of each row (see
+ * aligned_pitch()) is spent on top of the elements themselves.
+ *
+ * @alignment Alignment of every row (power of two).
+ * @rows Number of rows.
+ * @columns Number of elements in a row.
+ * @element_size Size of an element.
+ * @flags Zero, or ALIGNED_PITCH_AVOID_ALIASING.
+ * @pitch Returns the distance between rows in bytes.
+ *
+ * @return Pointer to the first row, to be freed with aligned_free(), or
+ * NULL on failure.
+ */
+void *aligned_pitched_calloc(size_t alignment, size_t rows, size_t columns,
+			     size_t element_size, int flags, size_t *pitch)
+{
+	size_t row_pitch = 0;
+
+	if ((alignment == 0) || (rows == 0) || (columns == 0)
+	    || (element_size == 0) || (pitch == NULL)) {
+		return NULL;
+	}
+
+	if ((alignment & (alignment - 1)) != 0) {
+		return NULL;
+	}
+
+	row_pitch = aligned_pitch(alignment, columns, element_size, flags);
+
+	/* Guard against overflow of rows * row_pitch */
+	if (rows > SIZE_MAX / row_pitch) {
+		return NULL;
+	}
+
+	*pitch = row_pitch;
+
+	return aligned_calloc(alignment, rows, row_pitch);
+}
+
 /*
  * Allocates a two dimentional array of specific alignment.
  *
@@ -119,10 +219,15 @@ static pointer_t get_aligned_pointer_up(pointer_t ptr, size_t alignment)
  *    |                not need to be aligned by alignment factor.
  *    |
  *    +---> The original pointer that was retrieved by calling malloc
+ *
+ * Every v[c] holds `rows' elements, and consecutive v[c] are one
+ * aligned_pitch() apart, so the padding is at most alignment - 1 bytes per
+ * v[c] plus one alignment in front of v[0][0].
  */
 void *aligned_2d_calloc(size_t alignment, size_t rows, size_t columns,
 			size_t element_size)
 {
+	size_t pitch = 0;
 	size_t bytes_needed_row = 0;
 	size_t bytes_needed_col = 0;
 	size_t bytes_needed_tot = 0;
@@ -147,19 +252,21 @@ void *aligned_2d_calloc(size_t alignment, size_t rows, size_t columns,
 	}
 
 	/***
-	* Calculating total number of bytes needed for a single malloc call
-	* Generally a good idea to allocate twice the alignment extra on both ends
+	* Calculating total number of bytes needed for a single malloc call:
+	* every vector padded up to the alignment, plus one alignment of slack
+	* to align the first one.
 	*/
-	bytes_needed_row = columns * (rows * ((2 * alignment) + element_size));
+	pitch = aligned_pitch(alignment, rows, element_size, 0);
+	bytes_needed_row = (columns * pitch) + alignment;
 
 	/* Calculating the number of bytes needed to store columns */
 	bytes_needed_col = columns * sizeof(pointer_t);
 
 	/* Calculating total bytes (rows + columns + 1 memory spot to store the
-	 * original pointer to free)
+	 * original pointer to free, + alignment of that spot)
 	 */
 	bytes_needed_tot =
-	    bytes_needed_row + bytes_needed_col + sizeof(address_t);
+	    bytes_needed_row + bytes_needed_col + 2 * sizeof(address_t);
 
 	/* Allocating memory */
 	head = (pointer_t) calloc(bytes_needed_tot, sizeof(byte_t));
@@ -180,11 +287,11 @@ void *aligned_2d_calloc(size_t alignment, size_t rows, size_t columns,
 	/* Start tabulating columns */
 	col_ptr = head;
 	row_ptr = head + (columns * sizeof(pointer_t));
+	row_ptr = get_aligned_pointer_up(row_ptr, alignment);
 
 	for (size_t c = 0; c < columns; ++c) {
-		row_ptr = get_aligned_pointer_up(row_ptr, alignment);
 		*((address_t *) col_ptr) = (address_t) row_ptr;
-		row_ptr += (rows * element_size);
+		row_ptr += pitch;
 		col_ptr += sizeof(pointer_t);
 	}
 
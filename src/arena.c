@@ -0,0 +1,177 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* arena.c - Single block allocator that a plan carves all of its tables and
+* scratch buffers from. Large arenas are backed by 2 MB huge pages, which
+* cuts the TLB misses of the long strided butterfly passes.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__linux__) || defined(__unix)
+#include <sys/mman.h>
+#define HAS_MMAP (1)
+#else
+/* no mmap(), arenas always come from the heap */
+#endif
+
+#include "internal/aligned_malloc.h"
+#include "internal/arena.h"
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static int arena_map(struct arena *arena, size_t size);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Returns the number of arena bytes a buffer of `bytes' takes up, callers
+ * add these up to size an arena before creating it.
+ *
+ * @bytes Size of the buffer
+ *
+ * @return `bytes' rounded up to ARENA_ALIGNMENT.
+ */
+size_t arena_size(size_t bytes)
+{
+	return (bytes + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
+
+/* Allocates the backing memory of an arena. The memory is not cleared.
+ *
+ * @arena Arena to set up
+ * @size Number of bytes, as summed up with arena_size()
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int arena_create(struct arena *arena, size_t size)
+{
+	arena->base = NULL;
+	arena->size = size;
+	arena->used = 0;
+	arena->mapping = NULL;
+	arena->mapping_size = 0;
+
+	if (size >= ARENA_HUGE_PAGE_SIZE && arena_map(arena, size) == 0) {
+		return 0;
+	}
+
+	arena->mapping = aligned_malloc(ARENA_ALIGNMENT, size, 1);
+	arena->base = arena->mapping;
+
+	return (arena->base == NULL) ? -1 : 0;
+}
+
+/* Hands out the next buffer of an arena.
+ *
+ * @arena The arena
+ * @bytes Size of the buffer
+ *
+ * @return Pointer aligned to ARENA_ALIGNMENT, or NULL if the arena was sized
+ * too small.
+ */
+void *arena_carve(struct arena *arena, size_t bytes)
+{
+	size_t need = arena_size(bytes);
+	void *ptr = NULL;
+
+	if (arena->size - arena->used < need) {
+		return NULL;
+	}
+
+	ptr = arena->base + arena->used;
+	arena->used += need;
+
+	return ptr;
+}
+
+/* Gives the memory of an arena back. Everything carved from it, including
+ * the structure that holds `arena' itself, is gone afterwards.
+ *
+ * @arena The arena
+ */
+void arena_release(struct arena *arena)
+{
+	void *mapping = arena->mapping;
+	size_t mapping_size = arena->mapping_size;
+
+#	ifdef HAS_MMAP
+	if (mapping_size) {
+		munmap(mapping, mapping_size);
+		return;
+	}
+#	endif
+
+	aligned_free(mapping);
+}
+
+/* Maps an arena onto huge pages. Explicit huge pages (MAP_HUGETLB) are tried
+ * first; they need pages reserved by the administrator, so the fallback is
+ * an ordinary mapping placed on a huge page boundary and marked for
+ * transparent huge pages.
+ *
+ * @arena Arena to set up
+ * @size Number of bytes
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int arena_map(struct arena *arena, size_t size)
+{
+#	ifdef HAS_MMAP
+	const size_t huge = ARENA_HUGE_PAGE_SIZE;
+	size_t length = (size + huge - 1) & ~(huge - 1);
+	unsigned char *p = NULL;
+
+#	ifdef MAP_HUGETLB
+	p = mmap(NULL, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+	if (p != MAP_FAILED) {
+		arena->base = p;
+		arena->mapping = p;
+		arena->mapping_size = length;
+		return 0;
+	}
+#	endif
+
+	/* Map one extra huge page so the start can be moved to a boundary */
+	p = mmap(NULL, length + huge, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (p == MAP_FAILED) {
+		return -1;
+	}
+
+	unsigned char *base = (unsigned char *)
+		(((uintptr_t) p + huge - 1) & ~((uintptr_t) huge - 1));
+	size_t head = base - p;
+	size_t tail = huge - head;
+
+	/* Trim the slack on both ends */
+	if (head) {
+		munmap(p, head);
+	}
+
+	if (tail) {
+		munmap(base + length, tail);
+	}
+
+#	ifdef MADV_HUGEPAGE
+	madvise(base, length, MADV_HUGEPAGE);
+#	endif
+
+	arena->base = base;
+	arena->mapping = base;
+	arena->mapping_size = length;
+
+	return 0;
+#	else
+	return -1;
+#	endif			/* ifdef HAS_MMAP */
+}
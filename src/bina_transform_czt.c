@@ -0,0 +1,264 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_czt.c - Chirp-Z transform on the unit circle, for any number
+* of points at any frequencies f[k] = start + k step (in cycles per sample):
+*
+*   X[k] = sum x[n] exp(-2 pi i n f[k]),  0 <= n < N, 0 <= k < M
+*
+* Bluestein's identity nk = (n^2 + k^2 - (k - n)^2) / 2 turns the sum into
+* a convolution with a chirp, which runs on power of two transforms of
+* L >= N + M - 1 points:
+*
+*   X[k] = c[k] sum (x[n] exp(-2 pi i n start) c[n]) conj(c[k - n])
+*
+* with c[m] = exp(-pi i step m^2).
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/complex_kernels.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct czt {
+	struct bina_transform type;     /* Base class */
+
+	int input_length;               /* N */
+
+	int output_length;              /* M */
+
+	int fft_length;                 /* L, power of two >= N + M - 1 */
+
+	int padded_length;              /* Inputs the forward plan reads */
+
+	bina_complex *in;               /* N samples */
+
+	bina_complex *out;              /* M points */
+
+	bina_complex *pre;              /* exp(-2 pi i n start) c[n], N */
+
+	bina_complex *post;             /* c[k], M */
+
+	bina_complex *response;         /* FFT of conj(c), divided by L */
+
+	bina_complex *work;             /* L points */
+
+	bina_transform forward;         /* L point transforms */
+
+	bina_transform inverse;
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static bina_complex chirp(long double cycles);
+
+static int czt_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a chirp-Z transform class. All chirps, and the transform of the
+ * convolution kernel, are computed here.
+ *
+ * @in: Pointer to input buffer, `input_length' samples
+ * @out: Pointer to output buffer, `output_length' points
+ * @input_length: N, any positive length
+ * @output_length: M, any positive length
+ * @start: Frequency of the first point, in cycles per sample
+ * @step: Spacing of the points, in cycles per sample (1/N for the DFT)
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_czt(bina_complex *in, bina_complex *out,
+		int input_length, int output_length, double start,
+		double step, int flags)
+{
+	struct czt *self = NULL;
+	int n = input_length;
+	int m = output_length;
+	int l = 1;
+	int lg_n = 0;
+
+	if (n <= 0 || m <= 0 || n > (1 << 29) - m) {
+		log_error("Bad input or output length\n");
+		return NULL;
+	}
+
+	while (l < n + m - 1) {
+		l *= 2;
+	}
+
+	while ((1 << lg_n) < n) {
+		lg_n++;
+	}
+
+	if ((self = calloc(1, sizeof(struct czt))) == NULL) {
+		log_error("Allocating CZT instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(czt_exec);
+	self->type.free = &(free_class);
+	self->input_length = n;
+	self->output_length = m;
+	self->fft_length = l;
+	self->padded_length = 1 << lg_n;
+	self->in = in;
+	self->out = out;
+
+	flags &= BINA_FFT_COMPACT_TWIDDLE;
+
+	self->pre = aligned_malloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(bina_complex));
+	self->post = aligned_malloc(BINA_FFT_ALIGNMENT, m,
+			sizeof(bina_complex));
+	self->response = aligned_calloc(BINA_FFT_ALIGNMENT, l,
+			sizeof(bina_complex));
+	self->work = aligned_calloc(BINA_FFT_ALIGNMENT, l,
+			sizeof(bina_complex));
+	/* Only the first N points of the forward transform are nonzero. The
+	 * spectra are only multiplied, so they stay in bit reversed order.
+	 */
+	self->forward = bina_transform_create_radix2_c2c_fft(NULL, NULL, l,
+			flags | BINA_FFT_NONZERO_INPUTS(lg_n)
+			| BINA_FFT_SCRAMBLED);
+	self->inverse = bina_transform_create_radix2_c2c_fft(NULL, NULL, l,
+			flags | BINA_FFT_INVERSE | BINA_FFT_SCRAMBLED);
+
+	if (self->pre == NULL || self->post == NULL || self->response == NULL
+			|| self->work == NULL || self->forward == NULL
+			|| self->inverse == NULL) {
+		log_error("Allocating CZT buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	for (int i = 0; i < n; i++) {
+		self->pre[i] = chirp((long double) start * i
+				+ 0.5L * step * i * (long double) i);
+	}
+
+	for (int k = 0; k < m; k++) {
+		self->post[k] = chirp(0.5L * step * k * (long double) k);
+	}
+
+	/* The kernel is conj(c[j]) for -N < j < M, negative j wrapped
+	 * around. The forward plan is pruned to N inputs, so its transform
+	 * is taken as conj(IFFT(c)) instead, with the scrambled inverse on
+	 * bit reversed c, and put back in the order of the forward plan.
+	 */
+	for (int j = 0; j < m; j++) {
+		self->response[j] = self->post[j] / l;
+	}
+
+	for (int j = 1; j < n; j++) {
+		self->response[l - j] = chirp(0.5L * step * j
+				* (long double) j) / l;
+	}
+
+	radix2_c2c_fft_bit_reverse(self->inverse, self->response, self->work);
+	radix2_c2c_fft_execute_on(self->inverse, self->work, self->work);
+
+	for (int j = 0; j < l; j++) {
+		self->work[j] = conj(self->work[j]);
+	}
+
+	radix2_c2c_fft_bit_reverse(self->inverse, self->work, self->response);
+
+	return self;
+}
+
+/* exp(-2 pi i cycles), with the whole cycles taken off in extended
+ * precision first, as the chirp phases grow with the square of the index.
+ *
+ * @cycles: Phase in cycles
+ *
+ * @return The unit complex number
+ */
+static bina_complex chirp(long double cycles)
+{
+	double t = 2.0 * M_PI * (double) (cycles - floorl(cycles));
+
+	return cos(t) - sin(t) * I;
+}
+
+/* Function to execute a chirp-Z transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int czt_exec(bina_transform base)
+{
+	struct czt *self = (struct czt *) base;
+	double *work = (double *) self->work;
+	int n = self->input_length;
+
+	complex_multiply(work, (const double *) self->in,
+			(const double *) self->pre, n);
+	memset(self->work + n, 0,
+			(self->padded_length - n) * sizeof(bina_complex));
+
+	radix2_c2c_fft_execute_on(self->forward, self->work, self->work);
+	complex_multiply(work, work, (const double *) self->response,
+			self->fft_length);
+	radix2_c2c_fft_execute_on(self->inverse, self->work, self->work);
+
+	complex_multiply((double *) self->out, work,
+			(const double *) self->post, self->output_length);
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct czt *self = (struct czt *) base;
+
+	if (self->forward) {
+		bina_transform_free(self->forward);
+	}
+
+	if (self->inverse) {
+		bina_transform_free(self->inverse);
+	}
+
+	aligned_free(self->pre);
+	aligned_free(self->post);
+	aligned_free(self->response);
+	aligned_free(self->work);
+	free(self);
+
+	return 0;
+}
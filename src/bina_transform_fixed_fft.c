@@ -0,0 +1,299 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_fixed_fft.c - Radix-2 complex FFT on 16-bit fixed-point
+* samples with block floating point: all values of a stage share one
+* exponent. Before every stage the largest magnitude, tracked while the
+* previous stage was written, decides whether the butterflies shift right
+* by 0, 1 or 2 bits so that none of them can overflow; the shifts add up to
+* the block exponent of the output, X = out 2^exponent.
+*
+* Twiddle factors are Q15; products are taken in 32 bits and rounded.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/* A butterfly grows a part by at most 2 sqrt(2): inputs up to these stay
+ * below 2^15 after a shift of 0 or 1 bits, larger ones take 2.
+ */
+#define FIXED_FFT_NO_SHIFT (11584)
+#define FIXED_FFT_ONE_SHIFT (23169)
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct fixed_fft {
+	struct bina_transform type;     /* Base class */
+
+	int fft_length;                 /* n */
+
+	const int16_t *in;              /* n (re, im) pairs */
+
+	int16_t *out;                   /* n (re, im) pairs */
+
+	int16_t *twiddle;               /* Q15 (re, im) pairs, per stage as
+					 * in the complex transform.
+					 */
+
+	unsigned int *perm;             /* Bit-reversal table */
+
+	int16_t *work[2];               /* Ping-pong stage buffers */
+
+	int exponent;                   /* Of the last output */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static int16_t saturate(int32_t x);
+
+static int peak(const int16_t *data, int count);
+
+static int fixed_fft_stage(const int16_t *in, int16_t *out,
+		const int16_t *twiddle, int fft_length, int half, int shift);
+
+static int fixed_fft_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a fixed-point radix-2 FFT class.
+ *
+ * @in: Pointer to input buffer, `fft_length' (re, im) pairs
+ * @out: Pointer to output buffer, `fft_length' (re, im) pairs, may be `in'
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags, BINA_FFT_INVERSE selects the inverse transform
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_fixed_c2c_fft(int16_t *in,
+		int16_t *out, int fft_length, int flags)
+{
+	struct fixed_fft *self = NULL;
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	int16_t *tptr;
+
+	if (!ispowtwo(fft_length)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct fixed_fft))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(fixed_fft_exec);
+	self->type.free = &(free_class);
+	self->fft_length = fft_length;
+	self->in = in;
+	self->out = out;
+
+	self->twiddle = aligned_malloc(BINA_FFT_ALIGNMENT, 2 * fft_length,
+			sizeof(int16_t));
+	self->perm = aligned_malloc(BINA_FFT_ALIGNMENT,
+			(fft_length > 1) ? fft_length / 2 : 1,
+			sizeof(unsigned int));
+	self->work[0] = aligned_malloc(BINA_FFT_ALIGNMENT, 2 * fft_length,
+			sizeof(int16_t));
+	self->work[1] = aligned_malloc(BINA_FFT_ALIGNMENT, 2 * fft_length,
+			sizeof(int16_t));
+
+	if (self->twiddle == NULL || self->perm == NULL
+			|| self->work[0] == NULL || self->work[1] == NULL) {
+		log_error("Allocating fixed-point transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	/* Stage s uses w^(i 2^s) for i < n / 2^(s + 1) */
+	tptr = self->twiddle;
+
+	for (int half = fft_length / 2, stride = 1; half >= 1;
+			half /= 2, stride *= 2) {
+		for (int i = 0; i < half; i++) {
+			double a = 2.0 * M_PI * i * stride / fft_length;
+
+			*tptr++ = (int16_t) lrint(32767.0 * cos(a));
+			*tptr++ = (int16_t) lrint(32767.0 * sign * sin(a));
+		}
+	}
+
+	radix2_c2c_fft_permutation(self->perm, fft_length);
+
+	return self;
+}
+
+/* Returns the block exponent of the last output of a fixed-point FFT: the
+ * transform of the input is out 2^exponent.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return The exponent
+ */
+int bina_fixed_fft_exponent(bina_transform base)
+{
+	return ((struct fixed_fft *) base)->exponent;
+}
+
+/* Clamps to 16 bits, should rounding ever reach 2^15 */
+static int16_t saturate(int32_t x)
+{
+	return (x > INT16_MAX) ? INT16_MAX : (x < INT16_MIN) ? INT16_MIN : x;
+}
+
+/* Largest magnitude of `count' values */
+static int peak(const int16_t *data, int count)
+{
+	int m = 0;
+
+	for (int i = 0; i < count; i++) {
+		int a = abs(data[i]);
+
+		m = (a > m) ? a : m;
+	}
+
+	return m;
+}
+
+/* Runs one DIF stage, (a, b) -> ((a + b), (a - b) w) >> shift, rounded.
+ *
+ * @in: Input, n pairs
+ * @out: Output, n pairs
+ * @twiddle: Q15 twiddle factors of the stage
+ * @fft_length: n
+ * @half: Butterflies per DFT in this stage
+ * @shift: Right shift, 0 to 2
+ *
+ * @return Largest magnitude written
+ */
+static int fixed_fft_stage(const int16_t *in, int16_t *out,
+		const int16_t *twiddle, int fft_length, int half, int shift)
+{
+	int32_t round = (1 << shift) >> 1;
+	int m = 0;
+
+	for (int base = 0; base < fft_length; base += 2 * half) {
+		const int16_t *a = in + 2 * base;
+		const int16_t *b = a + 2 * half;
+		int16_t *top = out + 2 * base;
+		int16_t *bot = top + 2 * half;
+
+		for (int i = 0; i < half; i++) {
+			int32_t wr = twiddle[2 * i];
+			int32_t wi = twiddle[2 * i + 1];
+			int32_t tr = (a[2 * i] + b[2 * i] + round) >> shift;
+			int32_t ti = (a[2 * i + 1] + b[2 * i + 1] + round)
+				>> shift;
+			int32_t dr = (a[2 * i] - b[2 * i] + round) >> shift;
+			int32_t di = (a[2 * i + 1] - b[2 * i + 1] + round)
+				>> shift;
+			int16_t br = saturate((dr * wr - di * wi + (1 << 14))
+					>> 15);
+			int16_t bi = saturate((dr * wi + di * wr + (1 << 14))
+					>> 15);
+
+			top[2 * i] = saturate(tr);
+			top[2 * i + 1] = saturate(ti);
+			bot[2 * i] = br;
+			bot[2 * i + 1] = bi;
+
+			m = (abs(top[2 * i]) > m) ? abs(top[2 * i]) : m;
+			m = (abs(top[2 * i + 1]) > m) ? abs(top[2 * i + 1]) : m;
+			m = (abs(br) > m) ? abs(br) : m;
+			m = (abs(bi) > m) ? abs(bi) : m;
+		}
+	}
+
+	return m;
+}
+
+/* Function to execute a fixed-point FFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int fixed_fft_exec(bina_transform base)
+{
+	struct fixed_fft *self = (struct fixed_fft *) base;
+	int n = self->fft_length;
+	const int16_t *src = self->in;
+	const int16_t *twiddle = self->twiddle;
+	int16_t *dst = self->work[0];
+	int m = peak(src, 2 * n);
+	int stage = 0;
+
+	self->exponent = 0;
+
+	for (int half = n / 2; half >= 1; half /= 2, stage++) {
+		int shift = (m <= FIXED_FFT_NO_SHIFT) ? 0
+			: (m <= FIXED_FFT_ONE_SHIFT) ? 1 : 2;
+
+		dst = self->work[stage & 1];
+		m = fixed_fft_stage(src, dst, twiddle, n, half, shift);
+		self->exponent += shift;
+		twiddle += 2 * half;
+		src = dst;
+	}
+
+	/* Bit-reversed order to natural order */
+	for (int i = 0; i < n / 2; i++) {
+		unsigned int even = self->perm[i];
+		unsigned int odd = even + n / 2;
+
+		self->out[4 * i] = src[2 * even];
+		self->out[4 * i + 1] = src[2 * even + 1];
+		self->out[4 * i + 2] = src[2 * odd];
+		self->out[4 * i + 3] = src[2 * odd + 1];
+	}
+
+	if (n == 1) {
+		self->out[0] = src[0];
+		self->out[1] = src[1];
+	}
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct fixed_fft *self = (struct fixed_fft *) base;
+
+	aligned_free(self->twiddle);
+	aligned_free(self->perm);
+	aligned_free(self->work[0]);
+	aligned_free(self->work[1]);
+	free(self);
+
+	return 0;
+}
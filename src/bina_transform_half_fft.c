@@ -0,0 +1,390 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_half_fft.c - Radix-2 complex FFT on 16-bit floating point
+* storage, IEEE half precision or bfloat16. Samples are widened (with F16C
+* when the compiler targets it) a block at a time into the first stage of
+* the double precision engine, and bins are rounded to nearest even as the
+* permutation gathers them. Arrays at rest take a quarter of the bytes of
+* bina_complex, and no pass of its own widens or narrows the whole array.
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "binafft.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+/* Points widened or rounded at a time, small enough for the stack and L1 */
+#define HALF_FFT_BLOCK (256)
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct half_fft {
+	struct bina_transform type;     /* Base class */
+
+	int fft_length;                 /* n */
+
+	int bfloat16;                   /* Nonzero for bfloat16 storage */
+
+	const uint16_t *in;             /* n (re, im) pairs */
+
+	uint16_t *out;                  /* n (re, im) pairs */
+
+	bina_transform fft;             /* Double precision transform */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static float half_to_float(uint16_t h);
+
+static uint16_t float_to_half(float f);
+
+static float bfloat16_to_float(uint16_t h);
+
+static uint16_t float_to_bfloat16(float f);
+
+static void load(const struct half_fft *self, const uint16_t *src,
+		int count, bina_complex *dst);
+
+static void store(const struct half_fft *self, const bina_complex *src,
+		int count, uint16_t *dst);
+
+static int half_fft_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a radix-2 FFT class on 16-bit floating point storage.
+ *
+ * @in: Pointer to input buffer, `fft_length' (re, im) pairs
+ * @out: Pointer to output buffer, `fft_length' (re, im) pairs, may be `in'
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags, BINA_FFT_BFLOAT16 for bfloat16 instead of half
+ *         precision, BINA_FFT_COMPACT_TWIDDLE and BINA_FFT_INVERSE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_half_c2c_fft(uint16_t *in,
+		uint16_t *out, int fft_length, int flags)
+{
+	struct half_fft *self = NULL;
+
+	if (!ispowtwo(fft_length)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct half_fft))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(half_fft_exec);
+	self->type.free = &(free_class);
+	self->fft_length = fft_length;
+	self->bfloat16 = (flags & BINA_FFT_BFLOAT16) != 0;
+	self->in = in;
+	self->out = out;
+
+	self->fft = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+			fft_length, flags & (BINA_FFT_COMPACT_TWIDDLE
+				| BINA_FFT_INVERSE));
+
+	if (self->fft == NULL) {
+		log_error("Allocating half precision transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* IEEE half precision to single, exactly */
+static float half_to_float(uint16_t h)
+{
+#	if defined(__F16C__)
+	return _cvtsh_ss(h);
+#	else
+	uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+	uint32_t bits;
+	float f;
+
+	if (exponent == 0x1f) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else if (exponent != 0) {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	} else if (mantissa != 0) {
+		/* Subnormal, normalize it */
+		exponent = 113;
+
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			exponent--;
+		}
+
+		bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+	} else {
+		bits = sign;
+	}
+
+	memcpy(&f, &bits, sizeof(f));
+
+	return f;
+#	endif
+}
+
+/* Single to IEEE half precision, rounded to nearest even */
+static uint16_t float_to_half(float f)
+{
+#	if defined(__F16C__)
+	return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#	else
+	uint32_t bits;
+	uint32_t sign;
+	int32_t exponent;
+	uint32_t mantissa;
+
+	memcpy(&bits, &f, sizeof(bits));
+	sign = (bits >> 16) & 0x8000;
+	exponent = (int32_t) ((bits >> 23) & 0xff) - 112;
+	mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff) {
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+	}
+
+	if (exponent >= 0x1f) {
+		return sign | 0x7c00;
+	}
+
+	if (exponent <= 0) {
+		/* Subnormal or zero: shift the implicit bit in, then round */
+		int shift = 14 - exponent;
+		uint32_t m = mantissa | 0x800000;
+		uint32_t half;
+
+		if (shift > 24) {
+			return sign;
+		}
+
+		half = m >> shift;
+		m &= (1U << shift) - 1;
+
+		if (m > (1U << (shift - 1))
+				|| (m == (1U << (shift - 1)) && (half & 1))) {
+			half++;
+		}
+
+		return sign | half;
+	}
+
+	/* Carries out of the mantissa land in the exponent, up to infinity */
+	bits = (exponent << 10) | (mantissa >> 13);
+	mantissa &= 0x1fff;
+
+	if (mantissa > 0x1000 || (mantissa == 0x1000 && (bits & 1))) {
+		bits++;
+	}
+
+	return sign | bits;
+#	endif
+}
+
+/* bfloat16 to single, exactly */
+static float bfloat16_to_float(uint16_t h)
+{
+	uint32_t bits = (uint32_t) h << 16;
+	float f;
+
+	memcpy(&f, &bits, sizeof(f));
+
+	return f;
+}
+
+/* Single to bfloat16, rounded to nearest even, NaNs kept quiet */
+static uint16_t float_to_bfloat16(float f)
+{
+	uint32_t bits;
+
+	memcpy(&bits, &f, sizeof(bits));
+
+	if ((bits & 0x7fffffff) > 0x7f800000) {
+		return (bits >> 16) | 0x40;
+	}
+
+	bits += 0x7fff + ((bits >> 16) & 1);
+
+	return bits >> 16;
+}
+
+/* Widens a block of points.
+ *
+ * @self: The transform
+ * @src: `count' (re, im) pairs
+ * @count: Number of points
+ * @dst: `count' points
+ *
+ * @return None
+ */
+static void load(const struct half_fft *self, const uint16_t *src,
+		int count, bina_complex *dst)
+{
+	double *d = (double *) dst;
+	int i = 0;
+
+	count *= 2;
+
+	if (self->bfloat16) {
+		for (; i < count; i++) {
+			d[i] = bfloat16_to_float(src[i]);
+		}
+
+		return;
+	}
+
+#	if defined(__F16C__) && defined(__AVX__)
+	for (; i + 8 <= count; i += 8) {
+		__m128i h = _mm_loadu_si128((const __m128i *) (src + i));
+		__m256 f = _mm256_cvtph_ps(h);
+
+		_mm256_storeu_pd(d + i,
+				_mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+		_mm256_storeu_pd(d + i + 4,
+				_mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+	}
+#	endif
+
+	for (; i < count; i++) {
+		d[i] = half_to_float(src[i]);
+	}
+}
+
+/* Rounds a block of points.
+ *
+ * @self: The transform
+ * @src: `count' points
+ * @count: Number of points
+ * @dst: `count' (re, im) pairs
+ *
+ * @return None
+ */
+static void store(const struct half_fft *self, const bina_complex *src,
+		int count, uint16_t *dst)
+{
+	const double *s = (const double *) src;
+	int i = 0;
+
+	count *= 2;
+
+	if (self->bfloat16) {
+		for (; i < count; i++) {
+			dst[i] = float_to_bfloat16((float) s[i]);
+		}
+
+		return;
+	}
+
+#	if defined(__F16C__) && defined(__AVX__)
+	for (; i + 8 <= count; i += 8) {
+		__m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i));
+		__m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(s + i + 4));
+		__m256 f = _mm256_insertf128_ps(_mm256_castps128_ps256(lo),
+				hi, 1);
+
+		_mm_storeu_si128((__m128i *) (dst + i),
+				_mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+	}
+#	endif
+
+	for (; i < count; i++) {
+		dst[i] = float_to_half((float) s[i]);
+	}
+}
+
+/* Function to execute a half precision FFT class. Blocks of the two
+ * halves of the input are widened on the stack and fed to the first stage,
+ * and blocks of bins are gathered from the last one and rounded, so only
+ * the stages of the engine touch n points of doubles. Every input is read
+ * before the first output is written, so `in' may be `out'.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int half_fft_exec(bina_transform base)
+{
+	struct half_fft *self = (struct half_fft *) base;
+	int n = self->fft_length;
+	bina_complex top[HALF_FFT_BLOCK];
+	bina_complex bottom[HALF_FFT_BLOCK];
+
+	/* A single point is its own transform */
+	if (n == 1) {
+		load(self, self->in, 1, top);
+		store(self, top, 1, self->out);
+		return 0;
+	}
+
+	for (int first = 0; first < n / 2; first += HALF_FFT_BLOCK) {
+		int count = n / 2 - first;
+
+		count = (count < HALF_FFT_BLOCK) ? count : HALF_FFT_BLOCK;
+		load(self, self->in + 2 * first, count, top);
+		load(self, self->in + 2 * (first + n / 2), count, bottom);
+		radix2_c2c_fft_first_stage_pairs(self->fft, top, bottom,
+				first, count);
+	}
+
+	if (radix2_c2c_fft_later_stages_in_place(self->fft) != 0) {
+		return -1;
+	}
+
+	for (int first = 0; first < n; first += HALF_FFT_BLOCK) {
+		int count = n - first;
+
+		count = (count < HALF_FFT_BLOCK) ? count : HALF_FFT_BLOCK;
+		radix2_c2c_fft_gather(self->fft, first, count, top);
+		store(self, top, count, self->out + 2 * first);
+	}
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct half_fft *self = (struct half_fft *) base;
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	free(self);
+
+	return 0;
+}
@@ -0,0 +1,474 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_ntt.c - Number-theoretic transform: the DFT over the
+* integers modulo a prime p = c 2^k + 1, with a root of unity of order n
+* in place of exp(-2 pi i / n). Results are exact, which makes it the
+* transform for big integer and exact polynomial products.
+*
+* The stages are the radix-2 DIF stages of the complex transform, with the
+* same per-stage twiddle layout and bit-reversal table. Twiddle products use
+* Shoup's precomputed quotients, pointwise products Montgomery's reduction.
+* Convolutions skip the permutation: the forward DIF leaves the spectrum in
+* bit-reversed order, and the inverse, run as DIT stages, takes it from
+* there.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/ntt.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Moduli c 2^k + 1 below 2^62, with a primitive root, largest first */
+static const struct {
+	uint64_t modulus;
+	uint64_t root;
+	int lg_order;                   /* k, lg of the largest length */
+} moduli[NTT_MODULI] = {
+	{ 4179340454199820289ULL, 3, 57 },      /* 29 2^57 + 1 */
+	{ 2485986994308513793ULL, 5, 55 },      /* 69 2^55 + 1 */
+	{ 2053641430080946177ULL, 7, 55 },      /* 57 2^55 + 1 */
+};
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct ntt {
+	struct bina_transform type;     /* Base class */
+
+	int length;                     /* n */
+
+	int inverse;                    /* Nonzero for the inverse */
+
+	uint64_t *in;                   /* n residues */
+
+	uint64_t *out;                  /* n residues */
+
+	uint64_t modulus;               /* p */
+
+	uint64_t montgomery;            /* -1/p mod 2^64 */
+
+	uint64_t scale;                 /* 2^128 / n mod p, see
+					 * ntt_multiply().
+					 */
+
+	uint64_t *twiddle;              /* Per stage w^(i 2^s), as in the
+					 * complex transform, n - 1 entries.
+					 */
+
+	uint64_t *twiddle_shoup;        /* Their Shoup companions */
+
+	uint64_t *inverse_twiddle;      /* Same for 1/w */
+
+	uint64_t *inverse_shoup;
+
+	unsigned int *perm;             /* Bit-reversal table */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t p);
+
+static void fill_twiddle(uint64_t *twiddle, uint64_t *twiddle_shoup,
+		uint64_t root, uint64_t p, int length);
+
+static void dif_stages(const struct ntt *self, uint64_t *data);
+
+static void dit_stages(const struct ntt *self, uint64_t *data);
+
+static void bit_reverse(const struct ntt *self, uint64_t *data);
+
+static int ntt_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Returns NTT modulus `prime' (0, 1 or 2), or 0 if there is no such modulus.
+ * All are below 2^62 and allow lengths up to 2^55.
+ */
+uint64_t bina_ntt_modulus(int prime)
+{
+	if (prime < 0 || prime >= NTT_MODULI) {
+		return 0;
+	}
+
+	return moduli[prime].modulus;
+}
+
+/* Allocates a number-theoretic transform class.
+ *
+ * @in: Pointer to input buffer, `length' residues below the modulus
+ * @out: Pointer to output buffer, `length' residues (may be `in')
+ * @length: Length of the problem (MUST be power of two)
+ * @prime: Modulus, 0 to 2, see bina_ntt_modulus()
+ * @flags: Extra flags, BINA_FFT_INVERSE selects the inverse transform
+ *         (without the 1/n scaling)
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_ntt(uint64_t *in, uint64_t *out,
+		int length, int prime, int flags)
+{
+	struct ntt *self = NULL;
+	uint64_t p;
+	uint64_t root;
+	uint64_t r;
+
+	if (!ispowtwo(length)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if (prime < 0 || prime >= NTT_MODULI) {
+		log_error("Unknown NTT modulus %d\n", prime);
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct ntt))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	p = moduli[prime].modulus;
+
+	self->type.execute = &(ntt_exec);
+	self->type.free = &(free_class);
+	self->length = length;
+	self->inverse = (flags & BINA_FFT_INVERSE) != 0;
+	self->in = in;
+	self->out = out;
+	self->modulus = p;
+
+	self->twiddle = aligned_malloc(BINA_FFT_ALIGNMENT, length,
+			sizeof(uint64_t));
+	self->twiddle_shoup = aligned_malloc(BINA_FFT_ALIGNMENT, length,
+			sizeof(uint64_t));
+	self->inverse_twiddle = aligned_malloc(BINA_FFT_ALIGNMENT, length,
+			sizeof(uint64_t));
+	self->inverse_shoup = aligned_malloc(BINA_FFT_ALIGNMENT, length,
+			sizeof(uint64_t));
+	self->perm = aligned_malloc(BINA_FFT_ALIGNMENT,
+			(length > 1) ? length / 2 : 1, sizeof(unsigned int));
+
+	if (self->twiddle == NULL || self->twiddle_shoup == NULL
+			|| self->inverse_twiddle == NULL
+			|| self->inverse_shoup == NULL || self->perm == NULL) {
+		log_error("Allocating twiddle factor and permutation buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	/* Newton's iteration doubles the correct low bits of 1/p */
+	self->montgomery = p;
+
+	for (int i = 0; i < 5; i++) {
+		self->montgomery *= 2 - p * self->montgomery;
+	}
+
+	self->montgomery = -self->montgomery;
+
+	r = (uint64_t) ((((ntt_wide) 1) << 64) % p);
+	self->scale = ntt_mul_mod(ntt_mul_mod(r, r, p),
+			pow_mod(length, p - 2, p), p);
+
+	root = pow_mod(moduli[prime].root, (p - 1) / length, p);
+
+	fill_twiddle(self->twiddle, self->twiddle_shoup, root, p, length);
+	fill_twiddle(self->inverse_twiddle, self->inverse_shoup,
+			pow_mod(root, p - 2, p), p, length);
+	radix2_c2c_fft_permutation(self->perm, length);
+
+	return self;
+}
+
+/* Returns the modulus of a transform */
+uint64_t ntt_modulus(bina_transform base)
+{
+	return ((struct ntt *) base)->modulus;
+}
+
+/* Runs the forward DIF stages in place, leaving the transform in
+ * bit-reversed order with residues in [0, 2p).
+ *
+ * @base: Pointer to instance of transform object.
+ * @data: n residues below 2p
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int ntt_forward_on(bina_transform base, uint64_t *data)
+{
+	dif_stages((struct ntt *) base, data);
+
+	return 0;
+}
+
+/* Runs the inverse DIT stages in place, from bit-reversed order to natural
+ * order, without the 1/n scaling. Residues stay in [0, 2p).
+ *
+ * @base: Pointer to instance of transform object.
+ * @data: n residues below 2p
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int ntt_inverse_on(bina_transform base, uint64_t *data)
+{
+	dit_stages((struct ntt *) base, data);
+
+	return 0;
+}
+
+/* Pointwise product of two transforms, divided by n so that the inverse
+ * transform of the product is the cyclic convolution. Two Montgomery
+ * products, the second by 2^128 / n, leave a b / n.
+ *
+ * @base: Pointer to instance of transform object.
+ * @a: n residues below 2p, replaced by the product
+ * @b: n residues below 2p
+ *
+ * @return None
+ */
+void ntt_multiply(bina_transform base, uint64_t *a, const uint64_t *b)
+{
+	const struct ntt *self = (struct ntt *) base;
+	uint64_t p = self->modulus;
+	uint64_t m = self->montgomery;
+	uint64_t c = self->scale;
+
+	for (int i = 0; i < self->length; i++) {
+		ntt_wide t = (ntt_wide) a[i] * b[i];
+		uint64_t q = (uint64_t) t * m;
+		uint64_t ab = (uint64_t) ((t + (ntt_wide) q * p) >> 64);
+
+		t = (ntt_wide) ab * c;
+		q = (uint64_t) t * m;
+		a[i] = (uint64_t) ((t + (ntt_wide) q * p) >> 64);
+	}
+}
+
+/* Modular power by squaring */
+static uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t p)
+{
+	uint64_t result = 1;
+
+	base %= p;
+
+	while (exponent) {
+		if (exponent & 1) {
+			result = ntt_mul_mod(result, base, p);
+		}
+
+		base = ntt_mul_mod(base, base, p);
+		exponent >>= 1;
+	}
+
+	return result;
+}
+
+/* Fills the per stage twiddle factors, laid out as in the complex
+ * transform: the n/2 powers of the root for the first stage, then every
+ * other one of them for the next, and so on.
+ *
+ * @twiddle: Destination, n entries (the last unused)
+ * @twiddle_shoup: Destination of the Shoup companions
+ * @root: Root of unity of order n
+ * @p: Modulus
+ * @length: n
+ *
+ * @return None
+ */
+static void fill_twiddle(uint64_t *twiddle, uint64_t *twiddle_shoup,
+		uint64_t root, uint64_t p, int length)
+{
+	uint64_t w = 1;
+	int k = length / 2;
+
+	for (int i = 0; i < length / 2; i++) {
+		twiddle[i] = w;
+		w = ntt_mul_mod(w, root, p);
+	}
+
+	for (int tlen = length / 4, skip = 2; tlen > 0; tlen /= 2, skip *= 2) {
+		for (int i = 0; i < tlen; i++) {
+			twiddle[k++] = twiddle[i * skip];
+		}
+	}
+
+	twiddle[length - 1] = 0;
+
+	for (int i = 0; i < length; i++) {
+		twiddle_shoup[i] = ntt_shoup(twiddle[i], p);
+	}
+}
+
+/* DIF stages, (x, y) -> (x + y, (x - y) w), with lazy reduction: every
+ * residue stays in [0, 2p).
+ *
+ * @self: The transform
+ * @data: n residues
+ *
+ * @return None
+ */
+static void dif_stages(const struct ntt *self, uint64_t *data)
+{
+	const uint64_t *tw = self->twiddle;
+	const uint64_t *ts = self->twiddle_shoup;
+	uint64_t p = self->modulus;
+	uint64_t p2 = 2 * p;
+	int n = self->length;
+
+	for (int half = n / 2; half >= 1; half /= 2) {
+		for (int base = 0; base < n; base += 2 * half) {
+			uint64_t *top = data + base;
+			uint64_t *bot = top + half;
+
+			for (int i = 0; i < half; i++) {
+				uint64_t x = top[i];
+				uint64_t y = bot[i];
+				uint64_t s = x + y;
+
+				top[i] = (s >= p2) ? s - p2 : s;
+				bot[i] = ntt_mul_shoup(x - y + p2, tw[i],
+						ts[i], p);
+			}
+		}
+
+		tw += half;
+		ts += half;
+	}
+}
+
+/* DIT stages undoing dif_stages() with the inverse twiddles, up to a
+ * factor of n: (x, y) -> (x + y/w, x - y/w).
+ *
+ * @self: The transform
+ * @data: n residues, bit-reversed
+ *
+ * @return None
+ */
+static void dit_stages(const struct ntt *self, uint64_t *data)
+{
+	uint64_t p = self->modulus;
+	uint64_t p2 = 2 * p;
+	int n = self->length;
+
+	for (int half = 1; half < n; half *= 2) {
+		/* Stages with `half' butterflies per DFT start at n - 2 half */
+		const uint64_t *tw = self->inverse_twiddle + n - 2 * half;
+		const uint64_t *ts = self->inverse_shoup + n - 2 * half;
+
+		for (int base = 0; base < n; base += 2 * half) {
+			uint64_t *top = data + base;
+			uint64_t *bot = top + half;
+
+			for (int i = 0; i < half; i++) {
+				uint64_t x = top[i];
+				uint64_t t = ntt_mul_shoup(bot[i], tw[i],
+						ts[i], p);
+				uint64_t s = x + t;
+				uint64_t d = x - t + p2;
+
+				top[i] = (s >= p2) ? s - p2 : s;
+				bot[i] = (d >= p2) ? d - p2 : d;
+			}
+		}
+	}
+}
+
+/* Swaps every index with its bit reversal, in place.
+ *
+ * @self: The transform
+ * @data: n residues
+ *
+ * @return None
+ */
+static void bit_reverse(const struct ntt *self, uint64_t *data)
+{
+	unsigned int half = self->length / 2;
+
+	for (unsigned int i = 0; i < half; i++) {
+		unsigned int even = self->perm[i];
+		unsigned int odd = even + half;
+		uint64_t t;
+
+		if (2 * i < even) {
+			t = data[2 * i];
+			data[2 * i] = data[even];
+			data[even] = t;
+		}
+
+		if (2 * i + 1 < odd) {
+			t = data[2 * i + 1];
+			data[2 * i + 1] = data[odd];
+			data[odd] = t;
+		}
+	}
+}
+
+/* Function to execute a number-theoretic transform class. The output is
+ * in natural order, with residues in [0, p).
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int ntt_exec(bina_transform base)
+{
+	struct ntt *self = (struct ntt *) base;
+	uint64_t *data = self->out;
+
+	if (self->in != self->out) {
+		memcpy(data, self->in, self->length * sizeof(uint64_t));
+	}
+
+	if (self->inverse) {
+		bit_reverse(self, data);
+		dit_stages(self, data);
+	} else {
+		dif_stages(self, data);
+		bit_reverse(self, data);
+	}
+
+	for (int i = 0; i < self->length; i++) {
+		data[i] = ntt_reduce(data[i], self->modulus);
+	}
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct ntt *self = (struct ntt *) base;
+
+	aligned_free(self->twiddle);
+	aligned_free(self->twiddle_shoup);
+	aligned_free(self->inverse_twiddle);
+	aligned_free(self->inverse_shoup);
+	aligned_free(self->perm);
+	free(self);
+
+	return 0;
+}
@@ -0,0 +1,442 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_pruned_dft.c - DFT of a few selected bins. A handful of
+* bins is cheapest with a bank of Goertzel filters, O(N) per bin; more of
+* them with an output-pruned radix-2 FFT, which only runs the butterflies
+* that feed the selected bins, O(N lg K) for K bins. The plan picks the
+* cheaper of the two when it is created.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/* Goertzel filters run side by side in registers, a block at a time */
+#ifndef BINA_PRUNED_DFT_GOERTZEL_BLOCK
+#define BINA_PRUNED_DFT_GOERTZEL_BLOCK (8)
+#endif
+
+/* Cost of one step of a block of Goertzel filters (per sample), in
+ * butterflies. A step is bound by the latency of the recursion rather than
+ * by the number of filters in the block.
+ */
+#ifndef BINA_PRUNED_DFT_GOERTZEL_COST
+#define BINA_PRUNED_DFT_GOERTZEL_COST (1.4)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct pruned_dft {
+	struct bina_transform type;     /* Base class */
+
+	int fft_length;                 /* N */
+
+	int num_bins;                   /* K */
+
+	bina_complex *in;               /* N samples */
+
+	bina_complex *out;              /* K selected bins */
+
+	int goertzel;                   /* Nonzero for the filter bank */
+
+	/* Goertzel filter bank, one filter per bin */
+
+	double *coefficient;            /* 2 cos(2 pi k / N) */
+
+	bina_complex *rotation;         /* exp(-/+ 2 pi i k / N) */
+
+	/* Output-pruned FFT */
+
+	bina_transform fft;             /* N point plan, for its tables */
+
+	int *position;                  /* Bit reversed index of each bin */
+
+	int *ranges;                    /* (first, count) butterfly ranges */
+
+	int *stage_ranges;              /* Offset of the ranges of each stage,
+					 * lg(N) + 1 entries.
+					 */
+
+	bina_complex *buffer[2];        /* Ping-pong buffers, N entries */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static long prune(int fft_length, const int *position, int num_bins,
+		int *ranges, int *stage_ranges);
+
+static int pruned_dft_exec(bina_transform);
+
+static void goertzel_exec(struct pruned_dft *self);
+
+static void pruned_fft_exec(struct pruned_dft *self);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a transform that computes selected bins of a complex DFT.
+ *
+ * @in: Pointer to input buffer, `fft_length' samples
+ * @out: Pointer to output buffer, `num_bins' bins in the order of `bins'
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @bins: Bins to compute, in [0, fft_length)
+ * @num_bins: Number of bins
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE and BINA_FFT_INVERSE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_pruned_dft(bina_complex *in,
+		bina_complex *out, int fft_length, const int *bins,
+		int num_bins, int flags)
+{
+	struct pruned_dft *self = NULL;
+	int n = fft_length;
+	int radix = 0;
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	long butterflies = 0;
+	int num_ranges = 0;
+	int blocks = 0;
+
+	if (!ispowtwo(n) || bins == NULL || num_bins <= 0) {
+		log_error("Bad length or bins\n");
+		return NULL;
+	}
+
+	for (int j = 0; j < num_bins; j++) {
+		if (bins[j] < 0 || bins[j] >= n) {
+			log_error("Bin %d out of range\n", bins[j]);
+			return NULL;
+		}
+	}
+
+	if ((self = calloc(1, sizeof(struct pruned_dft))) == NULL) {
+		log_error("Allocating pruned DFT instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(pruned_dft_exec);
+	self->type.free = &(free_class);
+	self->fft_length = n;
+	self->num_bins = num_bins;
+	self->in = in;
+	self->out = out;
+	radix = ilog2(n);
+
+	self->position = calloc(num_bins, sizeof(int));
+	self->stage_ranges = calloc(radix + 1, sizeof(int));
+
+	if (self->position == NULL || self->stage_ranges == NULL) {
+		log_error("Allocating pruned DFT tables\n");
+		free_class(self);
+		return NULL;
+	}
+
+	/* DIF leaves bin k at the lg(N) bit reversal of k */
+	for (int j = 0; j < num_bins; j++) {
+		self->position[j] = (radix > 0)
+			? (int) (revbin(bins[j]) >> (32 - radix)) : 0;
+	}
+
+	butterflies = prune(n, self->position, num_bins, NULL,
+			self->stage_ranges);
+
+	if (butterflies < 0) {
+		log_error("Allocating pruned DFT tables\n");
+		free_class(self);
+		return NULL;
+	}
+
+	num_ranges = self->stage_ranges[radix];
+	blocks = (num_bins + BINA_PRUNED_DFT_GOERTZEL_BLOCK - 1)
+		/ BINA_PRUNED_DFT_GOERTZEL_BLOCK;
+	self->goertzel = (n == 1 || (double) blocks * n
+			* BINA_PRUNED_DFT_GOERTZEL_COST < butterflies);
+
+	if (self->goertzel) {
+		self->coefficient = aligned_malloc(BINA_FFT_ALIGNMENT,
+				num_bins, sizeof(double));
+		self->rotation = aligned_malloc(BINA_FFT_ALIGNMENT, num_bins,
+				sizeof(bina_complex));
+
+		if (self->coefficient == NULL || self->rotation == NULL) {
+			log_error("Allocating Goertzel filter bank\n");
+			free_class(self);
+			return NULL;
+		}
+
+		/* X[k] = exp(i w) s[N-1] - s[N-2], w = -/+ 2 pi k / N */
+		for (int j = 0; j < num_bins; j++) {
+			double w = 2.0 * M_PI * bins[j] / n;
+
+			self->coefficient[j] = 2.0 * cos(w);
+			self->rotation[j] = cos(w) - sign * sin(w) * I;
+		}
+
+		return self;
+	}
+
+	self->fft = bina_transform_create_radix2_c2c_fft(NULL, NULL, n,
+			flags & (BINA_FFT_COMPACT_TWIDDLE | BINA_FFT_INVERSE));
+	self->ranges = calloc(2 * num_ranges, sizeof(int));
+	self->buffer[0] = aligned_calloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(bina_complex));
+	self->buffer[1] = aligned_calloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(bina_complex));
+
+	if (self->fft == NULL || self->ranges == NULL
+			|| self->buffer[0] == NULL || self->buffer[1] == NULL
+			|| prune(n, self->position, num_bins, self->ranges,
+				self->stage_ranges) < 0) {
+		log_error("Allocating pruned FFT\n");
+		free_class(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Works out which butterflies of a radix-2 DIF FFT feed the selected
+ * outputs. Going back from the last stage, a butterfly is needed if either
+ * of its outputs is, and then both of its inputs are. The needed
+ * butterflies of each stage are stored as (first, count) ranges.
+ *
+ * @fft_length: N
+ * @position: Bit reversed index of each selected output
+ * @num_bins: Number of selected outputs
+ * @ranges: Destination of the ranges, or NULL to only count them
+ * @stage_ranges: Offset of the first range of each stage (in ranges), and
+ *                the total number of ranges in entry lg(N)
+ *
+ * @return Number of needed butterflies, or -1 on failure.
+ */
+static long prune(int fft_length, const int *position, int num_bins,
+		int *ranges, int *stage_ranges)
+{
+	int radix = ilog2(fft_length);
+	unsigned char *need = calloc(fft_length, 1);
+	unsigned char *need_in = calloc(fft_length, 1);
+	int *count = calloc(radix + 1, sizeof(int));
+	long butterflies = 0;
+
+	if (need == NULL || need_in == NULL || count == NULL) {
+		free(need);
+		free(need_in);
+		free(count);
+		return -1;
+	}
+
+	for (int j = 0; j < num_bins; j++) {
+		need[position[j]] = 1;
+	}
+
+	for (int stage = radix - 1; stage >= 0; stage--) {
+		int half = fft_length >> (stage + 1);
+		int *r = ranges ? ranges + 2 * stage_ranges[stage] : NULL;
+		int open = 0;
+
+		memset(need_in, 0, fft_length);
+
+		for (int b = 0; b < fft_length / 2; b++) {
+			int top = (b / half) * 2 * half + b % half;
+			int bot = top + half;
+
+			if (!need[top] && !need[bot]) {
+				open = 0;
+				continue;
+			}
+
+			need_in[top] = 1;
+			need_in[bot] = 1;
+			butterflies++;
+
+			if (open) {
+				if (r) {
+					r[-1]++;
+				}
+
+				continue;
+			}
+
+			open = 1;
+			count[stage]++;
+
+			if (r) {
+				*r++ = b;
+				*r++ = 1;
+			}
+		}
+
+		memcpy(need, need_in, fft_length);
+	}
+
+	/* Ranges are laid out stage by stage */
+	if (ranges == NULL) {
+		stage_ranges[0] = 0;
+
+		for (int stage = 0; stage < radix; stage++) {
+			stage_ranges[stage + 1] = stage_ranges[stage]
+				+ count[stage];
+		}
+	}
+
+	free(need);
+	free(need_in);
+	free(count);
+
+	return butterflies;
+}
+
+/* Function to execute a pruned DFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int pruned_dft_exec(bina_transform base)
+{
+	struct pruned_dft *self = (struct pruned_dft *) base;
+
+	if (self->goertzel) {
+		goertzel_exec(self);
+	} else {
+		pruned_fft_exec(self);
+	}
+
+	return 0;
+}
+
+/* Runs every Goertzel filter over the input,
+ *
+ *   s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+ *
+ * A block of filters is kept in registers and stepped together, so the
+ * latency of one recursion hides behind the others and the block
+ * vectorizes. Unused lanes of the last block run a harmless zero filter.
+ *
+ * @self: Transform instance
+ *
+ * @return None
+ */
+static void goertzel_exec(struct pruned_dft *self)
+{
+	enum { B = BINA_PRUNED_DFT_GOERTZEL_BLOCK };
+	int n = self->fft_length;
+	const double *x = (const double *) self->in;
+
+	for (int first = 0; first < self->num_bins; first += B) {
+		int count = self->num_bins - first;
+		double c[B] = { 0 };
+		double s1r[B] = { 0 }, s1i[B] = { 0 };
+		double s2r[B] = { 0 }, s2i[B] = { 0 };
+
+		if (count > B) {
+			count = B;
+		}
+
+		for (int j = 0; j < count; j++) {
+			c[j] = self->coefficient[first + j];
+		}
+
+		for (int t = 0; t < n; t++) {
+			double xr = x[2 * t];
+			double xi = x[2 * t + 1];
+
+			for (int j = 0; j < B; j++) {
+				double re = xr + c[j] * s1r[j] - s2r[j];
+				double im = xi + c[j] * s1i[j] - s2i[j];
+
+				s2r[j] = s1r[j];
+				s2i[j] = s1i[j];
+				s1r[j] = re;
+				s1i[j] = im;
+			}
+		}
+
+		for (int j = 0; j < count; j++) {
+			self->out[first + j] = self->rotation[first + j]
+				* (s1r[j] + s1i[j] * I)
+				- (s2r[j] + s2i[j] * I);
+		}
+	}
+}
+
+/* Runs the needed butterflies of each stage, ping-ponging between the
+ * buffers of the plan, and gathers the selected bins.
+ *
+ * @self: Transform instance
+ *
+ * @return None
+ */
+static void pruned_fft_exec(struct pruned_dft *self)
+{
+	int radix = ilog2(self->fft_length);
+	const bina_complex *in = self->in;
+	bina_complex *out = self->buffer[0];
+
+	for (int stage = 0; stage < radix; stage++) {
+		for (int r = self->stage_ranges[stage];
+				r < self->stage_ranges[stage + 1]; r++) {
+			radix2_c2c_fft_execute_butterflies(self->fft, in, out,
+					stage, self->ranges[2 * r],
+					self->ranges[2 * r + 1]);
+		}
+
+		in = out;
+		out = self->buffer[(stage + 1) % 2];
+	}
+
+	for (int j = 0; j < self->num_bins; j++) {
+		self->out[j] = in[self->position[j]];
+	}
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct pruned_dft *self = (struct pruned_dft *) base;
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	aligned_free(self->coefficient);
+	aligned_free(self->rotation);
+	aligned_free(self->buffer[0]);
+	aligned_free(self->buffer[1]);
+	free(self->position);
+	free(self->ranges);
+	free(self->stage_ranges);
+	free(self);
+
+	return 0;
+}
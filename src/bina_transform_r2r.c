@@ -0,0 +1,444 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_r2r.c - Real-to-real transforms (DCT-I to DCT-IV, DST-II and
+* DST-III), each from one half length complex transform plus a rotation
+* pass. With N the (power of two) transform length:
+*
+*   DCT-I    X[k] = (x[0] + (-1)^k x[N]) / 2 + sum x[n] cos(pi n k / N),
+*            N + 1 points, 0 < n < N
+*   DCT-II   X[k] = sum x[n] cos(pi (2n + 1) k / 2N)
+*   DCT-III  X[k] = x[0] / 2 + sum x[n] cos(pi n (2k + 1) / 2N), n > 0
+*   DCT-IV   X[k] = sum x[n] cos(pi (2n + 1) (2k + 1) / 4N)
+*   DST-II   X[k] = sum x[n] sin(pi (2n + 1) (k + 1) / 2N)
+*   DST-III  X[k] = (-1)^k x[N-1] / 2 + sum x[n] sin(pi (n + 1) (2k + 1) / 2N),
+*            n < N - 1
+*
+* DCT-II is Makhoul's: the even samples in order followed by the odd ones
+* reversed go through the real FFT, and X[k] = Re(exp(-i pi k / 2N) V[k]).
+* DCT-III undoes it. The DSTs are the DCTs of the signal with every other
+* sample negated, read backwards. DCT-I folds its N + 1 points into N for
+* the real FFT, and DCT-IV pairs x[2n] with x[N-1-2n] as one complex
+* point of an N/2 point transform.
+*
+* No transform is normalized: DCT-III undoes DCT-II, DST-III undoes DST-II,
+* and DCT-I and DCT-IV undo themselves, all times N/2.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/radix2_r2c_fft.h"
+#include "internal/r2r.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct r2r {
+	struct bina_transform type;     /* Base class */
+
+	int kind;                       /* BINA_DCT_I ... BINA_DST_III */
+
+	int length;                     /* N, power of two */
+
+	const bina_real *in;            /* N samples, N + 1 for DCT-I */
+
+	bina_real *out;                 /* Same number of points */
+
+	bina_transform half;            /* N/2 point complex transform */
+
+	bina_complex *twiddle;          /* Real FFT split and merge factors */
+
+	bina_complex *rotation;         /* N/2 + 1 rotations, see
+					 * fill_rotation().
+					 */
+
+	bina_complex shift;             /* exp(-i pi / 4N), for DCT-IV */
+
+	bina_complex *spectrum;         /* N/2 + 1 bins */
+
+	bina_complex *work;             /* N/2 points */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void fill_rotation(struct r2r *self);
+
+static int dct1_exec(bina_transform);
+
+static int dct2_exec(bina_transform);
+
+static int dct3_exec(bina_transform);
+
+static int dct4_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a real-to-real transform class. The input and output buffers
+ * may be the same.
+ *
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer
+ * @length: Number of points, a power of two N >= 2, or N + 1 for DCT-I
+ * @kind: BINA_DCT_I, BINA_DCT_II, BINA_DCT_III, BINA_DCT_IV, BINA_DST_II
+ *        or BINA_DST_III
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_r2r(bina_real *in, bina_real *out,
+		int length, int kind, int flags)
+{
+	struct r2r *self = NULL;
+	int n = (kind == BINA_DCT_I) ? length - 1 : length;
+	int inverse = (kind == BINA_DCT_III || kind == BINA_DST_III);
+
+	if (kind < BINA_DCT_I || kind > BINA_DST_III) {
+		log_error("Unknown real-to-real transform\n");
+		return NULL;
+	}
+
+	if (n < 2 || !ispowtwo(n)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct r2r))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	switch (kind) {
+	case BINA_DCT_I:
+		self->type.execute = &(dct1_exec);
+		break;
+	case BINA_DCT_IV:
+		self->type.execute = &(dct4_exec);
+		break;
+	default:
+		self->type.execute = inverse ? &(dct3_exec) : &(dct2_exec);
+		break;
+	}
+
+	self->type.free = &(free_class);
+	self->kind = kind;
+	self->length = n;
+	self->in = in;
+	self->out = out;
+
+	flags &= BINA_FFT_COMPACT_TWIDDLE;
+
+	self->half = bina_transform_create_radix2_c2c_fft(NULL, NULL, n / 2,
+			flags | (inverse ? BINA_FFT_INVERSE : 0));
+	self->twiddle = aligned_malloc(BINA_FFT_ALIGNMENT,
+			RADIX2_R2C_FFT_PAIRS(n), sizeof(bina_complex));
+	self->rotation = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2 + 1,
+			sizeof(bina_complex));
+	self->spectrum = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2 + 1,
+			sizeof(bina_complex));
+	self->work = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2,
+			sizeof(bina_complex));
+
+	if (self->half == NULL || self->twiddle == NULL
+			|| self->rotation == NULL || self->spectrum == NULL
+			|| self->work == NULL) {
+		log_error("Allocating real-to-real transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	radix2_r2c_fft_fill_twiddle(self->twiddle, n);
+	fill_rotation(self);
+
+	return self;
+}
+
+/* Fills the rotations of the kind, for 0 <= j <= N/2:
+ *
+ *   DCT-I             exp(i pi j / N)
+ *   DCT-II to DST-III exp(-i pi j / 2N)
+ *   DCT-IV            see r2r_dct4_fill_rotation()
+ *
+ * @self: The transform
+ *
+ * @return None
+ */
+static void fill_rotation(struct r2r *self)
+{
+	int n = self->length;
+	double step = (self->kind == BINA_DCT_I) ? -M_PI / n
+		: M_PI / (2.0 * n);
+
+	if (self->kind == BINA_DCT_IV) {
+		r2r_dct4_fill_rotation(self->rotation, &self->shift, n);
+		return;
+	}
+
+	for (int j = 0; j <= n / 2; j++) {
+		self->rotation[j] = cos(step * j) - sin(step * j) * I;
+	}
+}
+
+/* Fills the rotations of the DCT-IV, exp(-i pi j / N) for 0 <= j <= N/2,
+ * which rotate the outputs of the transform; times `shift', exp(-i pi /
+ * 4N), they rotate its inputs.
+ *
+ * @rotation: N/2 + 1 rotations
+ * @shift: Shift of the input rotations
+ * @length: N
+ *
+ * @return None
+ */
+void r2r_dct4_fill_rotation(bina_complex *rotation, bina_complex *shift,
+		int length)
+{
+	double step = M_PI / length;
+
+	for (int j = 0; j <= length / 2; j++) {
+		rotation[j] = cos(step * j) - sin(step * j) * I;
+	}
+
+	*shift = cos(step / 4.0) - sin(step / 4.0) * I;
+}
+
+/* DCT-IV of N points paired as work[n] = x[2n] + i x[N-1-2n]. The points
+ *
+ *   z[n] = work[n] exp(-i pi (4n + 1) / 4N)
+ *
+ * go through an N/2 point transform Z, and with y[k] = exp(-i pi k / N) Z[k]
+ * X[2k] = Re y[k] and X[N-1-2k] = -Im y[k].
+ *
+ * @half: N/2 point forward complex transform
+ * @rotation: See r2r_dct4_fill_rotation()
+ * @shift: See r2r_dct4_fill_rotation()
+ * @work: N/2 paired points, overwritten
+ * @length: N
+ * @out: N outputs
+ *
+ * @return None
+ */
+void r2r_dct4_paired(bina_transform half, const bina_complex *rotation,
+		bina_complex shift, bina_complex *work, int length,
+		bina_real *out)
+{
+	int n = length;
+
+	for (int i = 0; i < n / 2; i++) {
+		work[i] *= rotation[i] * shift;
+	}
+
+	radix2_c2c_fft_execute_on(half, work, work);
+
+	for (int k = 0; k < n / 2; k++) {
+		bina_complex y = rotation[k] * work[k];
+
+		out[2 * k] = creal(y);
+		out[n - 1 - 2 * k] = -cimag(y);
+	}
+}
+
+/* Function to execute a DCT-I class. With s[j] = sin(pi j / N) the folded
+ * signal
+ *
+ *   y[j] = (x[j] + x[N-j]) / 2 - s[j] (x[j] - x[N-j]),  0 <= j < N
+ *
+ * has the real FFT Y with Re Y[k] = X[2k] and Im Y[k] = X[2k-1] - X[2k+1],
+ * and X[1] is summed directly.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int dct1_exec(bina_transform base)
+{
+	struct r2r *self = (struct r2r *) base;
+	const bina_real *x = self->in;
+	bina_real *out = self->out;
+	double *y = (double *) self->work;
+	int n = self->length;
+	double sum = 0.5 * (x[0] - x[n]);
+
+	y[0] = 0.5 * (x[0] + x[n]);
+	y[n / 2] = x[n / 2];
+
+	for (int j = 1; j < n / 2; j++) {
+		double even = 0.5 * (x[j] + x[n - j]);
+		double odd = x[j] - x[n - j];
+
+		y[j] = even - cimag(self->rotation[j]) * odd;
+		y[n - j] = even + cimag(self->rotation[j]) * odd;
+		sum += creal(self->rotation[j]) * odd;
+	}
+
+	radix2_c2c_fft_execute_on(self->half, self->work, self->spectrum);
+	radix2_r2c_fft_split(self->spectrum, self->twiddle, n, 0,
+			RADIX2_R2C_FFT_PAIRS(n));
+
+	for (int k = 0; k <= n / 2; k++) {
+		out[2 * k] = creal(self->spectrum[k]);
+	}
+
+	out[1] = sum;
+
+	for (int k = 1; k < n / 2; k++) {
+		out[2 * k + 1] = out[2 * k - 1] - cimag(self->spectrum[k]);
+	}
+
+	return 0;
+}
+
+/* Function to execute a DCT-II or DST-II class, by Makhoul's reordering.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int dct2_exec(bina_transform base)
+{
+	struct r2r *self = (struct r2r *) base;
+	const bina_real *x = self->in;
+	bina_real *out = self->out;
+	double *v = (double *) self->work;
+	int n = self->length;
+	double odd_sign = (self->kind == BINA_DST_II) ? -1.0 : 1.0;
+
+	for (int i = 0; i < n / 2; i++) {
+		v[i] = x[2 * i];
+		v[n - 1 - i] = odd_sign * x[2 * i + 1];
+	}
+
+	radix2_c2c_fft_execute_on(self->half, self->work, self->spectrum);
+	radix2_r2c_fft_split(self->spectrum, self->twiddle, n, 0,
+			RADIX2_R2C_FFT_PAIRS(n));
+
+	/* Bin k gives X[k] and X[N-k]; the DST reads them backwards */
+	for (int k = 0; k <= n / 2; k++) {
+		bina_complex y = self->rotation[k] * self->spectrum[k];
+
+		if (self->kind == BINA_DST_II) {
+			out[n - 1 - k] = creal(y);
+
+			if (k > 0) {
+				out[k - 1] = -cimag(y);
+			}
+		} else {
+			out[k] = creal(y);
+
+			if (k > 0) {
+				out[n - k] = -cimag(y);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Function to execute a DCT-III or DST-III class, dct2_exec() backwards.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int dct3_exec(bina_transform base)
+{
+	struct r2r *self = (struct r2r *) base;
+	const bina_real *x = self->in;
+	bina_real *out = self->out;
+	double *v = (double *) self->work;
+	int n = self->length;
+	int dst = (self->kind == BINA_DST_III);
+
+	/* V[k] = conj(rotation[k]) (X[k] - i X[N-k]) / 2, with X[N] = 0 */
+	for (int k = 0; k <= n / 2; k++) {
+		double re = dst ? x[n - 1 - k] : x[k];
+		double im = 0.0;
+
+		if (k > 0) {
+			im = dst ? x[k - 1] : x[n - k];
+		}
+
+		self->spectrum[k] = 0.5 * conj(self->rotation[k]) * (re - im * I);
+	}
+
+	radix2_r2c_fft_merge(self->spectrum, self->work, self->twiddle, n, 0,
+			RADIX2_R2C_FFT_PAIRS(n));
+	radix2_c2c_fft_execute_on(self->half, self->work, self->work);
+
+	/* v is N/2 times the reordered inverse of DCT-II */
+	for (int i = 0; i < n / 2; i++) {
+		double odd = v[n - 1 - i];
+
+		out[2 * i] = v[i];
+		out[2 * i + 1] = dst ? -odd : odd;
+	}
+
+	return 0;
+}
+
+/* Function to execute a DCT-IV class, see r2r_dct4_paired().
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int dct4_exec(bina_transform base)
+{
+	struct r2r *self = (struct r2r *) base;
+	const bina_real *x = self->in;
+	int n = self->length;
+
+	for (int i = 0; i < n / 2; i++) {
+		self->work[i] = x[2 * i] + x[n - 1 - 2 * i] * I;
+	}
+
+	r2r_dct4_paired(self->half, self->rotation, self->shift, self->work,
+			n, self->out);
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct r2r *self = (struct r2r *) base;
+
+	if (self->half) {
+		bina_transform_free(self->half);
+	}
+
+	aligned_free(self->twiddle);
+	aligned_free(self->rotation);
+	aligned_free(self->spectrum);
+	aligned_free(self->work);
+	free(self);
+
+	return 0;
+}
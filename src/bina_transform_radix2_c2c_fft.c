@@ -8,22 +8,49 @@
 *******************************************************************************/
 
 #include <complex.h>
+#include <float.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__linux__) || defined(__unix)
+#include <unistd.h>
+#endif
+
 #include "binafft.h"
 #include "internal/aligned_malloc.h"
+#include "internal/arena.h"
 #include "internal/bina_transform.h"
 #include "internal/bitmagic.h"
 #include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
 
 #ifndef BINA_FFT_ALIGNMENT
 #define BINA_FFT_ALIGNMENT (16U)
 #endif
 
+/* Number of twiddle factors rebuilt at a time in compact mode */
+#ifndef BINA_FFT_TWIDDLE_CHUNK
+#define BINA_FFT_TWIDDLE_CHUNK (512)
+#endif
+
+/* Number of octant twiddle factors derived from one sin()/cos() anchor */
+#ifndef BINA_FFT_TWIDDLE_BLOCK
+#define BINA_FFT_TWIDDLE_BLOCK (64)
+#endif
+
+/* Bytes of data a sub-problem may take to be finished in cache, see
+ * radix2_c2c_fft_depth_first(). Zero asks the system for half of L2.
+ */
+#ifndef BINA_FFT_DEPTH_FIRST_BYTES
+#define BINA_FFT_DEPTH_FIRST_BYTES (0)
+#endif
+
+/* Used when the system does not tell the size of L2 */
+#define BINA_FFT_DEFAULT_L2_BYTES (256 * 1024)
+
 #ifndef M_PI
 #define M_PI   (3.14159265358979323846264338327950288)
 #endif
@@ -46,36 +73,211 @@ struct radix2_c2c_fft {
 
 	bina_complex *twiddle;          /* Pointer to twiddle factor buffer */
 
+	int compact;                    /* Nonzero if `twiddle' only holds the
+					 * first octant of the unit circle,
+					 * see fill_twiddle_octant().
+					 */
+
+	bina_complex *twiddle_chunk;    /* Scratch to rebuild a slice of stage
+					 * twiddle factors in compact mode.
+					 */
+
+	double sign;                    /* Sign of the twiddle exponent */
+
+	int replicate_stages;           /* Leading stages whose bottom inputs
+					 * are all zero, see
+					 * BINA_FFT_NONZERO_INPUTS().
+					 */
+
+	int scrambled;                  /* Nonzero for BINA_FFT_SCRAMBLED:
+					 * the spectrum stays in bit reversed
+					 * order, and inverses run as DIT.
+					 */
+
+	int cache_length;               /* Longest sub-problem run stage by
+					 * stage, longer ones are split depth
+					 * first.
+					 */
+
 	unsigned int *permutation;      /* FFT leads the results in bit
 					 * reversed order, this vector
 					 * is needed to place them back to
 					 * original order.
 					 */
+
+	struct arena arena;             /* Memory of the instance itself, its
+					 * scratch buffers, and its tables
+					 * unless they are borrowed, see
+					 * radix2_c2c_fft_create_with_tables().
+					 */
 };
 
 /*******************************************************************************
 * Functions
 *******************************************************************************/
 
-static bina_complex *calculate_twiddle(int);
+static void fill_twiddle_octant(bina_complex *, int);
+
+static void expand_twiddle_octant(const bina_complex *, int, int, int, int,
+		double, bina_complex *);
 
-static unsigned int *calculate_permutation_vector(int);
+static void fill_twiddle(bina_complex *, int, double);
+
+static void fill_permutation_vector(unsigned int *, int);
+
+static void fill_tables(int, int, bina_complex *, unsigned int *);
 
 static void permute_buffer(const unsigned int *pvec, bina_complex *in,
 		bina_complex *out, int length);
 
+static void permute_range(const unsigned int *pvec, const bina_complex *in,
+		bina_complex *out, int length, int first, int count);
+
+static void permute_power(const unsigned int *pvec, const bina_complex *in,
+		double *power, int length, int log_scale);
+
+static void radix2_c2c_fft_first_stage_windowed(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		const double *window,
+		bina_complex *out);
+
+static void radix2_c2c_fft_windowed_segment(const bina_complex *in,
+		const double *window,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count);
+
+static void radix2_c2c_fft_replicate_stage(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		const double *window,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int stage);
+
+static void radix2_c2c_fft_replicate_segment(const bina_complex *in,
+		const double *window,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count);
+
+static void radix2_c2c_fft_replicate_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out);
+
+static void radix2_c2c_fft_stage_range(const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		bina_complex *out,
+		int stage,
+		int first,
+		int count);
+
+static void radix2_c2c_fft_butterfly_segment(const bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count);
+
+static void radix2_c2c_fft_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out);
+
+static void radix2_c2c_fft_pair_segment(const bina_complex *top_in,
+		const bina_complex *bot_in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count);
+
+static int radix2_c2c_fft_later_stages(const struct radix2_c2c_fft *self,
+		bina_complex *dst, double *power, int output);
+
+static int radix2_c2c_fft_execute_dit(const struct radix2_c2c_fft *self,
+		const bina_complex *src, bina_complex *dst);
+
+static int cache_length(void);
+
+static void radix2_c2c_fft_depth_first(const struct radix2_c2c_fft *self,
+		const bina_complex *in, bina_complex *out, int stage,
+		int offset);
+
+static void radix2_c2c_fft_dit_depth_first(
+		const struct radix2_c2c_fft *self, const bina_complex *in,
+		bina_complex *out, int from, int stage, int offset);
+
+static void radix2_c2c_fft_dit_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out);
+
+static void radix2_c2c_fft_dit_pairs(const bina_complex *in,
+		bina_complex *out,
+		int count);
+
+static void radix2_c2c_fft_dit_stage_range(
+		const struct radix2_c2c_fft *self, const bina_complex *in,
+		bina_complex *out, int stage, int offset, int length);
+
+static void radix2_c2c_fft_dit_segment(const bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count);
+
 static void radix2_c2c_fft_butterflies(bina_complex *in,
 		bina_complex *out,
 		const bina_complex *twiddle,
 		int num_dft,
 		int num_butterflies);
 
-static struct radix2_c2c_fft *allocate_class(void);
+static void radix2_c2c_fft_butterflies_compact(bina_complex *in,
+		bina_complex *out,
+		const bina_complex *octant,
+		bina_complex *chunk,
+		int eighth,
+		int stride,
+		double sign,
+		int num_dft,
+		int num_butterflies);
+
+static int use_compact_twiddle(int, int);
+
+static double twiddle_sign(int);
+
+static int bad_scrambled_flags(int);
+
+static struct radix2_c2c_fft *create_class(bina_complex *in,
+		bina_complex *out, int fft_length, int flags,
+		const bina_complex *twiddle, const unsigned int *perm);
 
 static int free_class(bina_transform);
 
 static int radix2_c2c_fft_exec(bina_transform);
 
+static void radix2_c2c_fft_stage(const struct radix2_c2c_fft *self,
+		bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int stage,
+		int num_dft,
+		int num_butterflies);
+
 /*******************************************************************************
 * Implementations
 *******************************************************************************/
@@ -85,173 +287,463 @@ static int radix2_c2c_fft_exec(bina_transform);
  * @in: Pointer to input buffer
  * @out: Pointer to output buffer
  * @fft_length: Length of the problem (MUST be power of two)
- * @flags: Extra flags.
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE is honoured for problems
+ *         of eight points or more. BINA_FFT_INVERSE selects the inverse
+ *         transform (without the 1/n scaling). BINA_FFT_NONZERO_INPUTS()
+ *         skips the zero padding of the input, except in a scrambled
+ *         inverse (BINA_FFT_SCRAMBLED), which rejects it.
  *
  * @returns A new transform class
  */
 bina_transform bina_transform_create_radix2_c2c_fft(bina_complex *in,
 		bina_complex *out, int fft_length, int flags)
 {
-	struct radix2_c2c_fft *self = NULL;
-	bina_complex *twiddle = NULL;
-	bina_complex *temp_buffer = NULL;
-	unsigned int *perm = NULL;
+	if (!ispowtwo(fft_length)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
 
+	if (bad_scrambled_flags(flags)) {
+		return NULL;
+	}
+
+	return create_class(in, out, fft_length, flags, NULL, NULL);
+}
+
+/* Allocates a radix-2 complex-to-complex FFT transform class that borrows
+ * precomputed tables, e.g. from a memory-mapped plan cache. The tables must
+ * have been made by radix2_c2c_fft_tables() with the same length and flags,
+ * and must outlive the transform.
+ *
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags
+ * @twiddle: Twiddle factor table
+ * @perm: Permutation table
+ *
+ * @returns A new transform class
+ */
+bina_transform radix2_c2c_fft_create_with_tables(bina_complex *in,
+		bina_complex *out, int fft_length, int flags,
+		const bina_complex *twiddle, const unsigned int *perm)
+{
 	if (!ispowtwo(fft_length)) {
 		log_error("Length is not power of two\n");
 		return NULL;
 	}
 
+	if (twiddle == NULL || perm == NULL) {
+		log_error("Missing precomputed tables\n");
+		return NULL;
+	}
 
-	if ((twiddle = calculate_twiddle(fft_length)) == NULL) {
-		log_error("Allocating twiddle factor buffer\n");
+	if (bad_scrambled_flags(flags)) {
 		return NULL;
 	}
 
-	if ((perm = calculate_permutation_vector(fft_length)) == NULL) {
-		log_error("Allocating permutation vector buffer\n");
+	return create_class(in, out, fft_length, flags, twiddle, perm);
+}
+
+/* Calculates the twiddle factor and permutation tables of a transform.
+ * Fails, with both tables set to NULL, if the length is not a power of two.
+ *
+ * @fft_length: Length of the problem
+ * @flags: Extra flags, selects the twiddle factor layout
+ * @twiddle: Returns the twiddle factor table, free with aligned_free()
+ * @twiddle_count: Returns the number of twiddle factors (may be NULL)
+ * @perm: Returns the permutation table, free with aligned_free()
+ * @perm_count: Returns the number of permutation entries (may be NULL)
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_tables(int fft_length, int flags, bina_complex **twiddle,
+		size_t *twiddle_count, unsigned int **perm, size_t *perm_count)
+{
+	size_t num_twiddle = 0;
+	size_t num_perm = 0;
 
-		/* Clean up other things */
-		aligned_free(twiddle);
+	*twiddle = NULL;
+	*perm = NULL;
 
-		return NULL;
+	if (fft_length <= 0 || !ispowtwo(fft_length)) {
+		log_error("Length is not power of two\n");
+		return -1;
 	}
 
-	if ((temp_buffer = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
-			sizeof(bina_complex))) == NULL) {
-		log_error("Allocating temporary buffer\n");
+	radix2_c2c_fft_table_layout(fft_length, flags, &num_twiddle,
+			&num_perm);
+
+	*twiddle = aligned_malloc(BINA_FFT_ALIGNMENT, num_twiddle,
+			sizeof(bina_complex));
+	*perm = aligned_malloc(BINA_FFT_ALIGNMENT, num_perm,
+			sizeof(unsigned int));
+
+	if (*twiddle == NULL || *perm == NULL) {
+		log_error("Allocating twiddle factor and permutation buffers\n");
 
 		/* Clean up other things */
-		aligned_free(twiddle);
-		aligned_free(perm);
+		aligned_free(*twiddle);
+		aligned_free(*perm);
+		*twiddle = NULL;
+		*perm = NULL;
 
-		return NULL;
+		return -1;
 	}
 
+	fill_tables(fft_length, flags, *twiddle, *perm);
 
-	if ((self = allocate_class()) == NULL) {
-		log_error("Allocating tranform object instance\n");
+	if (twiddle_count) {
+		*twiddle_count = num_twiddle;
+	}
 
-		/* Clean up other things */
-		aligned_free(twiddle);
-		aligned_free(perm);
-		aligned_free(temp_buffer);
+	if (perm_count) {
+		*perm_count = num_perm;
+	}
 
-		return NULL;
+	return 0;
+}
+
+/* Fills the bit-reversal table of a transform for transforms that share
+ * the radix-2 stage structure but not its element type. Entry i is the
+ * reversal of 2i, and the reversal of 2i + 1 is that plus n/2.
+ *
+ * @perm: Destination, max(n/2, 1) entries
+ * @fft_length: Length of the problem (MUST be power of two)
+ *
+ * @return None
+ */
+void radix2_c2c_fft_permutation(unsigned int *perm, int fft_length)
+{
+	fill_permutation_vector(perm, fft_length);
+}
+
+/* Describes the tables radix2_c2c_fft_tables() makes for a transform.
+ *
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags
+ * @twiddle_count: Returns the number of twiddle factors (may be NULL)
+ * @perm_count: Returns the number of permutation entries (may be NULL)
+ *
+ * @return The subset of `flags' that shapes the tables, two sets of flags
+ * with the same layout can share tables.
+ */
+int radix2_c2c_fft_table_layout(int fft_length, int flags,
+		size_t *twiddle_count, size_t *perm_count)
+{
+	int compact = use_compact_twiddle(fft_length, flags);
+
+	if (twiddle_count) {
+		*twiddle_count = compact ? fft_length / 8 + 1 : fft_length;
 	}
 
-	/* Setting members */
+	if (perm_count) {
+		*perm_count = fft_length > 1 ? fft_length / 2 : 1;
+	}
 
-	self->fft_length = fft_length;
-	self->radix = ilog2(fft_length);
-	self->twiddle = twiddle;
-	self->permutation = perm;
-	self->in = in;
-	self->out = out;
-	self->temp = temp_buffer;
+	/* The octant is the same for both directions */
+	if (compact) {
+		return BINA_FFT_COMPACT_TWIDDLE;
+	}
 
-	return self;
+	return flags & BINA_FFT_INVERSE;
+}
+
+/* Picks the twiddle factor layout, an octant needs at least one full step
+ * of the circle.
+ *
+ * @fft_length: Length of the problem
+ * @flags: Extra flags
+ *
+ * @return Nonzero for the compact (octant) layout.
+ */
+static int use_compact_twiddle(int fft_length, int flags)
+{
+	return (flags & BINA_FFT_COMPACT_TWIDDLE) && (fft_length >= 8);
+}
+
+/* Sign of the exponent of the twiddle factors.
+ *
+ * @flags: Extra flags
+ *
+ * @return +1.0 for an inverse transform, -1.0 for a forward transform.
+ */
+static double twiddle_sign(int flags)
+{
+	return (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+}
+
+/* A scrambled inverse takes a whole spectrum in bit reversed order, in
+ * which zero padding of the time signal means nothing, so it cannot skip
+ * inputs with BINA_FFT_NONZERO_INPUTS().
+ *
+ * @flags: Extra flags
+ *
+ * @return Nonzero, with the error logged, if the flags do not go together.
+ */
+static int bad_scrambled_flags(int flags)
+{
+	if ((flags & BINA_FFT_SCRAMBLED) && (flags & BINA_FFT_INVERSE)
+			&& (flags & BINA_FFT_NONZERO_INPUTS_MASK)) {
+		log_error("Scrambled inverse takes no BINA_FFT_NONZERO_INPUTS\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Fills the twiddle factor and permutation tables of a transform.
+ *
+ * @fft_length: Length of the problem
+ * @flags: Extra flags, selects the twiddle factor layout
+ * @twiddle: Twiddle factor table, sized by radix2_c2c_fft_table_layout()
+ * @perm: Permutation table, sized by radix2_c2c_fft_table_layout()
+ *
+ * @return None
+ */
+static void fill_tables(int fft_length, int flags, bina_complex *twiddle,
+		unsigned int *perm)
+{
+	double sign = twiddle_sign(flags);
+
+	if (use_compact_twiddle(fft_length, flags)) {
+		fill_twiddle_octant(twiddle, fft_length);
+	} else {
+		fill_twiddle(twiddle, fft_length, sign);
+	}
+
+	fill_permutation_vector(perm, fft_length);
 }
 
-/* Helper function to allocate the class and set up callbacks
+/* Allocates the class with all of its buffers. The instance, its scratch
+ * buffers and (unless they are borrowed) its tables are carved out of a
+ * single arena, and nothing is cleared that is about to be overwritten.
+ *
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags
+ * @twiddle: Borrowed twiddle factor table, or NULL to compute one
+ * @perm: Borrowed permutation table, or NULL to compute one
  *
  * @returns A new transform class
  */
-static struct radix2_c2c_fft *allocate_class(void)
+static struct radix2_c2c_fft *create_class(bina_complex *in,
+		bina_complex *out, int fft_length, int flags,
+		const bina_complex *twiddle, const unsigned int *perm)
 {
 	struct radix2_c2c_fft *self = NULL;
+	struct arena arena;
+	int compact = use_compact_twiddle(fft_length, flags);
+	int borrowed = (twiddle != NULL);
+	double sign = twiddle_sign(flags);
+	int nonzero_radix = ((flags & BINA_FFT_NONZERO_INPUTS_MASK) >> 16) - 1;
+	size_t num_twiddle = 0;
+	size_t num_perm = 0;
+	size_t size = 0;
+
+	radix2_c2c_fft_table_layout(fft_length, flags, &num_twiddle,
+			&num_perm);
+
+	/* Add up everything the plan needs */
+	size += arena_size(sizeof(struct radix2_c2c_fft));
+	size += arena_size(fft_length * sizeof(bina_complex));
+
+	if (compact) {
+		size += arena_size(BINA_FFT_TWIDDLE_CHUNK * sizeof(bina_complex));
+	}
 
-	/* Set up pointers */
-	self = malloc(sizeof(struct radix2_c2c_fft));
+	if (!borrowed) {
+		size += arena_size(num_twiddle * sizeof(bina_complex));
+		size += arena_size(num_perm * sizeof(unsigned int));
+	}
 
-	if (self == NULL) {
+	if (arena_create(&arena, size) != 0) {
+		log_error("Allocating tranform object instance\n");
 		return NULL;
 	}
 
-	/* Set up callbacks */
+	/* Setting members */
+
+	self = arena_carve(&arena, sizeof(struct radix2_c2c_fft));
 	self->type.execute = &(radix2_c2c_fft_exec);
 	self->type.free = &(free_class);
+	self->temp = arena_carve(&arena, fft_length * sizeof(bina_complex));
+	self->twiddle_chunk = NULL;
+
+	if (compact) {
+		self->twiddle_chunk = arena_carve(&arena,
+				BINA_FFT_TWIDDLE_CHUNK * sizeof(bina_complex));
+	}
+
+	if (borrowed) {
+		self->twiddle = (bina_complex *) twiddle;
+		self->permutation = (unsigned int *) perm;
+	} else {
+		self->twiddle = arena_carve(&arena,
+				num_twiddle * sizeof(bina_complex));
+		self->permutation = arena_carve(&arena,
+				num_perm * sizeof(unsigned int));
+		fill_tables(fft_length, flags, self->twiddle,
+				self->permutation);
+	}
+
+	self->fft_length = fft_length;
+	self->radix = ilog2(fft_length);
+	self->compact = compact;
+	self->sign = sign;
+	self->replicate_stages = 0;
+	self->scrambled = (flags & BINA_FFT_SCRAMBLED) != 0;
+	self->cache_length = cache_length();
+
+	if (nonzero_radix >= 0 && nonzero_radix < (int) self->radix) {
+		self->replicate_stages = self->radix - nonzero_radix;
+	}
+
+	self->in = in;
+	self->out = out;
+	self->arena = arena;
 
 	return self;
 }
 
-/* Calculate twiddle factor table depending on problem size, and reshuffles
- * them to radix-2 DIF FFT.
+/* Fills the first octant of the unit circle, octant[k] = (cos(t), sin(t))
+ * with t = 2 pi k / n for 0 <= k <= n/8.
  *
- * @fft_length: Length of FFT.
+ * Calling sin() and cos() for every entry dominates plan creation of large
+ * problems, so the octant is built from two small exact tables instead:
+ * anchors every BINA_FFT_TWIDDLE_BLOCK points, and the fine rotations in
+ * between. Each entry is then a single complex product of two correctly
+ * rounded values, so the error stays within a couple of ulp no matter how
+ * large n gets, unlike a running recurrence. The blocks are independent and
+ * are spread over threads when built with OpenMP.
  *
- * @return Twiddle factor table.
+ * @octant Destination, n/8 + 1 entries.
+ * @fft_length Length of FFT, at least 8.
+ *
+ * @return None
  */
-static bina_complex *calculate_twiddle(int fft_length)
+static void fill_twiddle_octant(bina_complex *octant, int fft_length)
 {
-	bina_complex *twiddle = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
-			sizeof(bina_complex));
+	int eighth = fft_length / 8;
+	int block = BINA_FFT_TWIDDLE_BLOCK;
+	int num_blocks = eighth / block + 1;
+	const double step = 2.0 * M_PI / fft_length;
+	double fine_re[BINA_FFT_TWIDDLE_BLOCK];
+	double fine_im[BINA_FFT_TWIDDLE_BLOCK];
+
+	if (block > eighth + 1) {
+		block = eighth + 1;
+	}
 
-	if (twiddle == NULL) {
-		return NULL;
+	for (int m = 0; m < block; m++) {
+		fine_re[m] = cos(step * m);
+		fine_im[m] = sin(step * m);
 	}
 
-	/* Start populating the twiddle factor table */
+#	ifdef _OPENMP
+#	pragma omp parallel for if (num_blocks > 256)
+#	endif
+	for (int b = 0; b < num_blocks; b++) {
+
+		int first = b * block;
+		int count = eighth + 1 - first;
+		double *dst = (double *) (octant + first);
+		double anchor_re = cos(step * first);
+		double anchor_im = sin(step * first);
+
+		if (count > block) {
+			count = block;
+		}
+
+		for (int m = 0; m < count; m++) {
+			dst[2 * m] = anchor_re * fine_re[m]
+					- anchor_im * fine_im[m];
+			dst[2 * m + 1] = anchor_re * fine_im[m]
+					+ anchor_im * fine_re[m];
+		}
+	}
+}
 
+/* Fills the twiddle factor table depending on problem size, reshuffled
+ * for radix-2 DIF FFT: the n/2 factors of the first stage, followed by the
+ * decimated factors of each later stage (n entries in total).
+ *
+ * The first stage (half of the unit circle) is unfolded from the first
+ * octant, see fill_twiddle_octant(), which is staged in the tail of the
+ * table that later stages overwrite anyway.
+ *
+ * @twiddle: Destination, n entries.
+ * @fft_length: Length of FFT.
+ * @sign: Sign of the exponent, -1.0 for a forward transform.
+ *
+ * @return None
+ */
+static void fill_twiddle(bina_complex *twiddle, int fft_length, double sign)
+{
 	bina_complex *tptr = twiddle;
-	const bina_complex omega = 2.0 * M_PI / fft_length * _Complex_I;
 	int tlen = fft_length / 2;
 	int radix = ilog2(fft_length);
 
-	for (int r = 0; r < radix; r++) {
+	if (fft_length < 8) {
+		const double step = 2.0 * M_PI / fft_length;
 
-		if(r == 0) {
+		for (int i = 0; i < tlen; i++) {
+			*tptr++ = cos(step * i)
+					+ sign * sin(step * i) * _Complex_I;
+		}
+	} else {
+		bina_complex *octant = twiddle + tlen;
 
-			/* For the first half of the twiddle table, calculate
-			 * half of the unit circle [0, pi).
-			 */
-			for (int i = 0; i < tlen; i++) {
-				*tptr++ = cexp(omega * i);
-			}
+		fill_twiddle_octant(octant, fft_length);
+		expand_twiddle_octant(octant, fft_length / 8, 1, 0, tlen,
+				sign, twiddle);
+		tptr += tlen;
+	}
 
-		} else {
+	tlen = tlen / 2;
 
-			/* Take the first segment and copy it over */
-			int skip = 1 << r;
-			bina_complex *tptr2 = twiddle;
+	for (int r = 1; r < radix; r++) {
 
-			for (int i = 0; i < tlen; i++) {
-				*tptr++ = *tptr2;
-				tptr2 += skip;
-			}
+		/* Take the first segment and copy it over */
+		int skip = 1 << r;
+		bina_complex *tptr2 = twiddle;
 
+		for (int i = 0; i < tlen; i++) {
+			*tptr++ = *tptr2;
+			tptr2 += skip;
 		}
 
 		tlen = tlen / 2;
 	}
 
-	return twiddle;
+	/* Unused last entry, keeps the table free of garbage */
+	*tptr = 0.0;
 }
 
-/* Calculate bit-reversed lookup table for an FFT of a specific length.
+/* Fills the bit-reversed lookup table for an FFT of a specific length.
  *
+ * Only even indices are stored, and rev(2i) is the (lg(n) - 1)-bit reversal
+ * of i. The table is grown incrementally: once the first `len' entries are
+ * known, the next `len' are the same values with one more (lower) bit set.
+ *
+ * @perm: Destination, max(n/2, 1) entries.
  * @fft_length: Length of FFT.
  *
- * @return Bit-reversed table of length n/2.
+ * @return None
  */
-static unsigned int *calculate_permutation_vector(int fft_length)
+static void fill_permutation_vector(unsigned int *perm, int fft_length)
 {
-	unsigned int *perm = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length/2,
-			sizeof(unsigned int));
-
-	if (perm == NULL) {
-		return NULL;
-	}
+	unsigned int half = fft_length / 2;
 
-	/* Calculate all even index */
-	unsigned int *p = perm;
-	unsigned int rshift = 31 - ilog2(fft_length);
+	perm[0] = 0;
 
-	for (unsigned int i = 0; i < fft_length; i+=2) {
-		*p++ = revbin(i) >> rshift;
+	for (unsigned int len = 1, bit = half / 2; len < half;
+			len *= 2, bit /= 2) {
+		for (unsigned int i = 0; i < len; i++) {
+			perm[len + i] = perm[i] | bit;
+		}
 	}
-
-	return perm;
 }
 
 /* Function to execute radix-2 complex-to-complex FFT class.
@@ -265,107 +757,1387 @@ static int radix2_c2c_fft_exec(bina_transform base)
 {
 	/* Get self from base class */
 	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
-	int fft_length = self->fft_length;
-
-	/* There are log2(n) stages in FFT */
-	int lg2n = self->radix;
-	/* Initially there are n/2 butterflies */
-	int num_butterflies = fft_length / 2;
-	/* Initially the stage DFT length is 2 */
-	int num_stage_dft = 1;
 
-	/* Do the first stage and copy the result into temp buffer */
-	bina_complex *in = self->in;
-	bina_complex *out = self->temp;
-	const bina_complex *tw = self->twiddle;
+	return radix2_c2c_fft_execute_on(base, self->in, self->out);
+}
 
-	radix2_c2c_fft_butterflies(in, out, tw, num_stage_dft, num_butterflies);
+/* Executes a radix-2 complex-to-complex FFT class on other buffers than the
+ * ones it was created with, for transforms that run many problems of the
+ * same size. `src' may equal `dst'.
+ *
+ * @base: Pointer to instance of transform object.
+ * @src: Pointer to input buffer.
+ * @dst: Pointer to output buffer.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_execute_on(bina_transform base, bina_complex *src,
+		bina_complex *dst)
+{
+	return radix2_c2c_fft_execute_fused(base, src, NULL, dst, NULL,
+			RADIX2_C2C_FFT_SPECTRUM);
+}
 
-	/* Update in/out pointers */
-	in = self->temp;
-	out = self->out;
+/* Executes a radix-2 complex-to-complex FFT class on a frame given as two
+ * segments, e.g. one that wraps around the end of a ring buffer: the first
+ * `head_length' points at `head', then the rest at `tail'. The first stage
+ * reads both in place, so the frame is never copied together. The output
+ * goes to the buffer the class was created with, which may overlap the
+ * segments, as the first stage reads all of them before anything is
+ * written there; a scrambled inverse runs in the output, so there it must
+ * not overlap them.
+ *
+ * @base: Pointer to instance of a radix-2 complex transform.
+ * @head: First points of the frame.
+ * @head_length: Number of points at `head', 0 to n.
+ * @tail: The other n - head_length points, may be NULL if there are none.
+ * @tail_length: n - head_length.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_transform_execute_segments(bina_transform base,
+		const bina_complex *head, int head_length,
+		const bina_complex *tail, int tail_length)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	bina_complex *dst;
+	int fft_length;
 
-	/* Updating pointer to next set of twiddle factors */
-	tw += num_butterflies;
-	/* Next stage has twice the number of DFT */
-	num_stage_dft *= 2;
-	/* Next stage has half the amount of butterflies */
-	num_butterflies /= 2;
+	if (self == NULL || self->type.execute != &(radix2_c2c_fft_exec)) {
+		log_error("Segments are only taken by radix-2 complex FFTs\n");
+		return -1;
+	}
 
+	fft_length = self->fft_length;
+	dst = self->out;
 
-	for (int stage = 1; stage < lg2n; stage++) {
+	if (head_length < 0 || tail_length < 0
+			|| head_length + tail_length != fft_length) {
+		log_error("Segments do not add up to the length\n");
+		return -1;
+	}
 
-		radix2_c2c_fft_butterflies(in, out, tw, num_stage_dft,
-				num_butterflies);
+	if (tail_length == 0 || head_length == 0) {
+		return radix2_c2c_fft_execute_on(base, (bina_complex *)
+				(tail_length ? tail : head), dst);
+	}
 
-		/* Updating pointer to next set of twiddle factors */
-		tw += num_butterflies;
-		/* Next stage has twice the number of DFT */
-		num_stage_dft *= 2;
-		/* Next stage has half the amount of butterflies */
-		num_butterflies /= 2;
+	/* A scrambled inverse gathers the frame with its first stage, and
+	 * runs the others in place, see radix2_c2c_fft_execute_dit().
+	 */
+	if (self->scrambled && self->sign > 0.0) {
+		radix2_c2c_fft_dit_first_stage_segments(self, head,
+				head_length, tail, dst);
+		radix2_c2c_fft_dit_depth_first(self, dst, dst,
+				(int) self->radix - 2, 0, 0);
 
-		/* Update in/out pointers */
-		bina_complex *temp = in;
-		in = out;
-		out = temp;
+		return 0;
+	}
+
+	/* Either first stage reads the segments where they are, and only
+	 * writes the scratch buffer, so the output may overlap them.
+	 */
+	if (self->replicate_stages > 0) {
+		radix2_c2c_fft_replicate_first_stage_segments(self, head,
+				head_length, tail, self->temp);
+	} else {
+		radix2_c2c_fft_first_stage_segments(self, head, head_length,
+				tail, self->temp);
+	}
+
+	return radix2_c2c_fft_later_stages(self, dst, NULL,
+			RADIX2_C2C_FFT_SPECTRUM);
+}
+
+/* Puts n points in bit reversed order, or back: dst[j] = src[rev(j)].
+ * This is the permutation a scrambled transform leaves out, for spectra
+ * made some other way.
+ *
+ * @base: Pointer to instance of transform object.
+ * @src: Pointer to input buffer.
+ * @dst: Pointer to output buffer, not `src'.
+ *
+ * @return None
+ */
+void radix2_c2c_fft_bit_reverse(bina_transform base, const bina_complex *src,
+		bina_complex *dst)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+
+	if (self->fft_length == 1) {
+		dst[0] = src[0];
+		return;
+	}
+
+	permute_buffer(self->permutation, (bina_complex *) src, dst,
+			self->fft_length);
+}
+
+/* Sets the longest sub-problem that is finished stage by stage, which
+ * plans take from the size of L2 otherwise, see cache_length(). Longer
+ * ones go depth first, so a short length sends every plan down that path
+ * whatever the host it runs on.
+ *
+ * @base: Pointer to instance of a radix-2 complex transform.
+ * @length: Length in points, a power of two from 2 on.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_set_cache_length(bina_transform base, int length)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+
+	if (self == NULL || self->type.execute != &(radix2_c2c_fft_exec)) {
+		log_error("Only radix-2 complex FFTs have a cache length\n");
+		return -1;
+	}
+
+	if (length < 2 || (length & (length - 1)) != 0) {
+		log_error("Cache length is not a power of two from 2 on\n");
+		return -1;
+	}
+
+	self->cache_length = length;
+
+	return 0;
+}
+
+/* Executes a radix-2 complex-to-complex FFT class with extra passes fused
+ * in: the input can be multiplied by a window in the first stage, and the
+ * permutation can write the power spectrum |X|^2 (or 10 lg |X|^2, in dB)
+ * instead of the spectrum. Neither needs a pass of its own. A scrambled
+ * inverse takes its input in bit reversed order, so it runs neither.
+ *
+ * @base: Pointer to instance of transform object.
+ * @src: Pointer to input buffer, not modified.
+ * @window: Window, n values, or NULL for none.
+ * @dst: Pointer to output buffer; scratch if `output' is not
+ *       RADIX2_C2C_FFT_SPECTRUM.
+ * @power: n power values, for the power outputs only.
+ * @output: One of RADIX2_C2C_FFT_*.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_execute_fused(bina_transform base, const bina_complex *src,
+		const double *window, bina_complex *dst, double *power,
+		int output)
+{
+	/* Get self from base class */
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	int fft_length = self->fft_length;
+
+	/* A single point is its own transform */
+	if (fft_length == 1) {
+		dst[0] = window ? src[0] * window[0] : src[0];
+
+		if (output != RADIX2_C2C_FFT_SPECTRUM) {
+			permute_power(self->permutation, dst, power, 1,
+					output == RADIX2_C2C_FFT_LOG_POWER);
+		}
+
+		return 0;
+	}
+
+	if (self->scrambled && self->sign > 0.0) {
+		if (window != NULL || output != RADIX2_C2C_FFT_SPECTRUM) {
+			log_error("Scrambled inverse takes no window or power\n");
+			return -1;
+		}
+
+		return radix2_c2c_fft_execute_dit(self, src, dst);
+	}
+
+	/* Initially there are n/2 butterflies */
+	int num_butterflies = fft_length / 2;
+	/* Initially the stage DFT length is 2 */
+	int num_stage_dft = 1;
+
+	/* Do the first stage and copy the result into temp buffer */
+	bina_complex *in = (bina_complex *) src;
+	bina_complex *out = self->temp;
+	const bina_complex *tw = self->twiddle;
+
+	if (self->replicate_stages > 0) {
+		radix2_c2c_fft_replicate_stage(self, in, window, out, tw, 0);
+	} else if (window) {
+		radix2_c2c_fft_first_stage_windowed(self, in, window, out);
+	} else {
+		radix2_c2c_fft_stage(self, in, out, tw, 0, num_stage_dft,
+				num_butterflies);
+	}
+
+	return radix2_c2c_fft_later_stages(self, dst, power, output);
+}
+
+/* Runs butterflies [first, first + count) of the first stage into the
+ * scratch buffer of the plan, with the inputs of their top and bottom
+ * halves, points first + i and first + i + n/2, in `top'[i] and
+ * `bottom'[i]. A caller that converts its input to bina_complex can do it
+ * a block at a time, and never make an n point copy: once every butterfly
+ * has run, radix2_c2c_fft_later_stages_in_place() finishes the transform,
+ * and radix2_c2c_fft_gather() reads it out. The plan must have two points
+ * or more.
+ *
+ * @base: Pointer to instance of transform object.
+ * @top: Inputs of the top halves, `count' points.
+ * @bottom: Inputs of the bottom halves, `count' points.
+ * @first: First butterfly.
+ * @count: Number of butterflies.
+ *
+ * @return None
+ */
+void radix2_c2c_fft_first_stage_pairs(bina_transform base,
+		const bina_complex *top, const bina_complex *bottom,
+		int first, int count)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	int num_butterflies = self->fft_length / 2;
+
+	if (!self->compact) {
+		radix2_c2c_fft_pair_segment(top, bottom, self->temp,
+				self->twiddle + first, first, num_butterflies,
+				count);
+		return;
+	}
+
+	for (int done = 0; done < count; done += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int chunk = count - done;
+
+		if (chunk > BINA_FFT_TWIDDLE_CHUNK) {
+			chunk = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		expand_twiddle_octant(self->twiddle, self->fft_length / 8, 1,
+				first + done, chunk, self->sign,
+				self->twiddle_chunk);
+		radix2_c2c_fft_pair_segment(top + done, bottom + done,
+				self->temp, self->twiddle_chunk, first + done,
+				num_butterflies, chunk);
+	}
+}
+
+/* Runs every stage after the first in the scratch buffer of the plan, in
+ * place, see radix2_c2c_fft_first_stage_pairs(). The spectrum is left
+ * there in bit reversed order.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_later_stages_in_place(bina_transform base)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+
+	return radix2_c2c_fft_later_stages(self, self->temp, NULL,
+			RADIX2_C2C_FFT_SPECTRUM);
+}
+
+/* Reads bins [first, first + count) of the spectrum left by
+ * radix2_c2c_fft_later_stages_in_place(), in natural order.
+ *
+ * @base: Pointer to instance of transform object.
+ * @first: First bin.
+ * @count: Number of bins.
+ * @dst: `count' bins.
+ *
+ * @return None
+ */
+void radix2_c2c_fft_gather(bina_transform base, int first, int count,
+		bina_complex *dst)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	const unsigned int *perm = self->permutation;
+	int half = self->fft_length / 2;
+
+	/* Even bin 2i is at perm[i], the odd one after it n/2 further */
+	for (int k = 0; k < count; k++) {
+		int bin = first + k;
+
+		dst[k] = self->temp[perm[bin / 2] + (bin & 1) * half];
+	}
+}
+
+/* Runs every stage after the first, whose output is in the temporary
+ * buffer, and the permutation. Scrambled spectra, and spectra with `dst'
+ * the temporary buffer, skip the permutation and run the stages in place
+ * in `dst', as butterflies write where they read.
+ *
+ * @self: Transform instance, of two points or more
+ * @dst: Pointer to output buffer; scratch if `output' is not
+ *       RADIX2_C2C_FFT_SPECTRUM.
+ * @power: n power values, for the power outputs only.
+ * @output: One of RADIX2_C2C_FFT_*.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int radix2_c2c_fft_later_stages(const struct radix2_c2c_fft *self,
+		bina_complex *dst, double *power, int output)
+{
+	int fft_length = self->fft_length;
+	/* There are log2(n) stages in FFT */
+	int lg2n = self->radix;
+	/* The second stage has n/4 butterflies */
+	int num_butterflies = fft_length / 4;
+	/* and two DFTs */
+	int num_stage_dft = 2;
+	/* Twiddle factors of the first stage are behind */
+	const bina_complex *tw = self->twiddle + fft_length / 2;
+
+	bina_complex *in = self->temp;
+	bina_complex *out = dst;
+	/* Scrambled plans, and spectra left in scratch, skip the permutation */
+	int in_place = (self->scrambled || dst == self->temp)
+		&& output == RADIX2_C2C_FFT_SPECTRUM;
+
+	/* Out of cache, each half is finished before the other is touched.
+	 * Zero padded plans split after their copy-and-rotate stages.
+	 */
+	if (fft_length > self->cache_length && self->replicate_stages <= 1) {
+		bina_complex *target = in_place ? dst : self->temp;
+		int half = fft_length / 2;
+
+		radix2_c2c_fft_depth_first(self, in, target, 1, 0);
+		radix2_c2c_fft_depth_first(self, in, target, 1, half);
+
+		if (in_place) {
+			return 0;
+		}
+
+		/* Every stage is done, only the permutation is left */
+		lg2n = 1;
+	}
+
+	for (int stage = 1; stage < lg2n; stage++) {
+
+		if (stage < self->replicate_stages) {
+			radix2_c2c_fft_replicate_stage(self, in, NULL, out, tw,
+					stage);
+		} else {
+			radix2_c2c_fft_stage(self, in, out, tw, stage,
+					num_stage_dft, num_butterflies);
+		}
+
+		/* Updating pointer to next set of twiddle factors */
+		tw += num_butterflies;
+		/* Next stage has twice the number of DFT */
+		num_stage_dft *= 2;
+		/* Next stage has half the amount of butterflies */
+		num_butterflies /= 2;
+
+		/* Update in/out pointers */
+		bina_complex *temp = in;
+		in = out;
+		out = in_place ? in : temp;
+	}
+
+	/* Only two points, the first stage is all there is */
+	if (in_place) {
+		if (in != dst) {
+			memcpy(dst, in, fft_length * sizeof(bina_complex));
+		}
+
+		return 0;
 	}
 
 	/* The output should be in bit-reversed order now, and needs to be
 	 * reshuffled.
 	 */
 	const unsigned int *perm = self->permutation;
+
+	if (output != RADIX2_C2C_FFT_SPECTRUM) {
+		permute_power(perm, in, power, fft_length,
+				output == RADIX2_C2C_FFT_LOG_POWER);
+		return 0;
+	}
+
 	permute_buffer(perm, in, out, fft_length);
 
-	/* Copy to output buffer if out is pointing to temporary buffer
-	 *
-	 * TODO: Find a better way of doing this, or investigate
-	 *       the likelyhood of hitting this branch.
-	 */
-	if(out == self->temp) {
-		in = self->temp;
-		out = self->out;
-		memcpy(out, in, fft_length * sizeof(bina_complex));
+	/* Copy to output buffer if out is pointing to temporary buffer
+	 *
+	 * TODO: Find a better way of doing this, or investigate
+	 *       the likelyhood of hitting this branch.
+	 */
+	if(out == self->temp) {
+		in = self->temp;
+		out = dst;
+		memcpy(out, in, fft_length * sizeof(bina_complex));
+	}
+
+	return 0;
+}
+
+/* Inverse of a scrambled spectrum, see BINA_FFT_SCRAMBLED: the DIF stages
+ * of the forward transform undone in reverse order, as decimation in time
+ * butterflies (a, b) -> (a + b w, a - b w) with the conjugate twiddle
+ * factors of the inverse plan. Bit reversed input comes out in natural
+ * order, times n, with no permutation; every stage runs in place in `dst'.
+ *
+ * @self: Transform instance, of two points or more
+ * @src: Spectrum in bit reversed order, may equal `dst'
+ * @dst: Pointer to output buffer
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int radix2_c2c_fft_execute_dit(const struct radix2_c2c_fft *self,
+		const bina_complex *src, bina_complex *dst)
+{
+	radix2_c2c_fft_dit_depth_first(self, src, dst, (int) self->radix - 1,
+			0, 0);
+
+	return 0;
+}
+
+/* Longest sub-problem, in points, that is finished stage by stage: the
+ * largest power of two that fits in BINA_FFT_DEPTH_FIRST_BYTES, or in half
+ * of L2 as the system reports it. The other half is left to the twiddle
+ * factors and whatever else the caller keeps warm.
+ *
+ * @return The length, at least 64
+ */
+static int cache_length(void)
+{
+	long bytes = BINA_FFT_DEPTH_FIRST_BYTES;
+	int length = 64;
+
+	if (bytes <= 0) {
+		bytes = BINA_FFT_DEFAULT_L2_BYTES / 2;
+
+#		ifdef _SC_LEVEL2_CACHE_SIZE
+		long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+		if (l2 > 0) {
+			bytes = l2 / 2;
+		}
+#		endif
+	}
+
+	while (length <= (1 << 29)
+			&& 2 * (long) length * (long) sizeof(bina_complex)
+			<= bytes) {
+		length *= 2;
+	}
+
+	return length;
+}
+
+/* Runs the DIF stages from `stage' on in the DFT of n >> stage points at
+ * `offset', depth first: a DFT that fits in cache runs one stage after the
+ * other, a larger one runs its first stage and then each half to the end
+ * before the other half. Every stage then sweeps cache instead of memory,
+ * for about N log_C N memory traffic instead of N lg N, where C is the
+ * cache length. The split is the same at every size, C only decides
+ * where it stops.
+ *
+ * @self: Transform instance
+ * @in: Input of the first stage
+ * @out: Output of every stage, the later ones run in place
+ * @stage: First stage to run
+ * @offset: Index of the first point of the DFT
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_depth_first(const struct radix2_c2c_fft *self,
+		const bina_complex *in, bina_complex *out, int stage,
+		int offset)
+{
+	int length = self->fft_length >> stage;
+
+	if (length <= self->cache_length) {
+		for (int s = stage; s < (int) self->radix; s++) {
+			radix2_c2c_fft_stage_range(self, in, out, s,
+					offset / 2, length / 2);
+			in = out;
+		}
+
+		return;
+	}
+
+	radix2_c2c_fft_stage_range(self, in, out, stage, offset / 2,
+			length / 2);
+	radix2_c2c_fft_depth_first(self, out, out, stage + 1, offset);
+	radix2_c2c_fft_depth_first(self, out, out, stage + 1,
+			offset + length / 2);
+}
+
+/* Same as radix2_c2c_fft_depth_first() for the DIT stages of a scrambled
+ * inverse, which run from the last stage back to the first: both halves
+ * are finished before the stage that joins them.
+ *
+ * @self: Transform instance
+ * @in: Input of stage `from', read once
+ * @out: Output of every stage, the earlier ones run in place
+ * @from: Stage to start at, lg(n) - 1 unless the caller ran it
+ * @stage: Earliest stage to run
+ * @offset: Index of the first point of the DFT
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_dit_depth_first(
+		const struct radix2_c2c_fft *self, const bina_complex *in,
+		bina_complex *out, int from, int stage, int offset)
+{
+	int length = self->fft_length >> stage;
+
+	if (length <= self->cache_length) {
+		for (int s = from; s >= stage; s--) {
+			radix2_c2c_fft_dit_stage_range(self, in, out, s,
+					offset, length);
+			in = out;
+		}
+
+		return;
+	}
+
+	radix2_c2c_fft_dit_depth_first(self, in, out, from, stage + 1,
+			offset);
+	radix2_c2c_fft_dit_depth_first(self, in, out, from, stage + 1,
+			offset + length / 2);
+	radix2_c2c_fft_dit_stage_range(self, out, out, stage, offset, length);
+}
+
+/* Runs the DIT butterflies of one stage over the points `offset' to
+ * offset + length, a whole number of the DFTs of the stage.
+ *
+ * @self: Transform instance
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer, may equal `in'
+ * @stage: Stage, as numbered by the forward DIF stages
+ * @offset: First point
+ * @length: Number of points
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_dit_stage_range(
+		const struct radix2_c2c_fft *self, const bina_complex *in,
+		bina_complex *out, int stage, int offset, int length)
+{
+	int fft_length = self->fft_length;
+	int num_butterflies = fft_length >> (stage + 1);
+	/* Stages before this one used n/2 + n/4 + ... factors */
+	const bina_complex *tw = self->twiddle
+		+ (fft_length - (fft_length >> stage));
+
+	for (int first = 0; first < num_butterflies;
+			first += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int count = num_butterflies - first;
+
+		if (count > BINA_FFT_TWIDDLE_CHUNK) {
+			count = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		if (self->compact) {
+			expand_twiddle_octant(self->twiddle, fft_length / 8,
+					1 << stage, first, count, self->sign,
+					self->twiddle_chunk);
+		}
+
+		for (int top = offset; top < offset + length;
+				top += 2 * num_butterflies) {
+			radix2_c2c_fft_dit_segment(in, out,
+					self->compact ? self->twiddle_chunk
+					: tw + first,
+					top + first, num_butterflies, count);
+		}
+	}
+}
+
+/* Number of steps of a transform run with radix2_c2c_fft_execute_step():
+ * the lg(n) stages followed by the permutation.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Number of steps
+ */
+int radix2_c2c_fft_steps(bina_transform base)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	return self->radix + 1;
+}
+
+/* Number of units (butterflies or permuted pairs) of every step, each unit
+ * costs about the same.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Number of units per step
+ */
+int radix2_c2c_fft_step_units(bina_transform base)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	return (self->fft_length > 1) ? self->fft_length / 2 : 1;
+}
+
+/* Runs a slice of a transform, for callers that spread one transform over
+ * time to bound the work done at once. Running units [0, units) of every
+ * step, in order of steps, leaves the same result in `dst' as
+ * radix2_c2c_fft_execute_on(). Stages ping-pong between `dst' and the
+ * scratch buffer of the plan, ending in `dst' without a copy.
+ *
+ * @base: Pointer to instance of transform object.
+ * @src: Pointer to input buffer, only read by step 0, may equal `dst'.
+ * @dst: Pointer to output buffer.
+ * @step: Step, see radix2_c2c_fft_steps()
+ * @first: First unit of the slice
+ * @count: Number of units, see radix2_c2c_fft_step_units()
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_execute_step(bina_transform base, const bina_complex *src,
+		bina_complex *dst, int step, int first, int count)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+	int last_step = self->radix;
+	const bina_complex *in = NULL;
+	bina_complex *out = NULL;
+
+	if (self->fft_length == 1) {
+		dst[0] = src[0];
+		return 0;
+	}
+
+	/* The last step (the permutation) must land in dst */
+	out = ((last_step - step) % 2 == 0) ? dst : self->temp;
+
+	if (step == 0) {
+		in = src;
+	} else {
+		in = (out == dst) ? self->temp : dst;
+	}
+
+	if (step == last_step) {
+		permute_range(self->permutation, in, out, self->fft_length,
+				first, count);
+	} else {
+		radix2_c2c_fft_stage_range(self, in, out, step, first, count);
+	}
+
+	return 0;
+}
+
+/* Runs butterflies [first, first + count) of a stage, numbered across all
+ * of its DFTs, from `in' to `out'. Unlike radix2_c2c_fft_execute_step(),
+ * the caller owns both buffers, so it can skip butterflies whose results
+ * it never reads.
+ *
+ * @base: Pointer to instance of transform object.
+ * @in: Pointer to input buffer of the stage.
+ * @out: Pointer to output buffer of the stage, not `in'.
+ * @stage: Index of the stage, starting from zero.
+ * @first: First butterfly.
+ * @count: Number of butterflies.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int radix2_c2c_fft_execute_butterflies(bina_transform base,
+		const bina_complex *in, bina_complex *out, int stage,
+		int first, int count)
+{
+	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
+
+	if (stage < 0 || stage >= (int) self->radix) {
+		return -1;
+	}
+
+	radix2_c2c_fft_stage_range(self, in, out, stage, first, count);
+	return 0;
+}
+
+/*
+ * Runs one DIF stage with the butterfly kernel matching the twiddle layout
+ * of the plan.
+ *
+ * @self Transform instance.
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factors of this stage (full table only).
+ * @stage Index of the stage, starting from zero.
+ * @num_dft Number of DFT to perform in current stage.
+ * @num_butterflies Number of butterflies in current stage.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_stage(const struct radix2_c2c_fft *self,
+		bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int stage,
+		int num_dft,
+		int num_butterflies)
+{
+	if (self->compact) {
+		radix2_c2c_fft_butterflies_compact(in, out, self->twiddle,
+				self->twiddle_chunk, self->fft_length / 8,
+				1 << stage, self->sign, num_dft,
+				num_butterflies);
+	} else {
+		radix2_c2c_fft_butterflies(in, out, twiddle, num_dft,
+				num_butterflies);
+	}
+}
+
+/*
+ * Calculates butterflies in stage.
+ *
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @twiddle Pointer to twiddle factor buffer.
+ * @num_dft Number of DFT to perform in current stage.
+ * @num_butterflies Number of butterflies in current stage.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_butterflies(bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int num_dft,
+		int num_butterflies)
+{
+	for (int j = 0; j < num_dft; j++) {
+
+		int offset = (j * num_butterflies) * 2;
+
+		for (int i = 0; i < num_butterflies; i++) {
+
+			int top = i + offset;
+			int bot = i + offset + num_butterflies;
+
+			bina_complex yt = (in[top] + in[bot]);
+			bina_complex yb = (in[top] - in[bot]) * twiddle[i];
+
+			out[top] = yt;
+			out[bot] = yb;
+		}
+
+	}
+
+}
+
+/*
+ * Rebuilds `count' twiddle factors w^k, k = (first + i) * stride, of a DIF
+ * stage from the first octant of the unit circle. A stage only needs
+ * 0 <= k < n/2, which splits into four octants:
+ *
+ *   [0, n/8]:      w^k = ( c,  s) with (c, s) = octant[k]
+ *   (n/8, n/4]:    w^k = ( s,  c) with (c, s) = octant[n/4 - k]
+ *   (n/4, 3n/8]:   w^k = (-s,  c) with (c, s) = octant[k - n/4]
+ *   (3n/8, n/2):   w^k = (-c,  s) with (c, s) = octant[n/2 - k]
+ *
+ * with the imaginary part finally scaled by the sign of the exponent. Each
+ * octant is a separate loop so the loops stay branch free.
+ *
+ * @octant First octant of the unit circle, (cos, sin) pairs (n/8 + 1).
+ * @eighth n/8.
+ * @stride Twiddle step of the stage (2^stage).
+ * @first Index of the first butterfly.
+ * @count Number of twiddle factors to rebuild.
+ * @sign Sign of the exponent, -1.0 for a forward transform.
+ * @dst Destination of the twiddle factors.
+ *
+ * @return None
+ */
+static void expand_twiddle_octant(const bina_complex *octant, int eighth,
+		int stride, int first, int count, double sign,
+		bina_complex *dst)
+{
+	/* Butterfly index one past each of the first three octants */
+	int end0 = eighth / stride + 1;
+	int end1 = (2 * eighth) / stride + 1;
+	int end2 = (3 * eighth) / stride + 1;
+	int last = first + count;
+	int i = first;
+
+	for (; i < end0 && i < last; i++) {
+		bina_complex c = octant[i * stride];
+		*dst++ = creal(c) + sign * cimag(c) * _Complex_I;
+	}
+
+	for (; i < end1 && i < last; i++) {
+		bina_complex c = octant[2 * eighth - i * stride];
+		*dst++ = cimag(c) + sign * creal(c) * _Complex_I;
+	}
+
+	for (; i < end2 && i < last; i++) {
+		bina_complex c = octant[i * stride - 2 * eighth];
+		*dst++ = -cimag(c) + sign * creal(c) * _Complex_I;
+	}
+
+	for (; i < last; i++) {
+		bina_complex c = octant[4 * eighth - i * stride];
+		*dst++ = -creal(c) + sign * cimag(c) * _Complex_I;
+	}
+}
+
+/*
+ * Same as radix2_c2c_fft_butterflies(), but with a compact twiddle table.
+ * The twiddle factors of the stage are rebuilt BINA_FFT_TWIDDLE_CHUNK at a
+ * time into `chunk', and every DFT of the stage is run over that slice
+ * before moving on, so the rebuild cost is paid once per stage.
+ *
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @octant First octant of twiddle factors (n/8 + 1 entries).
+ * @chunk Scratch for BINA_FFT_TWIDDLE_CHUNK twiddle factors.
+ * @eighth n/8.
+ * @stride Twiddle step of this stage (2^stage).
+ * @sign Sign of the exponent, -1.0 for a forward transform.
+ * @num_dft Number of DFT to perform in current stage.
+ * @num_butterflies Number of butterflies in current stage.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_butterflies_compact(bina_complex *in,
+		bina_complex *out,
+		const bina_complex *octant,
+		bina_complex *chunk,
+		int eighth,
+		int stride,
+		double sign,
+		int num_dft,
+		int num_butterflies)
+{
+	for (int first = 0; first < num_butterflies;
+			first += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int count = num_butterflies - first;
+
+		if (count > BINA_FFT_TWIDDLE_CHUNK) {
+			count = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		expand_twiddle_octant(octant, eighth, stride, first, count,
+				sign, chunk);
+
+		for (int j = 0; j < num_dft; j++) {
+
+			int offset = (j * num_butterflies) * 2 + first;
+
+			for (int i = 0; i < count; i++) {
+
+				int top = i + offset;
+				int bot = i + offset + num_butterflies;
+
+				bina_complex yt = (in[top] + in[bot]);
+				bina_complex yb = (in[top] - in[bot]) * chunk[i];
+
+				out[top] = yt;
+				out[bot] = yb;
+			}
+		}
 	}
 
-	return 0;
 }
 
 /*
- * Calculates butterflies in stage.
+ * Runs the first DIF stage on windowed input, x[i] w[i], without writing the
+ * windowed input anywhere.
  *
+ * @self Transform instance.
  * @in Pointer to input buffer.
+ * @window Window, n values.
  * @out Pointer to output buffer.
- * @twiddle Pointer to twiddle factor buffer.
- * @num_dft Number of DFT to perform in current stage.
- * @num_butterflies Number of butterflies in current stage.
  *
  * @return None
  */
-static void radix2_c2c_fft_butterflies(bina_complex *in,
+static void radix2_c2c_fft_first_stage_windowed(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		const double *window,
+		bina_complex *out)
+{
+	int num_butterflies = self->fft_length / 2;
+
+	if (!self->compact) {
+		radix2_c2c_fft_windowed_segment(in, window, out, self->twiddle,
+				0, num_butterflies, num_butterflies);
+		return;
+	}
+
+	for (int first = 0; first < num_butterflies;
+			first += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int count = num_butterflies - first;
+
+		if (count > BINA_FFT_TWIDDLE_CHUNK) {
+			count = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		expand_twiddle_octant(self->twiddle, self->fft_length / 8, 1,
+				first, count, self->sign, self->twiddle_chunk);
+		radix2_c2c_fft_windowed_segment(in, window, out,
+				self->twiddle_chunk, first, num_butterflies,
+				count);
+	}
+}
+
+/*
+ * Same as radix2_c2c_fft_butterfly_segment(), with both inputs of each
+ * butterfly multiplied by the window first.
+ *
+ * @in Pointer to input buffer.
+ * @window Window, indexed like `in'.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factor of each butterfly.
+ * @top Index of the top input of the first butterfly.
+ * @distance Distance from the top to the bottom input.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_windowed_segment(const bina_complex *in,
+		const double *window,
 		bina_complex *out,
 		const bina_complex *twiddle,
-		int num_dft,
-		int num_butterflies)
+		int top,
+		int distance,
+		int count)
 {
-	for (int j = 0; j < num_dft; j++) {
+	for (int i = 0; i < count; i++) {
 
-		int offset = (j * num_butterflies) * 2;
+		int t = top + i;
+		int b = t + distance;
 
-		for (int i = 0; i < num_butterflies; i++) {
+		bina_complex xt = in[t] * window[t];
+		bina_complex xb = in[b] * window[b];
 
-			int top = i + offset;
-			int bot = i + offset + num_butterflies;
+		out[t] = xt + xb;
+		out[b] = (xt - xb) * twiddle[i];
+	}
+}
 
-			bina_complex yt = (in[top] + in[bot]);
-			bina_complex yb = (in[top] - in[bot]) * twiddle[i];
+/*
+ * First stage of a frame given as two segments, see
+ * bina_transform_execute_segments(). The butterflies split into at most
+ * three runs, at the ends of the head as seen by their top and bottom
+ * inputs, and each run reads both inputs from one segment or the other.
+ *
+ * @self Transform instance.
+ * @head First `head_length' points, 0 < head_length < n.
+ * @head_length Number of points at `head'.
+ * @tail The other points.
+ * @out Pointer to output buffer.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out)
+{
+	int num_butterflies = self->fft_length / 2;
+	int ends[3] = { head_length, head_length - num_butterflies,
+		num_butterflies };
+
+	for (int first = 0; first < num_butterflies;) {
+
+		int last = num_butterflies;
+		int bot = first + num_butterflies;
+		const bina_complex *top_in = (first < head_length) ?
+			head + first : tail + (first - head_length);
+		const bina_complex *bot_in = (bot < head_length) ?
+			head + bot : tail + (bot - head_length);
+
+		for (int e = 0; e < 3; e++) {
+			if (ends[e] > first && ends[e] < last) {
+				last = ends[e];
+			}
+		}
 
-			out[top] = yt;
-			out[bot] = yb;
+		if (!self->compact) {
+			radix2_c2c_fft_pair_segment(top_in, bot_in, out,
+					self->twiddle + first, first,
+					num_butterflies, last - first);
+		}
+
+		for (int done = 0; self->compact && done < last - first;
+				done += BINA_FFT_TWIDDLE_CHUNK) {
+
+			int chunk = last - first - done;
+
+			if (chunk > BINA_FFT_TWIDDLE_CHUNK) {
+				chunk = BINA_FFT_TWIDDLE_CHUNK;
+			}
+
+			expand_twiddle_octant(self->twiddle,
+					self->fft_length / 8, 1, first + done,
+					chunk, self->sign, self->twiddle_chunk);
+			radix2_c2c_fft_pair_segment(top_in + done,
+					bot_in + done, out,
+					self->twiddle_chunk, first + done,
+					num_butterflies, chunk);
+		}
+
+		first = last;
+	}
+}
+
+/*
+ * Same as radix2_c2c_fft_butterfly_segment(), with the top and bottom
+ * inputs read from buffers of their own.
+ *
+ * @top_in Top input of each butterfly.
+ * @bot_in Bottom input of each butterfly.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factor of each butterfly.
+ * @top Index of the top output of the first butterfly.
+ * @distance Distance from the top to the bottom output.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_pair_segment(const bina_complex *top_in,
+		const bina_complex *bot_in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count)
+{
+	for (int i = 0; i < count; i++) {
+
+		bina_complex xt = top_in[i];
+		bina_complex xb = bot_in[i];
+
+		out[top + i] = xt + xb;
+		out[top + distance + i] = (xt - xb) * twiddle[i];
+	}
+}
+
+/*
+ * Runs a DIF stage whose inputs are zero past the first 2^lg_m entries of
+ * each of its DFTs, with 2^lg_m no more than half a DFT. The bottom input of
+ * every butterfly is zero, so a butterfly reduces to a copy and a rotation,
+ * and only the first 2^lg_m of them have nonzero inputs at all. Their
+ * outputs are exactly the nonzero inputs of the next stage, and fill it
+ * completely after the last such stage.
+ *
+ * @self Transform instance.
+ * @in Pointer to input buffer.
+ * @window Window of the first stage, or NULL for none.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factors of this stage (full table only).
+ * @stage Index of the stage, starting from zero.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_replicate_stage(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		const double *window,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int stage)
+{
+	int fft_length = self->fft_length;
+	int num_butterflies = fft_length >> (stage + 1);
+	int num_dft = 1 << stage;
+	int nonzero = fft_length >> self->replicate_stages;
+
+	for (int first = 0; first < nonzero;
+			first += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int count = nonzero - first;
+		const bina_complex *tw = twiddle + first;
+
+		if (count > BINA_FFT_TWIDDLE_CHUNK) {
+			count = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		if (self->compact) {
+			expand_twiddle_octant(self->twiddle, fft_length / 8,
+					1 << stage, first, count, self->sign,
+					self->twiddle_chunk);
+			tw = self->twiddle_chunk;
+		}
+
+		for (int j = 0; j < num_dft; j++) {
+			int top = j * 2 * num_butterflies + first;
+
+			radix2_c2c_fft_replicate_segment(in + top,
+					window ? window + top : NULL, out, tw,
+					top, num_butterflies, count);
+		}
+	}
+}
+
+/*
+ * Calculates `count' consecutive butterflies of one DFT whose bottom inputs
+ * are zero.
+ *
+ * @in Top input of each butterfly.
+ * @window Window, indexed like `in', or NULL for none.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factor of each butterfly.
+ * @top Index of the top input of the first butterfly.
+ * @distance Distance from the top to the bottom input.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_replicate_segment(const bina_complex *in,
+		const double *window,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count)
+{
+	for (int i = 0; i < count; i++) {
+
+		int t = top + i;
+		bina_complex x = window ? in[i] * window[i] : in[i];
+
+		out[t] = x;
+		out[t + distance] = x * twiddle[i];
+	}
+}
+
+/*
+ * First stage of a zero padded frame given as two segments, see
+ * bina_transform_execute_segments(). Only the top inputs are read, those
+ * up to the end of the head from it and the others from the tail.
+ *
+ * @self Transform instance.
+ * @head First `head_length' points, 0 < head_length < n.
+ * @head_length Number of points at `head'.
+ * @tail The other points.
+ * @out Pointer to output buffer.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_replicate_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out)
+{
+	int fft_length = self->fft_length;
+	int nonzero = fft_length >> self->replicate_stages;
+
+	for (int first = 0; first < nonzero;
+			first += BINA_FFT_TWIDDLE_CHUNK) {
+
+		int count = nonzero - first;
+		int split = head_length - first;
+		const bina_complex *tw = self->twiddle + first;
+
+		if (count > BINA_FFT_TWIDDLE_CHUNK) {
+			count = BINA_FFT_TWIDDLE_CHUNK;
+		}
+
+		split = (split < 0) ? 0 : (split > count) ? count : split;
+
+		if (self->compact) {
+			expand_twiddle_octant(self->twiddle, fft_length / 8, 1,
+					first, count, self->sign,
+					self->twiddle_chunk);
+			tw = self->twiddle_chunk;
+		}
+
+		if (split > 0) {
+			radix2_c2c_fft_replicate_segment(head + first, NULL,
+					out, tw, first, fft_length / 2, split);
+		}
+
+		if (split < count) {
+			radix2_c2c_fft_replicate_segment(
+					tail + (first + split - head_length),
+					NULL, out, tw + split, first + split,
+					fft_length / 2, count - split);
+		}
+	}
+}
+
+/*
+ * Runs butterflies [first, first + count) of a DIF stage, numbered across
+ * all of its DFTs.
+ *
+ * @self Transform instance.
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @stage Index of the stage, starting from zero.
+ * @first First butterfly.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_stage_range(const struct radix2_c2c_fft *self,
+		const bina_complex *in,
+		bina_complex *out,
+		int stage,
+		int first,
+		int count)
+{
+	int fft_length = self->fft_length;
+	int num_butterflies = fft_length >> (stage + 1);
+	/* Stages before this one used n/2 + n/4 + ... factors */
+	const bina_complex *tw = self->twiddle
+		+ (fft_length - (fft_length >> stage));
+	int last = first + count;
+
+	for (int b = first; b < last;) {
+
+		int i = b % num_butterflies;
+		int top = (b / num_butterflies) * 2 * num_butterflies + i;
+		int n = num_butterflies - i;
+
+		if (n > last - b) {
+			n = last - b;
+		}
+
+		if (!self->compact) {
+			radix2_c2c_fft_butterfly_segment(in, out, tw + i, top,
+					num_butterflies, n);
+		}
+
+		for (int done = 0; self->compact && done < n;
+				done += BINA_FFT_TWIDDLE_CHUNK) {
+
+			int chunk = n - done;
+
+			if (chunk > BINA_FFT_TWIDDLE_CHUNK) {
+				chunk = BINA_FFT_TWIDDLE_CHUNK;
+			}
+
+			expand_twiddle_octant(self->twiddle, fft_length / 8,
+					1 << stage, i + done, chunk,
+					self->sign, self->twiddle_chunk);
+			radix2_c2c_fft_butterfly_segment(in, out,
+					self->twiddle_chunk, top + done,
+					num_butterflies, chunk);
 		}
 
+		b += n;
+	}
+}
+
+/*
+ * Calculates `count' consecutive butterflies of one DFT.
+ *
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @twiddle Twiddle factor of each butterfly.
+ * @top Index of the top input of the first butterfly.
+ * @distance Distance from the top to the bottom input.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_butterfly_segment(const bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count)
+{
+	for (int i = 0; i < count; i++) {
+
+		int t = top + i;
+		int b = t + distance;
+
+		bina_complex yt = (in[t] + in[b]);
+		bina_complex yb = (in[t] - in[b]) * twiddle[i];
+
+		out[t] = yt;
+		out[b] = yb;
+	}
+}
+
+/* Runs the first DIT stage (stage lg(n) - 1) of a scrambled inverse on a
+ * frame given as two segments, see bina_transform_execute_segments(). The
+ * butterflies join neighbouring points, so at most one of them straddles
+ * the two segments.
+ *
+ * @self: Transform instance, of two points or more
+ * @head: First points of the frame.
+ * @head_length: Number of points at `head', 1 to n - 1.
+ * @tail: The other n - head_length points.
+ * @out: Output of the stage, n points, not overlapping the segments.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_dit_first_stage_segments(
+		const struct radix2_c2c_fft *self,
+		const bina_complex *head,
+		int head_length,
+		const bina_complex *tail,
+		bina_complex *out)
+{
+	int even = head_length & ~1;
+	int straddle = head_length & 1;
+
+	radix2_c2c_fft_dit_pairs(head, out, even);
+
+	if (straddle) {
+		bina_complex pair[2] = { head[even], tail[0] };
+
+		radix2_c2c_fft_dit_pairs(pair, out + even, 2);
+	}
+
+	radix2_c2c_fft_dit_pairs(tail + straddle,
+			out + head_length + straddle,
+			self->fft_length - head_length - straddle);
+}
+
+/*
+ * Calculates the butterflies of the first DIT stage over `count' points,
+ * which join neighbouring points with the twiddle factor 1.
+ *
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @count Number of points, even.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_dit_pairs(const bina_complex *in,
+		bina_complex *out,
+		int count)
+{
+	for (int t = 0; t < count; t += 2) {
+
+		bina_complex yt = in[t];
+		bina_complex yb = in[t + 1];
+
+		out[t] = yt + yb;
+		out[t + 1] = yt - yb;
 	}
+}
+
+/*
+ * Calculates `count' consecutive decimation in time butterflies of one DFT,
+ * see radix2_c2c_fft_execute_dit().
+ *
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer, may equal `in'.
+ * @twiddle Twiddle factor of each butterfly.
+ * @top Index of the top input of the first butterfly.
+ * @distance Distance from the top to the bottom input.
+ * @count Number of butterflies.
+ *
+ * @return None
+ */
+static void radix2_c2c_fft_dit_segment(const bina_complex *in,
+		bina_complex *out,
+		const bina_complex *twiddle,
+		int top,
+		int distance,
+		int count)
+{
+	for (int i = 0; i < count; i++) {
 
+		int t = top + i;
+		int b = t + distance;
+
+		bina_complex yt = in[t];
+		bina_complex yb = in[b] * twiddle[i];
+
+		out[t] = yt + yb;
+		out[b] = yt - yb;
+	}
 }
 
 /* Reshuffles FFT output in the bit-reversed order that is precomputed
@@ -386,13 +2158,76 @@ static void permute_buffer(const unsigned int *pvec, bina_complex *in,
 		int even_index = 2 * i;
 		int odd_index = 2 * i + 1;
 		int even_index_rev = pvec[i];
-		int odd_index_rev = even_index | 0x00000001;
+		int odd_index_rev = even_index_rev + pvec_length;
 
 		out[even_index] = in[even_index_rev];
 		out[odd_index] = in[odd_index_rev];
 	}
 }
 
+/* Same as permute_buffer(), but writes the power of each bin, optionally in
+ * decibels (floored at the smallest normal double to stay finite).
+ *
+ * @pvec Bit-reversed look up table.
+ * @in Pointer to input buffer.
+ * @power Pointer to output power buffer.
+ * @length Self explanatory.
+ * @log_scale Nonzero for 10 lg |X|^2.
+ *
+ * @returns Nothing.
+ */
+static void permute_power(const unsigned int *pvec, const bina_complex *in,
+		double *power, int length, int log_scale)
+{
+	int pvec_length = length / 2;
+
+	if (length == 1) {
+		power[0] = creal(in[0]) * creal(in[0])
+			+ cimag(in[0]) * cimag(in[0]);
+	}
+
+	for (int i = 0; i < pvec_length; i++) {
+		bina_complex even = in[pvec[i]];
+		bina_complex odd = in[pvec[i] + pvec_length];
+
+		power[2 * i] = creal(even) * creal(even)
+			+ cimag(even) * cimag(even);
+		power[2 * i + 1] = creal(odd) * creal(odd)
+			+ cimag(odd) * cimag(odd);
+	}
+
+	if (log_scale) {
+		for (int i = 0; i < length; i++) {
+			power[i] = 10.0 * log10(fmax(power[i], DBL_MIN));
+		}
+	}
+}
+
+/* Same as permute_buffer(), for entries [first, first + count) of the
+ * look up table only.
+ *
+ * @pvec Bit-reversed look up table.
+ * @in Pointer to input buffer.
+ * @out Pointer to output buffer.
+ * @length Length of the buffers.
+ * @first First table entry.
+ * @count Number of table entries.
+ *
+ * @returns Nothing.
+ */
+static void permute_range(const unsigned int *pvec, const bina_complex *in,
+		bina_complex *out, int length, int first, int count)
+{
+	int pvec_length = length / 2;
+
+	for (int i = first; i < first + count; i++) {
+		int even_index_rev = pvec[i];
+
+		out[2 * i] = in[even_index_rev];
+		out[2 * i + 1] = in[even_index_rev + pvec_length];
+	}
+}
+
 /* Helper function to free the transform class.
  *
  * @base: Pointer to instance of transform object.
@@ -402,10 +2237,11 @@ static void permute_buffer(const unsigned int *pvec, bina_complex *in,
 static int free_class(bina_transform base)
 {
 	struct radix2_c2c_fft *self = (struct radix2_c2c_fft *) base;
-	aligned_free(self->twiddle);
-	aligned_free(self->permutation);
-	aligned_free(self->temp);
-	free(self);
+
+	/* The instance lives in its own arena, copy the handle out first */
+	struct arena arena = self->arena;
+
+	arena_release(&arena);
 	return 0;
 }
 
@@ -0,0 +1,255 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_radix2_c2c_fft_2d.c - Two dimensional radix-2 complex FFT,
+* done as row transforms followed by column transforms.
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Side of the square tiles the columns are transposed in */
+#ifndef BINA_FFT_TRANSPOSE_TILE
+#define BINA_FFT_TRANSPOSE_TILE (16)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct radix2_c2c_fft_2d {
+	struct bina_transform type;     /* Base class */
+
+	unsigned int rows;              /* Number of rows */
+
+	unsigned int columns;           /* Number of columns (row length) */
+
+	bina_complex *in;               /* Pointer to input buffer, row-major */
+
+	bina_complex *out;              /* Pointer to output buffer, row-major */
+
+	bina_transform row_fft;         /* `columns' point transform */
+
+	bina_transform column_fft;      /* `rows' point transform */
+
+	unsigned char *columns_buffer;  /* Transposed copy of the columns, one
+					 * per row of `pitch' bytes, see
+					 * aligned_pitched_calloc().
+					 */
+
+	size_t pitch;                   /* Row pitch of `columns_buffer' */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static int radix2_c2c_fft_2d_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+static void gather_columns(struct radix2_c2c_fft_2d *self,
+		const bina_complex *src);
+
+static void scatter_columns(struct radix2_c2c_fft_2d *self,
+		bina_complex *dst);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a two dimensional radix-2 complex-to-complex FFT transform class.
+ *
+ * @in: Pointer to input buffer, `rows' x `columns' row-major
+ * @out: Pointer to output buffer, may equal `in'
+ * @rows: Number of rows (MUST be power of two)
+ * @columns: Number of columns (MUST be power of two)
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE and BINA_FFT_INVERSE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_radix2_c2c_fft_2d(bina_complex *in,
+		bina_complex *out, int rows, int columns, int flags)
+{
+	struct radix2_c2c_fft_2d *self = NULL;
+
+	if (!ispowtwo(rows) || !ispowtwo(columns)) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct radix2_c2c_fft_2d))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(radix2_c2c_fft_2d_exec);
+	self->type.free = &(free_class);
+	self->rows = rows;
+	self->columns = columns;
+	self->in = in;
+	self->out = out;
+	flags &= BINA_FFT_COMPACT_TWIDDLE | BINA_FFT_INVERSE;
+
+	self->row_fft = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+			columns, flags);
+	self->column_fft = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+			rows, flags);
+
+	/* The columns are stored as rows of a padded 2-D array, so walking
+	 * down a tile of them does not keep hitting the same cache sets.
+	 */
+	self->columns_buffer = aligned_pitched_calloc(BINA_FFT_ALIGNMENT,
+			columns, rows, sizeof(bina_complex),
+			ALIGNED_PITCH_AVOID_ALIASING, &self->pitch);
+
+	if (self->row_fft == NULL || self->column_fft == NULL
+			|| self->columns_buffer == NULL) {
+		log_error("Allocating 2-D transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Function to execute the two dimensional FFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int radix2_c2c_fft_2d_exec(bina_transform base)
+{
+	struct radix2_c2c_fft_2d *self = (struct radix2_c2c_fft_2d *) base;
+	unsigned int rows = self->rows;
+	unsigned int columns = self->columns;
+
+	/* Rows are contiguous, transform them straight into the output */
+	for (unsigned int r = 0; r < rows; r++) {
+		radix2_c2c_fft_execute_on(self->row_fft,
+				self->in + (size_t) r * columns,
+				self->out + (size_t) r * columns);
+	}
+
+	/* Columns are transposed into contiguous rows, transformed in place,
+	 * and transposed back.
+	 */
+	gather_columns(self, self->out);
+
+	for (unsigned int c = 0; c < columns; c++) {
+		bina_complex *col = (bina_complex *)
+			(self->columns_buffer + c * self->pitch);
+
+		radix2_c2c_fft_execute_on(self->column_fft, col, col);
+	}
+
+	scatter_columns(self, self->out);
+
+	return 0;
+}
+
+/* Copies the columns of a row-major array into the rows of the columns
+ * buffer, a tile at a time.
+ *
+ * @self: Transform instance
+ * @src: Row-major array
+ *
+ * @return None
+ */
+static void gather_columns(struct radix2_c2c_fft_2d *self,
+		const bina_complex *src)
+{
+	const unsigned int tile = BINA_FFT_TRANSPOSE_TILE;
+	unsigned int rows = self->rows;
+	unsigned int columns = self->columns;
+
+	for (unsigned int r0 = 0; r0 < rows; r0 += tile) {
+		unsigned int r1 = (r0 + tile < rows) ? r0 + tile : rows;
+
+		for (unsigned int c0 = 0; c0 < columns; c0 += tile) {
+			unsigned int c1 = (c0 + tile < columns) ?
+				c0 + tile : columns;
+
+			for (unsigned int c = c0; c < c1; c++) {
+				bina_complex *col = (bina_complex *)
+					(self->columns_buffer
+					 + c * self->pitch);
+
+				for (unsigned int r = r0; r < r1; r++) {
+					col[r] = src[(size_t) r * columns + c];
+				}
+			}
+		}
+	}
+}
+
+/* Inverse of gather_columns().
+ *
+ * @self: Transform instance
+ * @dst: Row-major array
+ *
+ * @return None
+ */
+static void scatter_columns(struct radix2_c2c_fft_2d *self,
+		bina_complex *dst)
+{
+	const unsigned int tile = BINA_FFT_TRANSPOSE_TILE;
+	unsigned int rows = self->rows;
+	unsigned int columns = self->columns;
+
+	for (unsigned int r0 = 0; r0 < rows; r0 += tile) {
+		unsigned int r1 = (r0 + tile < rows) ? r0 + tile : rows;
+
+		for (unsigned int c0 = 0; c0 < columns; c0 += tile) {
+			unsigned int c1 = (c0 + tile < columns) ?
+				c0 + tile : columns;
+
+			for (unsigned int r = r0; r < r1; r++) {
+				for (unsigned int c = c0; c < c1; c++) {
+					const bina_complex *col =
+						(const bina_complex *)
+						(self->columns_buffer
+						 + c * self->pitch);
+
+					dst[(size_t) r * columns + c] = col[r];
+				}
+			}
+		}
+	}
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct radix2_c2c_fft_2d *self = (struct radix2_c2c_fft_2d *) base;
+
+	if (self->row_fft) {
+		bina_transform_free(self->row_fft);
+	}
+
+	if (self->column_fft) {
+		bina_transform_free(self->column_fft);
+	}
+
+	aligned_free(self->columns_buffer);
+	free(self);
+	return 0;
+}
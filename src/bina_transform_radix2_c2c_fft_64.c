@@ -0,0 +1,286 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_radix2_c2c_fft_64.c - Radix-2 complex FFT with a size_t
+* length. Lengths up to 2^20 points (16 MB) go to the plain transform,
+* whose stages run depth first once they leave L2; larger ones are split
+* into N = N1 N2 with the four step algorithm, which keeps every
+* one dimensional transform at most 2^30 points and walks memory in blocks:
+*
+*   x[n1 + N1 n2], a matrix of N2 rows of N1 points:
+*   1. N1 column transforms of N2 points, Z[k2][n1]
+*   2. Z[k2][n1] *= w_N^(n1 k2)
+*   3. N2 row transforms of N1 points, written transposed, to
+*      X[N2 k1 + k2]
+*
+* All whole array offsets, including the twiddle exponent n1 k2 < N, are
+* 64-bit. The tables and plans are shared with the out-of-core transform,
+* see four_step.c.
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/four_step.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Shortest length split into four steps, 16 MB of points: far out of L2,
+ * but shorter lengths run the plain transform, whose stages go depth first
+ * once they leave it.
+ */
+#ifndef BINA_FFT_FOUR_STEP_LENGTH
+#define BINA_FFT_FOUR_STEP_LENGTH ((size_t) 1 << 20)
+#endif
+
+/* Longest length, both factors stay within the plain transform */
+#define BINA_FFT_MAX_LENGTH_64 ((size_t) 1 << 60)
+
+/* Columns or rows moved per block, 8 points fill two cache lines */
+#ifndef BINA_FFT_FOUR_STEP_BLOCK
+#define BINA_FFT_FOUR_STEP_BLOCK (8)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct four_step_fft {
+	struct bina_transform type;     /* Base class */
+
+	struct four_step steps;         /* Tables, plans, and a block of
+					 * BLOCK transforms of max(N1, N2)
+					 * points per worker */
+
+	bina_complex *in;               /* N points */
+
+	bina_complex *out;              /* N points */
+
+	bina_complex *work;             /* N points when in place, else NULL */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void columns_pass(struct four_step_fft *self,
+		struct four_step_worker *worker, bina_complex *mid,
+		size_t first);
+
+static void rows_pass(struct four_step_fft *self,
+		struct four_step_worker *worker, const bina_complex *mid,
+		size_t first);
+
+static int four_step_fft_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a radix-2 FFT class with a 64-bit length. Lengths up to
+ * BINA_FFT_FOUR_STEP_LENGTH give the plain transform.
+ *
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer. Out of place, the input is overwritten;
+ *       in place, the class keeps a work buffer of `fft_length' points.
+ * @fft_length: Length of the problem (MUST be power of two, up to 2^60)
+ * @flags: Extra flags, BINA_FFT_INVERSE and BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_radix2_c2c_fft_64(bina_complex *in,
+		bina_complex *out, size_t fft_length, int flags)
+{
+	struct four_step_fft *self = NULL;
+	int sub_flags = flags & (BINA_FFT_INVERSE | BINA_FFT_COMPACT_TWIDDLE);
+	size_t columns, rows;
+
+	if (fft_length == 0 || (fft_length & (fft_length - 1)) != 0
+			|| fft_length > BINA_FFT_MAX_LENGTH_64) {
+		log_error("Length is not power of two up to 2^60\n");
+		return NULL;
+	}
+
+	if (fft_length <= BINA_FFT_FOUR_STEP_LENGTH) {
+		return bina_transform_create_radix2_c2c_fft(in, out,
+				(int) fft_length, sub_flags);
+	}
+
+	if ((self = calloc(1, sizeof(struct four_step_fft))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	self->type.execute = &(four_step_fft_exec);
+	self->type.free = &(free_class);
+	self->in = in;
+	self->out = out;
+
+	if (in == out) {
+		self->work = aligned_malloc(BINA_FFT_ALIGNMENT, fft_length,
+				sizeof(bina_complex));
+	}
+
+	four_step_split(fft_length, &columns, &rows);
+
+	if ((in == out && self->work == NULL)
+			|| four_step_create(&self->steps, fft_length, sub_flags,
+				BINA_FFT_FOUR_STEP_BLOCK * rows) != 0) {
+		log_error("Allocating four step transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Steps 1 and 2 for the columns first to first + BLOCK: gathers them,
+ * transforms them, rotates them, and scatters them to `mid'.
+ *
+ * @self: Transform instance
+ * @worker: Plans and block buffer of the calling thread
+ * @mid: N points, row-major like the input
+ * @first: First column
+ *
+ * @return None
+ */
+static void columns_pass(struct four_step_fft *self,
+		struct four_step_worker *worker, bina_complex *mid,
+		size_t first)
+{
+	const size_t columns = self->steps.columns;
+	const size_t rows = self->steps.rows;
+	bina_complex *block = worker->buffer;
+
+	for (size_t r = 0; r < rows; r++) {
+		const bina_complex *src = self->in + r * columns + first;
+
+		for (size_t b = 0; b < BINA_FFT_FOUR_STEP_BLOCK; b++) {
+			block[b * rows + r] = src[b];
+		}
+	}
+
+	for (size_t b = 0; b < BINA_FFT_FOUR_STEP_BLOCK; b++) {
+		bina_complex *col = block + b * rows;
+
+		radix2_c2c_fft_execute_on(worker->column_fft, col, col);
+		four_step_rotate(&self->steps, col, first + b);
+	}
+
+	for (size_t r = 0; r < rows; r++) {
+		bina_complex *dst = mid + r * columns + first;
+
+		for (size_t b = 0; b < BINA_FFT_FOUR_STEP_BLOCK; b++) {
+			dst[b] = block[b * rows + r];
+		}
+	}
+}
+
+/* Step 3 for the rows first to first + BLOCK: transforms them and writes
+ * them transposed to the output.
+ *
+ * @self: Transform instance
+ * @worker: Plans and block buffer of the calling thread
+ * @mid: N points from columns_pass()
+ * @first: First row
+ *
+ * @return None
+ */
+static void rows_pass(struct four_step_fft *self,
+		struct four_step_worker *worker, const bina_complex *mid,
+		size_t first)
+{
+	const size_t columns = self->steps.columns;
+	const size_t rows = self->steps.rows;
+	bina_complex *block = worker->buffer;
+
+	for (size_t b = 0; b < BINA_FFT_FOUR_STEP_BLOCK; b++) {
+		radix2_c2c_fft_execute_on(worker->row_fft,
+				(bina_complex *) mid + (first + b) * columns,
+				block + b * columns);
+	}
+
+	for (size_t k1 = 0; k1 < columns; k1++) {
+		bina_complex *dst = self->out + k1 * rows + first;
+
+		for (size_t b = 0; b < BINA_FFT_FOUR_STEP_BLOCK; b++) {
+			dst[b] = block[b * columns + k1];
+		}
+	}
+}
+
+/* Function to execute a four step FFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int four_step_fft_exec(bina_transform base)
+{
+	struct four_step_fft *self = (struct four_step_fft *) base;
+	bina_complex *mid = self->work ? self->work : self->in;
+	const size_t block = BINA_FFT_FOUR_STEP_BLOCK;
+	int64_t column_blocks = (int64_t) (self->steps.columns / block);
+	int64_t row_blocks = (int64_t) (self->steps.rows / block);
+
+#	ifdef _OPENMP
+#	pragma omp parallel num_threads(self->steps.num_workers)
+#	endif
+	{
+		int t = 0;
+
+#		ifdef _OPENMP
+		t = omp_get_thread_num();
+#		endif
+
+		struct four_step_worker *worker = &self->steps.workers[t];
+
+#		ifdef _OPENMP
+#		pragma omp for schedule(static)
+#		endif
+		for (int64_t j = 0; j < column_blocks; j++) {
+			columns_pass(self, worker, mid, (size_t) j * block);
+		}
+
+#		ifdef _OPENMP
+#		pragma omp for schedule(static)
+#		endif
+		for (int64_t j = 0; j < row_blocks; j++) {
+			rows_pass(self, worker, mid, (size_t) j * block);
+		}
+	}
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct four_step_fft *self = (struct four_step_fft *) base;
+
+	four_step_release(&self->steps);
+	aligned_free(self->work);
+	free(self);
+
+	return 0;
+}
@@ -0,0 +1,361 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* bina_transform_radix2_r2c_fft.c - Real-to-complex FFT and its inverse,
+* complex-to-real, on top of a half length complex transform.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bina_transform.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/radix2_r2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct radix2_r2c_fft {
+	struct bina_transform type;     /* Base class */
+
+	unsigned int fft_length;        /* Number of real points */
+
+	int inverse;                    /* Nonzero for complex-to-real */
+
+	void *in;                       /* Real samples (r2c) or n/2 + 1
+					 * bins (c2r).
+					 */
+
+	void *out;                      /* n/2 + 1 bins (r2c) or real
+					 * samples (c2r).
+					 */
+
+	bina_transform half;            /* n/2 point complex transform */
+
+	bina_complex *twiddle;          /* exp(-2 pi i k / n), 0 <= k <= n/4 */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static struct radix2_r2c_fft *create_class(void *in, void *out,
+		int fft_length, int flags, int inverse);
+
+static int radix2_r2c_fft_exec(bina_transform);
+
+static int radix2_c2r_fft_exec(bina_transform);
+
+static int free_class(bina_transform);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates a radix-2 real-to-complex FFT transform class. Only the n/2 + 1
+ * bins of the non-negative frequencies are computed; the others are their
+ * complex conjugates.
+ *
+ * @in: Pointer to input buffer, `fft_length' real samples
+ * @out: Pointer to output buffer, `fft_length' / 2 + 1 bins
+ * @fft_length: Length of the problem (MUST be power of two, at least 2)
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE and
+ *         BINA_FFT_NONZERO_INPUTS(lg_m), which reads the first 2^lg_m
+ *         samples, but at least two
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_radix2_r2c_fft(bina_real *in,
+		bina_complex *out, int fft_length, int flags)
+{
+	int lg_m = ((flags & BINA_FFT_NONZERO_INPUTS_MASK) >> 16) - 1;
+
+	flags &= BINA_FFT_COMPACT_TWIDDLE;
+
+	/* Sample pairs are packed into one complex point */
+	if (lg_m >= 0) {
+		flags |= BINA_FFT_NONZERO_INPUTS(lg_m > 0 ? lg_m - 1 : 0);
+	}
+
+	return create_class(in, out, fft_length, flags, 0);
+}
+
+/* Allocates a radix-2 complex-to-real FFT transform class, the inverse of
+ * bina_transform_create_radix2_r2c_fft() without the 1/n scaling. The input
+ * is left untouched.
+ *
+ * @in: Pointer to input buffer, `fft_length' / 2 + 1 bins
+ * @out: Pointer to output buffer, `fft_length' real samples
+ * @fft_length: Length of the problem (MUST be power of two, at least 2)
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_radix2_c2r_fft(bina_complex *in,
+		bina_real *out, int fft_length, int flags)
+{
+	flags &= BINA_FFT_COMPACT_TWIDDLE;
+	return create_class(in, out, fft_length, flags | BINA_FFT_INVERSE, 1);
+}
+
+/* Allocates the class with all of its buffers.
+ *
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer
+ * @fft_length: Length of the problem
+ * @flags: Flags of the half length complex transform
+ * @inverse: Nonzero for complex-to-real
+ *
+ * @returns A new transform class
+ */
+static struct radix2_r2c_fft *create_class(void *in, void *out,
+		int fft_length, int flags, int inverse)
+{
+	struct radix2_r2c_fft *self = NULL;
+
+	if (!ispowtwo(fft_length) || fft_length < 2) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct radix2_r2c_fft))) == NULL) {
+		log_error("Allocating tranform object instance\n");
+		return NULL;
+	}
+
+	self->type.execute = inverse ? &(radix2_c2r_fft_exec)
+		: &(radix2_r2c_fft_exec);
+	self->type.free = &(free_class);
+	self->fft_length = fft_length;
+	self->inverse = inverse;
+	self->in = in;
+	self->out = out;
+
+	self->half = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+			fft_length / 2, flags);
+	self->twiddle = aligned_malloc(BINA_FFT_ALIGNMENT,
+			RADIX2_R2C_FFT_PAIRS(fft_length), sizeof(bina_complex));
+
+	if (self->half == NULL || self->twiddle == NULL) {
+		log_error("Allocating real transform buffers\n");
+		free_class(self);
+		return NULL;
+	}
+
+	radix2_r2c_fft_fill_twiddle(self->twiddle, fft_length);
+
+	return self;
+}
+
+/* Fills the twiddle factors of the split and merge passes.
+ *
+ * @twiddle: Destination, RADIX2_R2C_FFT_PAIRS(fft_length) entries
+ * @fft_length: Number of real points
+ *
+ * @return None
+ */
+void radix2_r2c_fft_fill_twiddle(bina_complex *twiddle, int fft_length)
+{
+	const double step = 2.0 * M_PI / fft_length;
+
+	for (int k = 0; k < RADIX2_R2C_FFT_PAIRS(fft_length); k++) {
+		twiddle[k] = cos(step * k) - sin(step * k) * I;
+	}
+}
+
+/* Turns the n/2 point transform Z of the (even, odd) sample pairs into the
+ * spectrum X of the real signal, in place. With E and O the spectra of the
+ * even and odd samples,
+ *
+ *   E[k] = (Z[k] + conj(Z[n/2 - k])) / 2
+ *   O[k] = (Z[k] - conj(Z[n/2 - k])) / 2i
+ *   X[k] = E[k] + w^k O[k],  X[n/2 - k] = conj(E[k] - w^k O[k])
+ *
+ * so bins k and n/2 - k are made together, one unit per pair.
+ *
+ * @spectrum: Z in the first n/2 entries, X (n/2 + 1 entries) on return
+ * @twiddle: See radix2_r2c_fft_fill_twiddle()
+ * @fft_length: Number of real points
+ * @first: First pair, 0 <= k <= n/4
+ * @count: Number of pairs
+ *
+ * @return None
+ */
+void radix2_r2c_fft_split(bina_complex *spectrum,
+		const bina_complex *twiddle, int fft_length,
+		int first, int count)
+{
+	int half = fft_length / 2;
+	int k = first;
+
+	if (k == 0 && count > 0) {
+		bina_complex z = spectrum[0];
+
+		spectrum[0] = creal(z) + cimag(z);
+		spectrum[half] = creal(z) - cimag(z);
+		k++;
+	}
+
+	for (; k < first + count; k++) {
+		bina_complex a = spectrum[k];
+		bina_complex b = conj(spectrum[half - k]);
+		bina_complex e = (a + b) * 0.5;
+		bina_complex o = (a - b) * (-0.5 * I);
+		bina_complex wo = twiddle[k] * o;
+
+		spectrum[k] = e + wo;
+		spectrum[half - k] = conj(e - wo);
+	}
+}
+
+/* Same as radix2_r2c_fft_split() over all pairs, but instead of storing the
+ * spectrum adds its weighted power to an accumulator, power[k] += weight
+ * |X[k]|^2. The spectrum is never stored.
+ *
+ * @spectrum: Z, n/2 entries (not modified)
+ * @twiddle: See radix2_r2c_fft_fill_twiddle()
+ * @fft_length: Number of real points
+ * @weight: Weight of this spectrum
+ * @power: n/2 + 1 accumulators
+ *
+ * @return None
+ */
+void radix2_r2c_fft_split_power(const bina_complex *spectrum,
+		const bina_complex *twiddle, int fft_length, double weight,
+		double *power)
+{
+	int half = fft_length / 2;
+	double x0 = creal(spectrum[0]) + cimag(spectrum[0]);
+	double xh = creal(spectrum[0]) - cimag(spectrum[0]);
+
+	power[0] += weight * x0 * x0;
+	power[half] += weight * xh * xh;
+
+	for (int k = 1; k <= fft_length / 4; k++) {
+		bina_complex a = spectrum[k];
+		bina_complex b = conj(spectrum[half - k]);
+		bina_complex e = (a + b) * 0.5;
+		bina_complex o = (a - b) * (-0.5 * I);
+		bina_complex wo = twiddle[k] * o;
+		bina_complex lo = e + wo;
+		bina_complex hi = e - wo;
+
+		power[k] += weight * (creal(lo) * creal(lo)
+				+ cimag(lo) * cimag(lo));
+
+		if (half - k != k) {
+			power[half - k] += weight * (creal(hi) * creal(hi)
+					+ cimag(hi) * cimag(hi));
+		}
+	}
+}
+
+/* Inverse of radix2_r2c_fft_split(), times two: rebuilds the n/2 point
+ * sequence Z = 2 (E + i O) whose inverse transform is n times the (even,
+ * odd) sample pairs.
+ *
+ * @spectrum: X, n/2 + 1 bins
+ * @dst: Z, n/2 entries, must not overlap `spectrum'
+ * @twiddle: See radix2_r2c_fft_fill_twiddle()
+ * @fft_length: Number of real points
+ * @first: First pair, 0 <= k <= n/4
+ * @count: Number of pairs
+ *
+ * @return None
+ */
+void radix2_r2c_fft_merge(const bina_complex *spectrum, bina_complex *dst,
+		const bina_complex *twiddle, int fft_length,
+		int first, int count)
+{
+	int half = fft_length / 2;
+	int k = first;
+
+	if (k == 0 && count > 0) {
+		double x0 = creal(spectrum[0]);
+		double xh = creal(spectrum[half]);
+
+		dst[0] = (x0 + xh) + (x0 - xh) * I;
+		k++;
+	}
+
+	for (; k < first + count; k++) {
+		bina_complex a = spectrum[k];
+		bina_complex b = conj(spectrum[half - k]);
+		bina_complex e = a + b;
+		bina_complex o = (a - b) * conj(twiddle[k]) * I;
+
+		dst[k] = e + o;
+		dst[half - k] = conj(e - o);
+	}
+}
+
+/* Function to execute the real-to-complex FFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int radix2_r2c_fft_exec(bina_transform base)
+{
+	struct radix2_r2c_fft *self = (struct radix2_r2c_fft *) base;
+	bina_complex *out = self->out;
+
+	/* Adjacent real samples are the (re, im) of a complex one */
+	radix2_c2c_fft_execute_on(self->half, self->in, out);
+	radix2_r2c_fft_split(out, self->twiddle, self->fft_length, 0,
+			RADIX2_R2C_FFT_PAIRS(self->fft_length));
+
+	return 0;
+}
+
+/* Function to execute the complex-to-real FFT class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int radix2_c2r_fft_exec(bina_transform base)
+{
+	struct radix2_r2c_fft *self = (struct radix2_r2c_fft *) base;
+	bina_complex *out = self->out;
+
+	radix2_r2c_fft_merge(self->in, out, self->twiddle, self->fft_length,
+			0, RADIX2_R2C_FFT_PAIRS(self->fft_length));
+	radix2_c2c_fft_execute_on(self->half, out, out);
+
+	return 0;
+}
+
+/* Helper function to free the transform class.
+ *
+ * @base: Pointer to instance of transform object.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int free_class(bina_transform base)
+{
+	struct radix2_r2c_fft *self = (struct radix2_r2c_fft *) base;
+
+	if (self->half) {
+		bina_transform_free(self->half);
+	}
+
+	aligned_free(self->twiddle);
+	free(self);
+	return 0;
+}
@@ -0,0 +1,297 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* convolver.c - Streaming FIR filter (fast convolution) by overlap-save on
+* top of the radix-2 transforms.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/complex_kernels.h"
+#include "internal/log.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Largest FFT the block size search considers */
+#ifndef BINA_CONVOLVER_MAX_FFT
+#define BINA_CONVOLVER_MAX_FFT (1 << 24)
+#endif
+
+/* Relative cost of a butterfly and of a spectral product, per point */
+#define COST_BUTTERFLY (1.0)
+#define COST_MULTIPLY (1.0)
+
+/*******************************************************************************
+* Data structure
+*
+* Overlap-save: every block holds the last M - 1 input samples followed by
+* L = N - M + 1 new ones. Circular convolution of the block with the filter
+* is exact in its last L samples, which are the output of the block.
+*******************************************************************************/
+struct convolver {
+	int filter_length;              /* M, number of taps */
+
+	int fft_length;                 /* N, FFT size */
+
+	int block_length;               /* L = N - M + 1, new samples per
+					 * block, and the latency.
+					 */
+
+	int fill;                       /* Samples in `block' so far */
+
+	bina_complex *block;            /* Input block (time domain) */
+
+	bina_complex *spectrum;         /* Spectrum of the input block */
+
+	bina_complex *filtered;         /* Filtered block (time domain), its
+					 * last L samples are handed out while
+					 * the next block fills up.
+					 */
+
+	bina_complex *response;         /* Spectrum of the filter, divided
+					 * by N to fold in the inverse FFT
+					 * scaling.
+					 */
+
+	bina_transform forward;         /* block -> spectrum */
+
+	bina_transform inverse;         /* spectrum -> filtered */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static int choose_fft_length(int filter_length);
+
+static void filter_block(struct convolver *self);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a streaming convolver, y = h * x.
+ *
+ * @filter: Impulse response h (copied)
+ * @filter_length: Number of taps
+ * @fft_length: FFT size (power of two, at least `filter_length'), or zero
+ *              to pick the one with the lowest cost per output sample
+ * @flags: Extra flags for the transforms
+ *
+ * @return A new convolver, or NULL on failure.
+ */
+bina_convolver bina_convolver_create(const bina_complex *filter,
+		int filter_length, int fft_length, int flags)
+{
+	struct convolver *self = NULL;
+
+	if (filter == NULL || filter_length <= 0) {
+		log_error("Empty filter\n");
+		return NULL;
+	}
+
+	if (fft_length == 0) {
+		fft_length = choose_fft_length(filter_length);
+	}
+
+	if (!ispowtwo(fft_length) || fft_length < filter_length) {
+		log_error("FFT length must be a power of two >= filter length\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct convolver))) == NULL) {
+		log_error("Allocating convolver instance\n");
+		return NULL;
+	}
+
+	self->filter_length = filter_length;
+	self->fft_length = fft_length;
+	self->block_length = fft_length - filter_length + 1;
+
+	self->block = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+	self->spectrum = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+	self->filtered = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+	self->response = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+
+	if (self->block && self->spectrum && self->filtered
+			&& self->response) {
+		/* The spectra are only multiplied, in any order */
+		self->forward = bina_transform_create_radix2_c2c_fft(
+				self->block, self->spectrum, fft_length,
+				(flags & ~BINA_FFT_INVERSE)
+				| BINA_FFT_SCRAMBLED);
+		self->inverse = bina_transform_create_radix2_c2c_fft(
+				self->spectrum, self->filtered, fft_length,
+				flags | BINA_FFT_INVERSE | BINA_FFT_SCRAMBLED);
+	}
+
+	if (self->forward == NULL || self->inverse == NULL) {
+		log_error("Allocating convolver buffers\n");
+		bina_convolver_free(self);
+		return NULL;
+	}
+
+	/* Transform the zero padded filter once */
+	memcpy(self->block, filter, filter_length * sizeof(bina_complex));
+	bina_transform_execute(self->forward);
+
+	for (int i = 0; i < fft_length; i++) {
+		self->response[i] = self->spectrum[i] / fft_length;
+	}
+
+	/* Start with a history of zeros */
+	memset(self->block, 0, fft_length * sizeof(bina_complex));
+	self->fill = filter_length - 1;
+
+	return self;
+}
+
+/* Filters a chunk of samples. Chunks may have any length; the output lags
+ * the input by bina_convolver_latency() samples, and no memory is allocated.
+ *
+ * @conv: The convolver
+ * @in: Input samples
+ * @out: Output samples, may equal `in'
+ * @length: Number of samples
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_convolver_process(bina_convolver conv, const bina_complex *in,
+		bina_complex *out, int length)
+{
+	struct convolver *self = conv;
+	int history = self->filter_length - 1;
+
+	if (length < 0) {
+		return -1;
+	}
+
+	while (length > 0) {
+		int n = self->fft_length - self->fill;
+
+		if (n > length) {
+			n = length;
+		}
+
+		/* The output of the previous block drains at the same pace as
+		 * the current one fills.
+		 */
+		memcpy(self->block + self->fill, in, n * sizeof(bina_complex));
+		memcpy(out, self->filtered + self->fill, n * sizeof(bina_complex));
+
+		self->fill += n;
+		in += n;
+		out += n;
+		length -= n;
+
+		if (self->fill == self->fft_length) {
+			filter_block(self);
+
+			/* Keep the last M - 1 samples for the next block */
+			memmove(self->block, self->block + self->block_length,
+					history * sizeof(bina_complex));
+			self->fill = history;
+		}
+	}
+
+	return 0;
+}
+
+/* Returns the delay between input and output in samples, the number of new
+ * samples per block.
+ */
+int bina_convolver_latency(bina_convolver conv)
+{
+	struct convolver *self = conv;
+	return self->block_length;
+}
+
+/* Frees a convolver.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_convolver_free(bina_convolver conv)
+{
+	struct convolver *self = conv;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	if (self->forward) {
+		bina_transform_free(self->forward);
+	}
+
+	if (self->inverse) {
+		bina_transform_free(self->inverse);
+	}
+
+	aligned_free(self->block);
+	aligned_free(self->spectrum);
+	aligned_free(self->filtered);
+	aligned_free(self->response);
+	free(self);
+
+	return 0;
+}
+
+/* Picks the FFT size with the lowest cost per output sample. A block of N
+ * points costs two transforms, N lg(N) butterflies, plus N spectral
+ * products, and yields N - M + 1 samples: too small a block is dominated by
+ * the overlap, too large a one by the lg(N) growth.
+ *
+ * @filter_length: Number of taps
+ *
+ * @return FFT size
+ */
+static int choose_fft_length(int filter_length)
+{
+	int best = 0;
+	double best_cost = INFINITY;
+
+	for (int n = 1; n <= BINA_CONVOLVER_MAX_FFT; n *= 2) {
+		if (n < filter_length) {
+			continue;
+		}
+
+		double cost = (n * ilog2(n) * COST_BUTTERFLY
+				+ n * COST_MULTIPLY)
+				/ (n - filter_length + 1);
+
+		if (cost < best_cost) {
+			best = n;
+			best_cost = cost;
+		}
+	}
+
+	return best;
+}
+
+/* Filters the full input block into `filtered'.
+ *
+ * @self: The convolver
+ *
+ * @return None
+ */
+static void filter_block(struct convolver *self)
+{
+	bina_transform_execute(self->forward);
+	complex_multiply((double *) self->spectrum,
+			(const double *) self->spectrum,
+			(const double *) self->response, self->fft_length);
+	bina_transform_execute(self->inverse);
+}
@@ -0,0 +1,475 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* file_fft.c - Out-of-core complex FFT of files larger than memory. Files
+* hold N bina_complex in native byte order. The transform is the four step
+* algorithm of N = N1 N2, on the tables and plans of four_step.c, in two
+* passes, each of which sweeps the files once, front to back, a block of
+* columns at a time:
+*
+*   1. Reads columns of the input (N2 rows of N1), transforms them, rotates
+*      them, and writes them as rows of the output, N1 rows of N2.
+*   2. Reads columns of the output, transforms them, and writes them back
+*      in place, which leaves X[N2 k1 + k2] at k1 N2 + k2.
+*
+* While a block is transformed, the kernel is asked to read the next one
+* ahead with posix_fadvise(), so I/O overlaps compute without threads.
+*******************************************************************************/
+
+#include <complex.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__linux__) || defined(__unix)
+#include <fcntl.h>
+#include <unistd.h>
+#define HAS_PREAD (1)
+#else
+/* no pread(), out-of-core transforms are not available */
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/four_step.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Longest length, both factors stay within the plain transform */
+#define BINA_FILE_FFT_MAX_LENGTH ((size_t) 1 << 60)
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct file_fft {
+	struct four_step steps;         /* Tables and plans, no buffers */
+
+	size_t first_width;             /* Columns per block, first pass */
+
+	size_t second_width;            /* Columns per block, second pass */
+
+	bina_complex *block;            /* Columns read, rows x width */
+
+	bina_complex *rotated;          /* First pass output, width x N2, and
+					 * scratch of the second pass */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static size_t floor_powtwo(size_t x);
+
+#ifdef HAS_PREAD
+static int read_full(int fd, void *buf, size_t bytes, size_t offset);
+
+static int write_full(int fd, const void *buf, size_t bytes, size_t offset);
+
+static int columns_io(int fd, bina_complex *block, size_t rows,
+		size_t row_length, size_t first, size_t width, int write);
+
+static void read_ahead(int fd, size_t rows, size_t row_length,
+		size_t first, size_t width);
+
+static int first_pass(struct file_fft *self, int in_fd, int out_fd);
+
+static int second_pass(struct file_fft *self, int fd);
+#endif
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Allocates an out-of-core transform.
+ *
+ * @fft_length: Length of the problem (MUST be power of two, 2 to 2^60)
+ * @memory_budget: Bytes for all the data in memory, at least
+ *                 32 2^ceil(lg N / 2); larger budgets read wider blocks.
+ *                 The twiddle tables and plans, O(sqrt N), are apart.
+ * @flags: Extra flags, BINA_FFT_INVERSE and BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @return The transform, or NULL on failure
+ */
+bina_file_fft bina_file_fft_create(size_t fft_length, size_t memory_budget,
+		int flags)
+{
+	struct file_fft *self = NULL;
+	int sub_flags = flags & (BINA_FFT_INVERSE | BINA_FFT_COMPACT_TWIDDLE);
+	size_t points = memory_budget / (2 * sizeof(bina_complex));
+	size_t columns, rows;
+
+	if (fft_length < 2 || (fft_length & (fft_length - 1)) != 0
+			|| fft_length > BINA_FILE_FFT_MAX_LENGTH) {
+		log_error("Length is not power of two from 2 to 2^60\n");
+		return NULL;
+	}
+
+	four_step_split(fft_length, &columns, &rows);
+
+	/* N2 >= N1, a block must hold at least one column of either pass */
+	if (points < rows) {
+		log_error("Memory budget is too small for the length\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct file_fft))) == NULL) {
+		log_error("Allocating out-of-core FFT instance\n");
+		return NULL;
+	}
+
+	self->first_width = floor_powtwo(points / rows);
+	self->second_width = floor_powtwo(points / columns);
+
+	if (self->first_width > columns) {
+		self->first_width = columns;
+	}
+
+	if (self->second_width > rows) {
+		self->second_width = rows;
+	}
+
+	self->block = aligned_malloc(BINA_FFT_ALIGNMENT, points,
+			sizeof(bina_complex));
+	self->rotated = aligned_malloc(BINA_FFT_ALIGNMENT, points,
+			sizeof(bina_complex));
+
+	if (self->block == NULL || self->rotated == NULL
+			|| four_step_create(&self->steps, fft_length, sub_flags,
+				0) != 0) {
+		log_error("Allocating out-of-core FFT buffers\n");
+		bina_file_fft_free(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Transforms a file into another. The input file is only read.
+ *
+ * @fft: The transform
+ * @in_fd: Descriptor of the input, opened for reading
+ * @out_fd: Descriptor of the output, opened for reading and writing, and
+ *          not the input
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_file_fft_execute(bina_file_fft fft, int in_fd, int out_fd)
+{
+	struct file_fft *self = fft;
+
+	if (self == NULL || in_fd < 0 || out_fd < 0 || in_fd == out_fd) {
+		return -1;
+	}
+
+#	ifdef HAS_PREAD
+	if (first_pass(self, in_fd, out_fd) != 0
+			|| second_pass(self, out_fd) != 0) {
+		return -1;
+	}
+
+	return 0;
+#	else
+	log_error("Out-of-core transforms need pread()\n");
+	return -1;
+#	endif
+}
+
+/* Same as bina_file_fft_execute(), with paths. The output is created or
+ * truncated.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_file_fft_execute_path(bina_file_fft fft, const char *in_path,
+		const char *out_path)
+{
+#	ifdef HAS_PREAD
+	int in_fd = open(in_path, O_RDONLY);
+	int out_fd = open(out_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	int result = -1;
+
+	if (in_fd < 0 || out_fd < 0) {
+		log_error("Opening %s or %s\n", in_path, out_path);
+	} else {
+		result = bina_file_fft_execute(fft, in_fd, out_fd);
+	}
+
+	if (in_fd >= 0) {
+		close(in_fd);
+	}
+
+	if (out_fd >= 0 && close(out_fd) != 0) {
+		result = -1;
+	}
+
+	return result;
+#	else
+	log_error("Out-of-core transforms need pread()\n");
+	return -1;
+#	endif
+}
+
+/* Frees an out-of-core transform.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_file_fft_free(bina_file_fft fft)
+{
+	struct file_fft *self = fft;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	four_step_release(&self->steps);
+	aligned_free(self->block);
+	aligned_free(self->rotated);
+	free(self);
+
+	return 0;
+}
+
+/* Largest power of two not above x, zero for zero */
+static size_t floor_powtwo(size_t x)
+{
+	size_t p = 1;
+
+	if (x == 0) {
+		return 0;
+	}
+
+	while (p <= x / 2) {
+		p *= 2;
+	}
+
+	return p;
+}
+
+#ifdef HAS_PREAD
+
+/* pread() of exactly `bytes' bytes, retrying short reads.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int read_full(int fd, void *buf, size_t bytes, size_t offset)
+{
+	unsigned char *p = buf;
+
+	while (bytes > 0) {
+		ssize_t got = pread(fd, p, bytes, (off_t) offset);
+
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (got <= 0) {
+			log_error("Reading transform data\n");
+			return -1;
+		}
+
+		p += got;
+		offset += got;
+		bytes -= got;
+	}
+
+	return 0;
+}
+
+/* pwrite() of exactly `bytes' bytes, retrying short writes.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int write_full(int fd, const void *buf, size_t bytes, size_t offset)
+{
+	const unsigned char *p = buf;
+
+	while (bytes > 0) {
+		ssize_t put = pwrite(fd, p, bytes, (off_t) offset);
+
+		if (put < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (put <= 0) {
+			log_error("Writing transform data\n");
+			return -1;
+		}
+
+		p += put;
+		offset += put;
+		bytes -= put;
+	}
+
+	return 0;
+}
+
+/* Moves the columns first to first + width of a file of `rows' rows into
+ * or out of a rows x width block, row by row in file order.
+ *
+ * @fd: File
+ * @block: rows x width points
+ * @rows: Rows in the file
+ * @row_length: Points per row in the file
+ * @first: First column
+ * @width: Number of columns
+ * @write: Nonzero to write the block, zero to read it
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int columns_io(int fd, bina_complex *block, size_t rows,
+		size_t row_length, size_t first, size_t width, int write)
+{
+	const size_t bytes = width * sizeof(bina_complex);
+
+	for (size_t r = 0; r < rows; r++) {
+		size_t offset = (r * row_length + first) * sizeof(bina_complex);
+		int failed = write ? write_full(fd, block + r * width, bytes,
+				offset)
+			: read_full(fd, block + r * width, bytes, offset);
+
+		if (failed) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Asks the kernel to start reading the block columns_io() reads next */
+static void read_ahead(int fd, size_t rows, size_t row_length,
+		size_t first, size_t width)
+{
+#	ifdef POSIX_FADV_WILLNEED
+	const size_t bytes = width * sizeof(bina_complex);
+
+	for (size_t r = 0; r < rows; r++) {
+		size_t offset = (r * row_length + first) * sizeof(bina_complex);
+
+		posix_fadvise(fd, (off_t) offset, (off_t) bytes,
+				POSIX_FADV_WILLNEED);
+	}
+#	endif
+}
+
+/* Column transforms of the input, rotated, to rows of the output.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int first_pass(struct file_fft *self, int in_fd, int out_fd)
+{
+	const size_t columns = self->steps.columns;
+	const size_t rows = self->steps.rows;
+	const size_t width = self->first_width;
+
+	for (size_t first = 0; first < columns; first += width) {
+		if (columns_io(in_fd, self->block, rows, columns, first,
+					width, 0) != 0) {
+			return -1;
+		}
+
+		if (first + width < columns) {
+			read_ahead(in_fd, rows, columns, first + width, width);
+		}
+
+#		ifdef _OPENMP
+#		pragma omp parallel for schedule(static) \
+			num_threads(self->steps.num_workers)
+#		endif
+		for (int64_t b = 0; b < (int64_t) width; b++) {
+			int t = 0;
+
+#			ifdef _OPENMP
+			t = omp_get_thread_num();
+#			endif
+
+			struct four_step_worker *worker =
+				&self->steps.workers[t];
+			bina_complex *dst = self->rotated + b * rows;
+
+			for (size_t r = 0; r < rows; r++) {
+				dst[r] = self->block[r * width + b];
+			}
+
+			radix2_c2c_fft_execute_on(worker->column_fft, dst, dst);
+			four_step_rotate(&self->steps, dst, first + b);
+		}
+
+		if (write_full(out_fd, self->rotated,
+					width * rows * sizeof(bina_complex),
+					first * rows * sizeof(bina_complex))
+				!= 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Column transforms of the output of first_pass(), in place. Every column
+ * goes through its own slice of `rotated', so the pass needs no buffer
+ * beyond the budget.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int second_pass(struct file_fft *self, int fd)
+{
+	const size_t columns = self->steps.columns;
+	const size_t rows = self->steps.rows;
+	const size_t width = self->second_width;
+
+	for (size_t first = 0; first < rows; first += width) {
+		if (columns_io(fd, self->block, columns, rows, first, width,
+					0) != 0) {
+			return -1;
+		}
+
+		if (first + width < rows) {
+			read_ahead(fd, columns, rows, first + width, width);
+		}
+
+#		ifdef _OPENMP
+#		pragma omp parallel for schedule(static) \
+			num_threads(self->steps.num_workers)
+#		endif
+		for (int64_t b = 0; b < (int64_t) width; b++) {
+			int t = 0;
+
+#			ifdef _OPENMP
+			t = omp_get_thread_num();
+#			endif
+
+			struct four_step_worker *worker =
+				&self->steps.workers[t];
+			bina_complex *column = self->rotated + b * columns;
+
+			for (size_t r = 0; r < columns; r++) {
+				column[r] = self->block[r * width + b];
+			}
+
+			radix2_c2c_fft_execute_on(worker->row_fft, column,
+					column);
+
+			for (size_t r = 0; r < columns; r++) {
+				self->block[r * width + b] = column[r];
+			}
+		}
+
+		if (columns_io(fd, self->block, columns, rows, first, width,
+					1) != 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+#endif				/* ifdef HAS_PREAD */
@@ -0,0 +1,215 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* four_step.c - Tables and plans of the four step algorithm, N = N1 N2,
+* shared by the in-memory and the out-of-core transforms. w_N^m comes from
+* two tables of N1 and N2 entries, as w_N^(m mod N1) w_N2^(m / N1), and
+* every worker thread has its own pair of plans on tables shared by all.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/four_step.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void fill_twiddle(bina_complex *table, size_t count, size_t step,
+		size_t fft_length, double sign);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Splits N into N1 = 2^floor(lg N / 2) columns and N2 = N / N1 >= N1 rows.
+ *
+ * @fft_length: N, a power of two
+ * @columns: N1
+ * @rows: N2
+ *
+ * @return None
+ */
+void four_step_split(size_t fft_length, size_t *columns, size_t *rows)
+{
+	int lg = 0;
+
+	while (((size_t) 1 << lg) < fft_length) {
+		lg++;
+	}
+
+	*columns = (size_t) 1 << (lg / 2);
+	*rows = fft_length / *columns;
+}
+
+/* Sets up the tables, and the plans of every worker. On failure, what was
+ * set up is released.
+ *
+ * @self: Four step state to set up
+ * @fft_length: N, a power of two from 2 to 2^60
+ * @flags: BINA_FFT_INVERSE and BINA_FFT_COMPACT_TWIDDLE
+ * @worker_points: Size of the scratch buffer of every worker, 0 for none
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int four_step_create(struct four_step *self, size_t fft_length, int flags,
+		size_t worker_points)
+{
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	int failed;
+
+	flags &= BINA_FFT_INVERSE | BINA_FFT_COMPACT_TWIDDLE;
+
+	*self = (struct four_step) { 0 };
+	four_step_split(fft_length, &self->columns, &self->rows);
+	self->fft_length = fft_length;
+	self->num_workers = 1;
+
+	while (((size_t) 1 << self->lg_columns) < self->columns) {
+		self->lg_columns++;
+	}
+
+#	ifdef _OPENMP
+	self->num_workers = omp_get_max_threads();
+#	endif
+
+	self->fine = aligned_malloc(BINA_FFT_ALIGNMENT, self->columns,
+			sizeof(bina_complex));
+	self->coarse = aligned_malloc(BINA_FFT_ALIGNMENT, self->rows,
+			sizeof(bina_complex));
+	self->workers = calloc(self->num_workers,
+			sizeof(struct four_step_worker));
+
+	failed = (self->fine == NULL || self->coarse == NULL
+			|| self->workers == NULL
+			|| radix2_c2c_fft_tables((int) self->rows, flags,
+				&self->column_twiddle, NULL,
+				&self->column_perm, NULL) != 0
+			|| radix2_c2c_fft_tables((int) self->columns, flags,
+				&self->row_twiddle, NULL, &self->row_perm,
+				NULL) != 0);
+
+	for (int t = 0; !failed && t < self->num_workers; t++) {
+		struct four_step_worker *worker = &self->workers[t];
+
+		worker->column_fft = radix2_c2c_fft_create_with_tables(NULL,
+				NULL, (int) self->rows, flags,
+				self->column_twiddle, self->column_perm);
+		worker->row_fft = radix2_c2c_fft_create_with_tables(NULL,
+				NULL, (int) self->columns, flags,
+				self->row_twiddle, self->row_perm);
+
+		if (worker_points > 0) {
+			worker->buffer = aligned_malloc(BINA_FFT_ALIGNMENT,
+					worker_points, sizeof(bina_complex));
+		}
+
+		failed = (worker->column_fft == NULL
+				|| worker->row_fft == NULL
+				|| (worker_points > 0 && worker->buffer == NULL));
+	}
+
+	if (failed) {
+		four_step_release(self);
+		return -1;
+	}
+
+	fill_twiddle(self->fine, self->columns, 1, fft_length, sign);
+	fill_twiddle(self->coarse, self->rows, self->columns, fft_length,
+			sign);
+
+	return 0;
+}
+
+/* Step 2 for one transformed column, column[k2] *= w_N^(n1 k2).
+ *
+ * @self: Four step state
+ * @column: N2 points
+ * @n1: Index of the column
+ *
+ * @return None
+ */
+void four_step_rotate(const struct four_step *self, bina_complex *column,
+		size_t n1)
+{
+	const size_t mask = self->columns - 1;
+	const int shift = self->lg_columns;
+
+	for (size_t k2 = 1; k2 < self->rows; k2++) {
+		size_t m = n1 * k2;
+
+		column[k2] *= self->fine[m & mask] * self->coarse[m >> shift];
+	}
+}
+
+/* Frees the tables and plans, not the state itself.
+ *
+ * @self: Four step state, set up by four_step_create()
+ *
+ * @return None
+ */
+void four_step_release(struct four_step *self)
+{
+	for (int t = 0; self->workers && t < self->num_workers; t++) {
+		struct four_step_worker *worker = &self->workers[t];
+
+		if (worker->column_fft) {
+			bina_transform_free(worker->column_fft);
+		}
+
+		if (worker->row_fft) {
+			bina_transform_free(worker->row_fft);
+		}
+
+		aligned_free(worker->buffer);
+	}
+
+	free(self->workers);
+	aligned_free(self->fine);
+	aligned_free(self->coarse);
+	aligned_free(self->column_twiddle);
+	aligned_free(self->column_perm);
+	aligned_free(self->row_twiddle);
+	aligned_free(self->row_perm);
+	*self = (struct four_step) { 0 };
+}
+
+/* Fills table[j] = exp(sign 2 pi i j step / N).
+ *
+ * @table: Output, `count' points
+ * @count: Number of entries
+ * @step: Exponent step
+ * @fft_length: N
+ * @sign: -1 forward, +1 inverse
+ *
+ * @return None
+ */
+static void fill_twiddle(bina_complex *table, size_t count, size_t step,
+		size_t fft_length, double sign)
+{
+	for (size_t j = 0; j < count; j++) {
+		double a = 2.0 * M_PI * (double) (j * step)
+			/ (double) fft_length;
+
+		table[j] = cos(a) + sign * sin(a) * I;
+	}
+}
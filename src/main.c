@@ -36,35 +36,39 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 	 > ^ <    ^~~~~~~~~~~~~~~~^
 
 ********************************************************************************************/
+#include <complex.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 #include <sys/time.h>
 #include <sys/resource.h>
-#include <BinaFFT.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+
+#define bina_complex_alloc(n) aligned_calloc(32, n, sizeof(bina_complex))
+#define bina_complex_free(ptr) aligned_free(ptr)
 
 void print_complex_array(bina_complex * x, int N, const char *msg);
-float rand_float(float a, float b);
+double rand_double(double a, double b);
 double get_time();
-void benchmark_i(uint8_t start, uint8_t end, size_t iterations);
+void benchmark_i(uint8_t start, uint8_t end, size_t iterations, int flags);
 void test_code(void);
 
 int main(void)
 {
-	printf("%s", bina_fft_logo());
 	printf
 	    ("Enter the number of iteration (-1 to skip to default value of 8000): ");
 	int iterations;
-	scanf(" %d", &iterations);
-	if (iterations == (-1))
+	if (scanf(" %d", &iterations) != 1 || iterations == (-1))
 		iterations = 8000;
-	benchmark_i(4, 18, iterations);
+	benchmark_i(4, 18, iterations, 0);
+	benchmark_i(4, 18, iterations, BINA_FFT_COMPACT_TWIDDLE);
 
 	printf("\nDo you want to run a test sample? (y/n) ");
-	char yes;
-	scanf(" %c", &yes);
-	if (!(yes - 'y'))
+	char yes = 'n';
+	if (scanf(" %c", &yes) == 1 && !(yes - 'y'))
 		test_code();
 	printf("Thanks for evaluating my program! (Ayan Shafqat)\n");
 	return 0;
@@ -73,14 +77,13 @@ int main(void)
 double get_time()
 {
 	struct timeval t;
-	struct timezone tzp;
-	gettimeofday(&t, &tzp);
+	gettimeofday(&t, NULL);
 	return t.tv_sec + t.tv_usec * 1e-6;
 }
 
-float rand_float(float a, float b)
+double rand_double(double a, double b)
 {
-	return ((b - a) * ((float)rand() / RAND_MAX)) + a;
+	return ((b - a) * ((double)rand() / RAND_MAX)) + a;
 }
 
 void print_complex_array(bina_complex * x, int N, const char *msg)
@@ -90,20 +93,22 @@ void print_complex_array(bina_complex * x, int N, const char *msg)
 	int i;
 	printf("%s\n--------------------\n", msg);
 	for (i = 0; i < N; i++) {
-		if (x[i][0] == 0.0f && x[i][1] == 0.0f) {
+		double re = creal(x[i]);
+		double im = cimag(x[i]);
+		if (re == 0.0 && im == 0.0) {
 			printf("0");
-		} else if (x[i][0] == 0.0f) {
-			printf(printf_macro_i, x[i][1]);
-		} else if (x[i][1] == 0.0f) {
-			printf(printf_macro, x[i][0]);
+		} else if (re == 0.0) {
+			printf(printf_macro_i, im);
+		} else if (im == 0.0) {
+			printf(printf_macro, re);
 		} else {
-			printf(printf_macro, x[i][0]);
-			if (x[i][1] < 0.0f) {
+			printf(printf_macro, re);
+			if (im < 0.0) {
 				printf(" - ");
 			} else {
 				printf(" + ");
 			}
-			printf(printf_macro_i, fabs(x[i][1]));
+			printf(printf_macro_i, fabs(im));
 		}
 		printf("\n");
 	}
@@ -112,61 +117,80 @@ void print_complex_array(bina_complex * x, int N, const char *msg)
 #undef printf_macro_i
 }
 
-void benchmark_i(uint8_t start, uint8_t end, size_t iterations)
+/* Times plan creation (twiddle factors, permutation table, buffers) and
+ * execution of radix-2 transforms of 2^start to 2^end points.
+ */
+void benchmark_i(uint8_t start, uint8_t end, size_t iterations, int flags)
 {
-	printf("\n==[ Benchmark Testing (cfft)]================\n");
+	printf("\n==[ Benchmark Testing (cfft, flags %#x)]================\n",
+	       flags);
 	const size_t max_size = (0x1 << end);
 	uint8_t log2N;
 	size_t it, N, n;
-	_mem_align(32) bina_complex input[max_size];
-	_mem_align(32) bina_complex twiddle[max_size >> 1];
-	double t0, t1, t_av;
+	bina_complex *input = bina_complex_alloc(max_size);
+	bina_complex *output = bina_complex_alloc(max_size);
+	bina_transform plan;
+	double t0, t1, t_plan, t_av;
 	for (log2N = start; log2N <= end; log2N++) {
-		fft_calculate_twiddle(log2N, twiddle);
-		it = iterations;
 		N = 0x1 << log2N;
+
+		t0 = get_time();
+		plan = bina_transform_create_radix2_c2c_fft(input, output, N,
+							    flags);
+		t1 = get_time();
+		t_plan = t1 - t0;
+
+		if (plan == NULL) {
+			printf("FFT ( BinaFFT ) of size %7lu failed to plan\n",
+			       N);
+			continue;
+		}
+
+		it = iterations;
 		t_av = 0.f;
 		while (it--) {
 			n = N;
 			// Filling up test array
 			while (n--) {
-				input[n][0] = rand_float(-1.0f, 1.0f);
-				input[n][1] = rand_float(-1.0f, 1.0f);
+				input[n] = rand_double(-1.0, 1.0)
+				    + rand_double(-1.0, 1.0) * I;
 			}
 
 			t0 = get_time();
-			bina_radix2_fft(log2N, twiddle, input);
+			bina_transform_execute(plan);
 			t1 = get_time();
 
 			t_av += ((double)t1 - (double)t0);
 		}
 		t_av /= (double)iterations;
-		printf("FFT ( BinaFFT ) of size %7lu took %e seconds\n", N,
-		       t_av);
+		printf("FFT ( BinaFFT ) of size %7lu planned in %e seconds, "
+		       "took %e seconds\n", N, t_plan, t_av);
+
+		bina_transform_free(plan);
 	}
+	bina_complex_free(input);
+	bina_complex_free(output);
 }
 
 void test_code(void)
 {
 	printf("\n==[ Running Test Code (cfft)]================\n");
 	size_t log2N = 4, N = 0x1 << log2N;
-	bina_complex *in = bina_aligned_malloc(N * sizeof(bina_complex), 32);
-	bina_complex *twiddle = bina_create_twiddle_lookup(log2N);
+	bina_complex *in = bina_complex_alloc(N);
+	bina_complex *out = bina_complex_alloc(N);
+	bina_transform fft = bina_transform_create_radix2_c2c_fft(in, out, N, 0);
 
 	for (int i = N; i--;) {
-		in[i][0] = rand_float(-1.f, 1.f);
-		in[i][1] = rand_float(-1.f, 1.f);
+		in[i] = rand_double(-1.0, 1.0) + rand_double(-1.0, 1.0) * I;
 	}
 	print_complex_array(in, N, "in");
 
-	print_complex_array(twiddle, N >> 1, "Twiddle factors");
-	bina_fft(in);
-	print_complex_array(in, N, "fft");
-	bina_ifft(in);
-	print_complex_array(in, N, "ifft");
+	bina_transform_execute(fft);
+	print_complex_array(out, N, "fft");
 
 	// Cleaning up
-	bina_aligned_free(in);
-	bina_aligned_free(twiddle);
+	bina_transform_free(fft);
+	bina_complex_free(in);
+	bina_complex_free(out);
 	return;
 }
@@ -0,0 +1,303 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* mdct.c - Modified discrete cosine transform of a sample stream, and its
+* inverse with overlap-add. A frame of N coefficients comes from 2N windowed
+* samples, N new ones per frame:
+*
+*   X[k] = sum w[n] x[n] cos(pi / N (n + 1/2 + N/2) (k + 1/2)),  n < 2N
+*
+* The 2N samples fold into N, whose DCT-IV is X: the kernel of the r2r
+* transforms, which pairs u[2m] with u[N-1-2m] as one complex point of an
+* N/2 point transform (N/4 of the frame). The fold writes the pairs
+* directly. The inverse is the same DCT-IV, unfolded; the time domain
+* aliasing of neighbouring frames cancels when they overlap, for windows
+* with w[n]^2 + w[n + N]^2 = 1.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/r2r.h"
+#include "internal/window.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct mdct {
+	int length;                     /* N, coefficients per frame */
+
+	double *window;                 /* 2N analysis window values */
+
+	double *synthesis;              /* Window times 2 / N */
+
+	bina_complex *rotation;         /* N/2 + 1 DCT-IV rotations */
+
+	bina_complex shift;             /* exp(-i pi / 4N) */
+
+	bina_transform fft;             /* N/2 point complex transform */
+
+	bina_complex *work;             /* N/2 points */
+
+	double *block;                  /* N points, the inverse DCT-IV */
+
+	double *history;                /* Last 2N samples fed in */
+
+	int fill;                       /* New samples in the second half */
+
+	double *overlap;                /* Second half of the last inverse
+					 * frame, yet to be added.
+					 */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static double fold(const double *window, const double *z, int n, int i);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates an MDCT.
+ *
+ * @frame_length: N, coefficients per frame and samples between frames
+ *                (MUST be power of two, at least 2)
+ * @window: BINA_WINDOW_SINE or BINA_WINDOW_KBD, the windows with
+ *          w[n]^2 + w[n + N]^2 = 1
+ * @flags: Extra flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @return A new MDCT, or NULL on failure.
+ */
+bina_mdct bina_mdct_create(int frame_length, int window, int flags)
+{
+	struct mdct *self = NULL;
+	int n = frame_length;
+
+	if (!ispowtwo(n) || n < 2) {
+		log_error("Length is not power of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct mdct))) == NULL) {
+		log_error("Allocating MDCT instance\n");
+		return NULL;
+	}
+
+	self->length = n;
+	self->window = aligned_malloc(BINA_FFT_ALIGNMENT, 2 * n,
+			sizeof(double));
+	self->synthesis = aligned_malloc(BINA_FFT_ALIGNMENT, 2 * n,
+			sizeof(double));
+	self->rotation = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2 + 1,
+			sizeof(bina_complex));
+	self->work = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2,
+			sizeof(bina_complex));
+	self->block = aligned_malloc(BINA_FFT_ALIGNMENT, n, sizeof(double));
+	self->history = aligned_calloc(BINA_FFT_ALIGNMENT, 2 * n,
+			sizeof(double));
+	self->overlap = aligned_calloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(double));
+	self->fft = bina_transform_create_radix2_c2c_fft(NULL, NULL, n / 2,
+			flags & BINA_FFT_COMPACT_TWIDDLE);
+
+	if (self->window == NULL || self->synthesis == NULL
+			|| self->rotation == NULL
+			|| self->work == NULL || self->block == NULL
+			|| self->history == NULL
+			|| self->overlap == NULL || self->fft == NULL
+			|| window_fill(self->window, 2 * n, window) != 0) {
+		log_error("Allocating MDCT buffers\n");
+		bina_mdct_free(self);
+		return NULL;
+	}
+
+	/* Aliasing only cancels for these windows */
+	for (int i = 0; i < n; i++) {
+		double a = self->window[i];
+		double b = self->window[i + n];
+
+		if (fabs(a * a + b * b - 1.0) > 1e-9
+				|| fabs(a - self->window[2 * n - 1 - i]) > 1e-9) {
+			log_error("Window does not cancel MDCT aliasing\n");
+			bina_mdct_free(self);
+			return NULL;
+		}
+	}
+
+	for (int i = 0; i < 2 * n; i++) {
+		self->synthesis[i] = self->window[i] * 2.0 / n;
+	}
+
+	r2r_dct4_fill_rotation(self->rotation, &self->shift, n);
+
+	return self;
+}
+
+/* Feeds samples to the MDCT, and writes a frame of N coefficients for
+ * every N samples. The first frame sees N zeros before the stream.
+ *
+ * @mdct: The MDCT
+ * @in: Input samples
+ * @length: Number of samples
+ * @coefficients: Room for (pending + length) / N frames, where pending is
+ *                the number of samples fed since the last frame
+ *
+ * @return Number of frames written, or -1 on failure.
+ */
+int bina_mdct_forward(bina_mdct mdct, const bina_real *in, int length,
+		bina_real *coefficients)
+{
+	struct mdct *self = mdct;
+	int n = self->length;
+	const double *z = self->history;
+	const double *w = self->window;
+	int count = 0;
+
+	if (length < 0) {
+		return -1;
+	}
+
+	while (length > 0) {
+		int take = n - self->fill;
+
+		take = (take < length) ? take : length;
+		memcpy(self->history + n + self->fill, in,
+				take * sizeof(double));
+		self->fill += take;
+		in += take;
+		length -= take;
+
+		if (self->fill < n) {
+			break;
+		}
+
+		/* Window and fold, paired as u[2m] + i u[N-1-2m] */
+		for (int m = 0; m < n / 2; m++) {
+			self->work[m] = fold(w, z, n, 2 * m)
+				+ fold(w, z, n, n - 1 - 2 * m) * I;
+		}
+
+		r2r_dct4_paired(self->fft, self->rotation, self->shift,
+				self->work, n, coefficients + (size_t) count * n);
+		count++;
+
+		memcpy(self->history, self->history + n, n * sizeof(double));
+		self->fill = 0;
+	}
+
+	return count;
+}
+
+/* Inverse MDCT of frames of N coefficients, overlap-added into N samples
+ * per frame. The output is the input of bina_mdct_forward() N samples
+ * later; the first N samples out are the zeros before the stream.
+ *
+ * @mdct: The MDCT
+ * @coefficients: Frames of N coefficients
+ * @frames: Number of frames
+ * @out: Room for N samples per frame
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_mdct_inverse(bina_mdct mdct, const bina_real *coefficients,
+		int frames, bina_real *out)
+{
+	struct mdct *self = mdct;
+	int n = self->length;
+	const double *s = self->synthesis;
+	const double *u = self->block;
+
+	if (frames < 0) {
+		return -1;
+	}
+
+	for (int f = 0; f < frames; f++) {
+		const double *x = coefficients + (size_t) f * n;
+		double *y = out + (size_t) f * n;
+
+		for (int m = 0; m < n / 2; m++) {
+			self->work[m] = x[2 * m] + x[n - 1 - 2 * m] * I;
+		}
+
+		r2r_dct4_paired(self->fft, self->rotation, self->shift,
+				self->work, n, self->block);
+
+		/* Unfold to (u2, -u2 reversed, -u1 reversed, -u1) with u1, u2
+		 * the halves of u, window, and overlap-add.
+		 */
+		for (int j = 0; j < n / 2; j++) {
+			y[j] = self->overlap[j] + s[j] * u[n / 2 + j];
+			y[n / 2 + j] = self->overlap[n / 2 + j]
+				- s[n / 2 + j] * u[n - 1 - j];
+			self->overlap[j] = -s[n + j] * u[n / 2 - 1 - j];
+			self->overlap[n / 2 + j] = -s[3 * n / 2 + j] * u[j];
+		}
+	}
+
+	return 0;
+}
+
+/* Frees an MDCT.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_mdct_free(bina_mdct mdct)
+{
+	struct mdct *self = mdct;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	aligned_free(self->window);
+	aligned_free(self->synthesis);
+	aligned_free(self->rotation);
+	aligned_free(self->work);
+	aligned_free(self->block);
+	aligned_free(self->history);
+	aligned_free(self->overlap);
+	free(self);
+
+	return 0;
+}
+
+/* Point i of the folded frame, from the quarters (a, b, c, d) of the
+ * windowed samples: (-c reversed - d, a - b reversed).
+ *
+ * @window: 2N window values
+ * @z: 2N samples
+ * @n: N
+ * @i: Index, 0 <= i < N
+ *
+ * @return u[i]
+ */
+static inline double fold(const double *window, const double *z, int n,
+		int i)
+{
+	int r = 3 * n / 2 - 1 - i;
+
+	if (i < n / 2) {
+		return -window[r] * z[r] - window[3 * n / 2 + i]
+			* z[3 * n / 2 + i];
+	}
+
+	return window[i - n / 2] * z[i - n / 2] - window[r] * z[r];
+}
@@ -0,0 +1,288 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* ntt_convolver.c - Exact linear convolution of 64-bit sequences, as needed
+* for big integer and polynomial products. The convolution is done modulo
+* each of the three NTT moduli, and the residues are joined by the Chinese
+* remainder theorem (Garner's form) into numbers below their product, about
+* 2^183.8: enough for any sum of products of 64-bit numbers with fewer than
+* about 2^55 terms. Convolutions are capped at 2^30 points, well inside that.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/log.h"
+#include "internal/ntt.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct ntt_convolver {
+	int max_length;                 /* Longest convolution */
+
+	int length;                     /* Transform length, power of two */
+
+	bina_transform ntt[NTT_MODULI]; /* One transform per modulus */
+
+	uint64_t *work[NTT_MODULI];     /* Two buffers per modulus, the
+					 * first ends up with the residues.
+					 */
+
+	uint64_t inverse_p1;            /* 1/p1 mod p2 */
+
+	uint64_t inverse_p1_shoup;
+
+	uint64_t inverse_p1p2;          /* 1/(p1 p2) mod p3 */
+
+	uint64_t inverse_p1p2_shoup;
+
+	ntt_wide p1p2;                  /* p1 p2 */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void load(uint64_t *dst, const uint64_t *src, int length,
+		int padded_length, uint64_t p);
+
+static void garner(const struct ntt_convolver *self, uint64_t r1,
+		uint64_t r2, uint64_t r3, uint64_t *dst);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates an exact convolver.
+ *
+ * @max_length: Longest convolution, a_length + b_length - 1
+ *
+ * @return A new convolver, or NULL on failure.
+ */
+bina_ntt_convolver bina_ntt_convolver_create(int max_length)
+{
+	struct ntt_convolver *self = NULL;
+	uint64_t p1 = bina_ntt_modulus(0);
+	uint64_t p2 = bina_ntt_modulus(1);
+	uint64_t p3 = bina_ntt_modulus(2);
+	int length = 1;
+
+	if (max_length <= 0 || max_length > (1 << 30)) {
+		log_error("Bad convolution length\n");
+		return NULL;
+	}
+
+	while (length < max_length) {
+		length *= 2;
+	}
+
+	if ((self = calloc(1, sizeof(struct ntt_convolver))) == NULL) {
+		log_error("Allocating NTT convolver instance\n");
+		return NULL;
+	}
+
+	self->max_length = max_length;
+	self->length = length;
+
+	for (int k = 0; k < NTT_MODULI; k++) {
+		self->ntt[k] = bina_transform_create_ntt(NULL, NULL, length,
+				k, 0);
+		self->work[k] = aligned_malloc(BINA_FFT_ALIGNMENT,
+				2 * (size_t) length, sizeof(uint64_t));
+
+		if (self->ntt[k] == NULL || self->work[k] == NULL) {
+			log_error("Allocating NTT convolver buffers\n");
+			bina_ntt_convolver_free(self);
+			return NULL;
+		}
+	}
+
+	/* Inverses by Fermat's little theorem, p2 and p3 being prime */
+	self->p1p2 = (ntt_wide) p1 * p2;
+	self->inverse_p1 = 1;
+	self->inverse_p1p2 = 1;
+
+	for (int bit = 63; bit >= 0; bit--) {
+		self->inverse_p1 = ntt_mul_mod(self->inverse_p1,
+				self->inverse_p1, p2);
+		self->inverse_p1p2 = ntt_mul_mod(self->inverse_p1p2,
+				self->inverse_p1p2, p3);
+
+		if (((p2 - 2) >> bit) & 1) {
+			self->inverse_p1 = ntt_mul_mod(self->inverse_p1,
+					p1 % p2, p2);
+		}
+
+		if (((p3 - 2) >> bit) & 1) {
+			self->inverse_p1p2 = ntt_mul_mod(self->inverse_p1p2,
+					(uint64_t) (self->p1p2 % p3), p3);
+		}
+	}
+
+	self->inverse_p1_shoup = ntt_shoup(self->inverse_p1, p2);
+	self->inverse_p1p2_shoup = ntt_shoup(self->inverse_p1p2, p3);
+
+	return self;
+}
+
+/* Linear convolution of two sequences of 64-bit unsigned numbers,
+ *
+ *   out[k] = sum a[i] b[k - i],  0 <= k < a_length + b_length - 1,
+ *
+ * exactly. Each result is three 64-bit words, least significant first.
+ * The three moduli run on separate threads when built with OpenMP.
+ *
+ * @conv: The convolver
+ * @a: First sequence
+ * @a_length: Its length, at least 1
+ * @b: Second sequence (may be `a')
+ * @b_length: Its length, at least 1
+ * @out: 3 (a_length + b_length - 1) words
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_ntt_convolve(bina_ntt_convolver conv, const uint64_t *a,
+		int a_length, const uint64_t *b, int b_length, uint64_t *out)
+{
+	struct ntt_convolver *self = conv;
+	int length = self->length;
+	int out_length = a_length + b_length - 1;
+
+	if (a_length <= 0 || b_length <= 0
+			|| out_length > self->max_length) {
+		log_error("Convolution longer than the convolver\n");
+		return -1;
+	}
+
+#	ifdef _OPENMP
+#	pragma omp parallel for schedule(static)
+#	endif
+	for (int k = 0; k < NTT_MODULI; k++) {
+		uint64_t p = ntt_modulus(self->ntt[k]);
+		uint64_t *fa = self->work[k];
+		uint64_t *fb = fa + length;
+
+		load(fa, a, a_length, length, p);
+		ntt_forward_on(self->ntt[k], fa);
+
+		if (b == a && b_length == a_length) {
+			ntt_multiply(self->ntt[k], fa, fa);
+		} else {
+			load(fb, b, b_length, length, p);
+			ntt_forward_on(self->ntt[k], fb);
+			ntt_multiply(self->ntt[k], fa, fb);
+		}
+
+		ntt_inverse_on(self->ntt[k], fa);
+	}
+
+	for (int i = 0; i < out_length; i++) {
+		garner(self, self->work[0][i], self->work[1][i],
+				self->work[2][i], out + 3 * (size_t) i);
+	}
+
+	return 0;
+}
+
+/* Frees an exact convolver.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_ntt_convolver_free(bina_ntt_convolver conv)
+{
+	struct ntt_convolver *self = conv;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	for (int k = 0; k < NTT_MODULI; k++) {
+		if (self->ntt[k]) {
+			bina_transform_free(self->ntt[k]);
+		}
+
+		aligned_free(self->work[k]);
+	}
+
+	free(self);
+
+	return 0;
+}
+
+/* Reduces a sequence modulo p, zero padded.
+ *
+ * @dst: Destination, `padded_length' residues
+ * @src: Source, `length' numbers
+ * @length: Number of numbers
+ * @padded_length: Number of residues
+ * @p: Modulus
+ *
+ * @return None
+ */
+static void load(uint64_t *dst, const uint64_t *src, int length,
+		int padded_length, uint64_t p)
+{
+	for (int i = 0; i < length; i++) {
+		dst[i] = src[i] % p;
+	}
+
+	memset(dst + length, 0, (padded_length - length) * sizeof(uint64_t));
+}
+
+/* Joins the residues of a number modulo p1, p2 and p3, each below 2p, as
+ *
+ *   x = r1 + p1 k2 + p1 p2 k3,
+ *   k2 = (r2 - r1) / p1 mod p2,
+ *   k3 = (r3 - r1 - p1 k2) / (p1 p2) mod p3.
+ *
+ * @self: The convolver
+ * @r1, r2, r3: Residues
+ * @dst: Three words of x, least significant first
+ *
+ * @return None
+ */
+static void garner(const struct ntt_convolver *self, uint64_t r1,
+		uint64_t r2, uint64_t r3, uint64_t *dst)
+{
+	uint64_t p1 = bina_ntt_modulus(0);
+	uint64_t p2 = bina_ntt_modulus(1);
+	uint64_t p3 = bina_ntt_modulus(2);
+	uint64_t k2;
+	uint64_t k3;
+	uint64_t y;
+	ntt_wide low;
+	ntt_wide t;
+
+	r1 = ntt_reduce(r1, p1);
+	r2 = ntt_reduce(r2, p2);
+	r3 = ntt_reduce(r3, p3);
+
+	/* r1 < p1 may exceed p2, r2 - r1 mod p2 stays below 2 p2 + p2 */
+	k2 = ntt_mul_shoup(r2 + 2 * p2 - r1 % p2, self->inverse_p1,
+			self->inverse_p1_shoup, p2);
+	k2 = ntt_reduce(k2, p2);
+
+	low = (ntt_wide) p1 * k2 + r1;
+	y = (uint64_t) (low % p3);
+	k3 = ntt_mul_shoup(r3 + p3 - y, self->inverse_p1p2,
+			self->inverse_p1p2_shoup, p3);
+	k3 = ntt_reduce(k3, p3);
+
+	/* x = low + p1p2 k3, in three words */
+	t = (ntt_wide) (uint64_t) self->p1p2 * k3 + (uint64_t) low;
+	dst[0] = (uint64_t) t;
+	t = (ntt_wide) (uint64_t) (self->p1p2 >> 64) * k3 + (t >> 64)
+		+ (uint64_t) (low >> 64);
+	dst[1] = (uint64_t) t;
+	dst[2] = (uint64_t) (t >> 64);
+}
@@ -0,0 +1,506 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* nufft.c - Non-uniform FFT in one dimension, for N modes -N/2 <= k < N/2
+* and M points x[j] (in radians), with s = +1 or -1:
+*
+*   type 1: f[k] = sum c[j] exp(s i k x[j])
+*   type 2: c[j] = sum f[k] exp(s i k x[j])
+*
+* Type 1 spreads each point onto an oversampled grid of G >= 2N points with
+* a kernel w grid points wide, transforms the grid, and divides the modes by
+* the Fourier transform of the kernel. Type 2 does the same steps backwards,
+* interpolating the grid at the points. The points are sorted by grid
+* position when the plan is made, and each thread spreads a run of them
+* into a private piece of the grid, which is then added into the grid.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/window.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/* Kernel width in grid points at most */
+#define NUFFT_MAX_WIDTH (16)
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+
+/* A point, at grid position start + offset */
+struct nufft_point {
+	int start;                      /* First grid point of the kernel,
+					 * not wrapped around.
+					 */
+
+	double offset;                  /* Position relative to `start' */
+
+	int index;                      /* Index of the point in the input */
+};
+
+struct nufft {
+	int type;                       /* 1 or 2 */
+
+	int modes;                      /* N */
+
+	int num_points;                 /* M */
+
+	int grid_length;                /* G, power of two */
+
+	int width;                      /* w */
+
+	double beta;                    /* Shape of the kernel */
+
+	int kaiser_bessel;              /* Nonzero for Kaiser-Bessel */
+
+	struct nufft_point *points;     /* Sorted by `start' */
+
+	double *correction;             /* 1 / kernel transform, N modes */
+
+	bina_complex *grid;             /* G points */
+
+	bina_transform fft;             /* G point transform */
+
+	int num_chunks;                 /* Runs of points, one per thread */
+
+	int *chunk_start;               /* First point of each run, and M */
+
+	int *chunk_grid;                /* Offset of each run in `subgrid' */
+
+	bina_complex *subgrid;          /* Private grid pieces of the runs */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static double kernel(const struct nufft *self, double z);
+
+static void kernel_taps(const struct nufft *self, double offset,
+		double *taps);
+
+static int fill_correction(struct nufft *self);
+
+static int compare_points(const void *a, const void *b);
+
+static void spread(struct nufft *self, const bina_complex *in);
+
+static void interpolate(struct nufft *self, bina_complex *out);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a 1-D non-uniform FFT plan.
+ *
+ * @type: 1 (points to modes) or 2 (modes to points)
+ * @modes: N, number of modes (MUST be even)
+ * @points: M positions in radians, any real values (2 pi periodic)
+ * @num_points: M
+ * @tolerance: Relative accuracy wanted, 1e-14 to 1e-1
+ * @flags: BINA_FFT_INVERSE for exp(+i k x), exp(-i k x) otherwise;
+ *         BINA_NUFFT_KAISER_BESSEL for the Kaiser-Bessel kernel instead of
+ *         the exponential of semicircle; BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @return A new plan, or NULL on failure.
+ */
+bina_nufft bina_nufft_create(int type, int modes, const double *points,
+		int num_points, double tolerance, int flags)
+{
+	struct nufft *self = NULL;
+	int w = (int) ceil(-log10(tolerance)) + 1;
+	int g = 2;
+	int failed = 0;
+	size_t subgrid_length = 0;
+
+	if ((type != 1 && type != 2) || modes <= 0 || modes % 2
+			|| num_points <= 0 || !(tolerance > 0.0)) {
+		log_error("Bad NUFFT type, modes, points or tolerance\n");
+		return NULL;
+	}
+
+	w = (w < 2) ? 2 : (w > NUFFT_MAX_WIDTH) ? NUFFT_MAX_WIDTH : w;
+
+	while (g < 2 * modes || g < 2 * w) {
+		g *= 2;
+	}
+
+	if ((self = calloc(1, sizeof(struct nufft))) == NULL) {
+		log_error("Allocating NUFFT instance\n");
+		return NULL;
+	}
+
+	self->type = type;
+	self->modes = modes;
+	self->num_points = num_points;
+	self->grid_length = g;
+	self->width = w;
+	self->kaiser_bessel = (flags & BINA_NUFFT_KAISER_BESSEL) != 0;
+	self->num_chunks = 1;
+
+	/* Shapes for a grid twice the number of modes */
+	if (self->kaiser_bessel) {
+		self->beta = M_PI * sqrt(0.5625 * w * w - 0.8);
+	} else {
+		self->beta = 2.30 * w;
+	}
+
+#	ifdef _OPENMP
+	self->num_chunks = omp_get_max_threads();
+#	endif
+
+	if (self->num_chunks > num_points) {
+		self->num_chunks = num_points;
+	}
+
+	self->points = calloc(num_points, sizeof(struct nufft_point));
+	self->correction = aligned_malloc(BINA_FFT_ALIGNMENT, modes,
+			sizeof(double));
+	self->grid = aligned_malloc(BINA_FFT_ALIGNMENT, g,
+			sizeof(bina_complex));
+	self->chunk_start = calloc(self->num_chunks + 1, sizeof(int));
+	self->chunk_grid = calloc(self->num_chunks + 1, sizeof(int));
+	self->fft = bina_transform_create_radix2_c2c_fft(NULL, NULL, g,
+			flags & (BINA_FFT_INVERSE | BINA_FFT_COMPACT_TWIDDLE));
+
+	failed = (self->points == NULL || self->correction == NULL
+			|| self->grid == NULL || self->chunk_start == NULL
+			|| self->chunk_grid == NULL || self->fft == NULL);
+
+	if (failed || fill_correction(self) != 0) {
+		log_error("Allocating NUFFT buffers\n");
+		bina_nufft_free(self);
+		return NULL;
+	}
+
+	/* Grid position p = x G / (2 pi), in [0, G) */
+	for (int j = 0; j < num_points; j++) {
+		double p = points[j] / (2.0 * M_PI);
+
+		p = (p - floor(p)) * g;
+		self->points[j].start = (int) ceil(p - 0.5 * w);
+		self->points[j].offset = p - self->points[j].start;
+		self->points[j].index = j;
+	}
+
+	qsort(self->points, num_points, sizeof(struct nufft_point),
+			compare_points);
+
+	/* Runs of consecutive points, each with a piece of grid of its own */
+	for (int c = 0; c <= self->num_chunks; c++) {
+		self->chunk_start[c] = (int) ((long) num_points * c
+				/ self->num_chunks);
+	}
+
+	for (int c = 0; type == 1 && c < self->num_chunks; c++) {
+		const struct nufft_point *first =
+			&self->points[self->chunk_start[c]];
+		const struct nufft_point *last =
+			&self->points[self->chunk_start[c + 1] - 1];
+
+		self->chunk_grid[c] = subgrid_length;
+		subgrid_length += last->start - first->start + w;
+	}
+
+	self->chunk_grid[self->num_chunks] = subgrid_length;
+
+	if (type == 1) {
+		self->subgrid = aligned_malloc(BINA_FFT_ALIGNMENT,
+				subgrid_length, sizeof(bina_complex));
+
+		if (self->subgrid == NULL) {
+			log_error("Allocating NUFFT spreading grids\n");
+			bina_nufft_free(self);
+			return NULL;
+		}
+	}
+
+	return self;
+}
+
+/* Runs a non-uniform FFT.
+ *
+ * @nufft: The plan
+ * @in: M strengths (type 1) or N modes, -N/2 first (type 2)
+ * @out: N modes, -N/2 first (type 1) or M values (type 2)
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_nufft_execute(bina_nufft nufft, const bina_complex *in,
+		bina_complex *out)
+{
+	struct nufft *self = nufft;
+	int half = self->modes / 2;
+	int mask = self->grid_length - 1;
+
+	if (self->type == 1) {
+		spread(self, in);
+		radix2_c2c_fft_execute_on(self->fft, self->grid, self->grid);
+
+		for (int k = -half; k < half; k++) {
+			out[k + half] = self->grid[k & mask]
+				* self->correction[k + half];
+		}
+
+		return 0;
+	}
+
+	memset(self->grid, 0, self->grid_length * sizeof(bina_complex));
+
+	for (int k = -half; k < half; k++) {
+		self->grid[k & mask] = in[k + half]
+			* self->correction[k + half];
+	}
+
+	radix2_c2c_fft_execute_on(self->fft, self->grid, self->grid);
+	interpolate(self, out);
+
+	return 0;
+}
+
+/* Frees a non-uniform FFT plan.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_nufft_free(bina_nufft nufft)
+{
+	struct nufft *self = nufft;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	free(self->points);
+	aligned_free(self->correction);
+	aligned_free(self->grid);
+	free(self->chunk_start);
+	free(self->chunk_grid);
+	aligned_free(self->subgrid);
+	free(self);
+
+	return 0;
+}
+
+/* Spreads the strengths onto the grid. Each run of sorted points goes into
+ * its own piece of grid, in parallel, and the pieces are then added into
+ * the grid, wrapping around.
+ *
+ * @self: The plan
+ * @in: M strengths
+ *
+ * @return None
+ */
+static void spread(struct nufft *self, const bina_complex *in)
+{
+	int w = self->width;
+	int mask = self->grid_length - 1;
+
+#	ifdef _OPENMP
+#	pragma omp parallel for schedule(static) num_threads(self->num_chunks)
+#	endif
+	for (int c = 0; c < self->num_chunks; c++) {
+		bina_complex *local = self->subgrid + self->chunk_grid[c];
+		int length = self->chunk_grid[c + 1] - self->chunk_grid[c];
+		int base = self->points[self->chunk_start[c]].start;
+		double taps[NUFFT_MAX_WIDTH];
+
+		memset(local, 0, length * sizeof(bina_complex));
+
+		for (int j = self->chunk_start[c];
+				j < self->chunk_start[c + 1]; j++) {
+			const struct nufft_point *pt = &self->points[j];
+			bina_complex *dst = local + (pt->start - base);
+			bina_complex s = in[pt->index];
+
+			kernel_taps(self, pt->offset, taps);
+
+			for (int t = 0; t < w; t++) {
+				dst[t] += s * taps[t];
+			}
+		}
+	}
+
+	memset(self->grid, 0, self->grid_length * sizeof(bina_complex));
+
+	for (int c = 0; c < self->num_chunks; c++) {
+		const bina_complex *local = self->subgrid + self->chunk_grid[c];
+		int length = self->chunk_grid[c + 1] - self->chunk_grid[c];
+		int base = self->points[self->chunk_start[c]].start;
+
+		for (int l = 0; l < length; l++) {
+			self->grid[(base + l) & mask] += local[l];
+		}
+	}
+}
+
+/* Interpolates the grid at every point, in parallel.
+ *
+ * @self: The plan
+ * @out: M values
+ *
+ * @return None
+ */
+static void interpolate(struct nufft *self, bina_complex *out)
+{
+	int w = self->width;
+	int mask = self->grid_length - 1;
+
+#	ifdef _OPENMP
+#	pragma omp parallel for schedule(static)
+#	endif
+	for (int j = 0; j < self->num_points; j++) {
+		const struct nufft_point *pt = &self->points[j];
+		double taps[NUFFT_MAX_WIDTH];
+		bina_complex sum = 0.0;
+
+		kernel_taps(self, pt->offset, taps);
+
+		for (int t = 0; t < w; t++) {
+			sum += self->grid[(pt->start + t) & mask] * taps[t];
+		}
+
+		out[pt->index] = sum;
+	}
+}
+
+/* The kernel at z in [-1, 1], the grid points of its width mapped there */
+static double kernel(const struct nufft *self, double z)
+{
+	double r = 1.0 - z * z;
+
+	if (r <= 0.0) {
+		return 0.0;
+	}
+
+	if (self->kaiser_bessel) {
+		return window_bessel_i0(self->beta * sqrt(r))
+			/ window_bessel_i0(self->beta);
+	}
+
+	return exp(self->beta * (sqrt(r) - 1.0));
+}
+
+/* Kernel values at the w grid points of a point.
+ *
+ * @self: The plan
+ * @offset: Position of the point from its first grid point
+ * @taps: Destination, w values
+ *
+ * @return None
+ */
+static void kernel_taps(const struct nufft *self, double offset,
+		double *taps)
+{
+	double scale = 2.0 / self->width;
+
+	for (int t = 0; t < self->width; t++) {
+		taps[t] = kernel(self, (t - offset) * scale);
+	}
+}
+
+/* Fills the deconvolution factors, 1 / K(2 pi k / G) where K is the Fourier
+ * transform of the kernel in grid units,
+ *
+ *   K(a) = integral of kernel(2t / w) cos(a t) dt over -w/2 < t < w/2,
+ *
+ * computed with Gauss-Legendre quadrature.
+ *
+ * @self: The plan
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int fill_correction(struct nufft *self)
+{
+	int q = 2 * self->width + 16;
+	double *node = calloc(q, sizeof(double));
+	double *weight = calloc(q, sizeof(double));
+	double half_width = 0.5 * self->width;
+	int half = self->modes / 2;
+
+	if (node == NULL || weight == NULL) {
+		free(node);
+		free(weight);
+		return -1;
+	}
+
+	/* Roots of the Legendre polynomial P_q by Newton's method */
+	for (int i = 0; i < q; i++) {
+		double x = cos(M_PI * (i + 0.75) / (q + 0.5));
+		double dp = 1.0;
+
+		for (int iter = 0; iter < 100; iter++) {
+			double p0 = 1.0;
+			double p1 = x;
+			double dx;
+
+			for (int k = 2; k <= q; k++) {
+				double p2 = ((2 * k - 1) * x * p1
+						- (k - 1) * p0) / k;
+				p0 = p1;
+				p1 = p2;
+			}
+
+			dp = q * (x * p1 - p0) / (x * x - 1.0);
+			dx = p1 / dp;
+			x -= dx;
+
+			if (fabs(dx) < 1e-16) {
+				break;
+			}
+		}
+
+		node[i] = x;
+		weight[i] = 2.0 / ((1.0 - x * x) * dp * dp);
+	}
+
+	for (int k = -half; k < half; k++) {
+		double a = 2.0 * M_PI * k / self->grid_length;
+		double sum = 0.0;
+
+		for (int i = 0; i < q; i++) {
+			double t = half_width * node[i];
+
+			sum += weight[i] * kernel(self, node[i]) * cos(a * t);
+		}
+
+		self->correction[k + half] = 1.0 / (sum * half_width);
+	}
+
+	free(node);
+	free(weight);
+
+	return 0;
+}
+
+/* Orders points by their first grid point */
+static int compare_points(const void *a, const void *b)
+{
+	const struct nufft_point *pa = a;
+	const struct nufft_point *pb = b;
+
+	return (pa->start > pb->start) - (pa->start < pb->start);
+}
@@ -0,0 +1,652 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* partitioned_convolver.c - Low latency FIR filter for long real impulse
+* responses: the filter is cut into partitions that are small at its head
+* and grow towards its tail, each size with its own frequency-domain delay
+* line (FDL).
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/arena.h"
+#include "internal/bitmagic.h"
+#include "internal/complex_kernels.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/radix2_r2c_fft.h"
+
+/* Partition size ratio between neighbouring levels */
+#ifndef BINA_PARTITION_GROWTH
+#define BINA_PARTITION_GROWTH (4)
+#endif
+
+#define MAX_LEVELS (32)
+
+/*******************************************************************************
+* Data structure
+*
+* A level convolves with taps [offset, offset + P L) of the filter in P
+* partitions of L taps, by overlap-save with 2L point real transforms:
+* every L samples its FDL takes the spectrum of the last 2L input samples,
+* and the product of the FDL with the partition spectra is transformed back
+* into L output samples.
+*
+* The first level has L = block length and runs in the call that completes
+* its block, so the output is not delayed. Every later level starts 2L taps
+* into the filter, so the output of one of its blocks is only due a whole
+* block after the block is complete. Its work is cut into units of similar
+* cost (butterflies, bins) and spread evenly over the calls of that block:
+* no call does more than its share, whatever the partition sizes.
+*******************************************************************************/
+struct level {
+	int length;                     /* L, partition and hop size */
+
+	int offset;                     /* First tap of the level */
+
+	int partitions;                 /* P, partitions of this level */
+
+	int period;                     /* L / block length, calls per hop */
+
+	int phase;                      /* Call within the period */
+
+	bina_real *frames;              /* Three input frames of 2L samples:
+					 * the one being filled, the next one
+					 * (whose first half is filled at the
+					 * same time) and the one being
+					 * transformed.
+					 */
+
+	int frame;                      /* Frame being filled */
+
+	const bina_complex *source;     /* Frame being transformed */
+
+	bina_complex *fdl;              /* P spectra of L + 1 bins, ring */
+
+	int head;                       /* FDL slot of the newest spectrum */
+
+	bina_complex *response;         /* P filter partition spectra, scaled
+					 * by 1 / 2L.
+					 */
+
+	bina_complex *sum;              /* FDL times filter, L + 1 bins */
+
+	bina_complex *merged;           /* `sum' merged for the half length
+					 * inverse transform, L entries.
+					 */
+
+	bina_complex *pending;          /* Output being computed, 2L samples */
+
+	bina_complex *ready;            /* Output being played, 2L samples;
+					 * same buffer as `pending' on the
+					 * first level.
+					 */
+
+	bina_complex *twiddle;          /* Split and merge twiddle factors */
+
+	bina_transform forward;         /* L point complex, forward */
+
+	bina_transform inverse;         /* L point complex, inverse */
+
+	long done;                      /* Units done in this period */
+
+	long budget;                    /* Units per call */
+};
+
+struct partitioned_convolver {
+	int block_length;               /* Samples per call */
+
+	int num_levels;                 /* Levels in use */
+
+	struct level levels[MAX_LEVELS];
+
+	struct arena arena;             /* Buffers of all levels */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void plan_levels(struct partitioned_convolver *self,
+		int filter_length, int max_partition_length);
+
+static size_t level_size(const struct level *lv);
+
+static void level_carve(struct level *lv, struct arena *arena);
+
+static void level_transform_filter(struct level *lv, const bina_real *filter,
+		int filter_length);
+
+static long level_forward_units(const struct level *lv);
+
+static long level_units(const struct level *lv);
+
+static void level_write(struct level *lv, const bina_real *in, int length);
+
+static void level_begin(struct level *lv);
+
+static void level_run(struct level *lv, long budget);
+
+static long run_forward(struct level *lv, const bina_complex *src,
+		bina_complex *dst, long pos, long budget);
+
+static long run_product(struct level *lv, long pos, long budget);
+
+static long run_inverse(struct level *lv, long pos, long budget);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a partitioned convolver, y = h * x, that processes fixed size
+ * blocks with no delay other than the block itself.
+ *
+ * @filter: Impulse response h (copied)
+ * @filter_length: Number of taps
+ * @block_length: Samples per call (power of two, at least 2)
+ * @max_partition_length: Largest partition (power of two); partitions grow
+ *                        from `block_length' up to it. Zero, or
+ *                        `block_length', gives uniform partitions.
+ * @flags: Extra flags for the transforms
+ *
+ * @return A new convolver, or NULL on failure.
+ */
+bina_partitioned_convolver bina_partitioned_convolver_create(
+		const bina_real *filter, int filter_length, int block_length,
+		int max_partition_length, int flags)
+{
+	struct partitioned_convolver *self = NULL;
+	size_t size = 0;
+
+	if (filter == NULL || filter_length <= 0) {
+		log_error("Empty filter\n");
+		return NULL;
+	}
+
+	if (max_partition_length == 0) {
+		max_partition_length = block_length;
+	}
+
+	if (!ispowtwo(block_length) || block_length < 2
+			|| !ispowtwo(max_partition_length)
+			|| max_partition_length < block_length) {
+		log_error("Block and partition lengths must be powers of two\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct partitioned_convolver))) == NULL) {
+		log_error("Allocating convolver instance\n");
+		return NULL;
+	}
+
+	self->block_length = block_length;
+	plan_levels(self, filter_length, max_partition_length);
+
+	for (int s = 0; s < self->num_levels; s++) {
+		struct level *lv = &self->levels[s];
+
+		lv->forward = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+				lv->length, flags & ~BINA_FFT_INVERSE);
+		lv->inverse = bina_transform_create_radix2_c2c_fft(NULL, NULL,
+				lv->length, flags | BINA_FFT_INVERSE);
+
+		if (lv->forward == NULL || lv->inverse == NULL) {
+			log_error("Allocating convolver transforms\n");
+			bina_partitioned_convolver_free(self);
+			return NULL;
+		}
+
+		size += level_size(lv);
+	}
+
+	if (arena_create(&self->arena, size) != 0) {
+		log_error("Allocating convolver buffers\n");
+		self->arena.mapping = NULL;
+		bina_partitioned_convolver_free(self);
+		return NULL;
+	}
+
+	memset(self->arena.base, 0, size);
+
+	for (int s = 0; s < self->num_levels; s++) {
+		struct level *lv = &self->levels[s];
+
+		level_carve(lv, &self->arena);
+		radix2_r2c_fft_fill_twiddle(lv->twiddle, 2 * lv->length);
+		level_transform_filter(lv, filter, filter_length);
+
+		/* Each call does its share of a period, rounded up */
+		lv->budget = (level_units(lv) + lv->period - 1) / lv->period;
+		lv->head = lv->partitions - 1;
+	}
+
+	return self;
+}
+
+/* Filters one block of samples.
+ *
+ * @conv: The convolver
+ * @in: Input samples, block length of them
+ * @out: Output samples, may equal `in'
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_partitioned_convolver_process(bina_partitioned_convolver conv,
+		const bina_real *in, bina_real *out)
+{
+	struct partitioned_convolver *self = conv;
+	struct level *first = &self->levels[0];
+	int block_length = self->block_length;
+
+	/* Later levels move on to the block completed by the previous call */
+	for (int s = 1; s < self->num_levels; s++) {
+		if (self->levels[s].phase == 0) {
+			level_begin(&self->levels[s]);
+		}
+	}
+
+	for (int s = 0; s < self->num_levels; s++) {
+		level_write(&self->levels[s], in, block_length);
+	}
+
+	/* The first level transforms the block it was just given */
+	level_begin(first);
+	level_run(first, level_units(first));
+
+	for (int s = 1; s < self->num_levels; s++) {
+		level_run(&self->levels[s], self->levels[s].budget);
+	}
+
+	/* The last half of a 2L output frame is valid */
+	memcpy(out, (const bina_real *) first->ready + first->length,
+			block_length * sizeof(bina_real));
+
+	for (int s = 1; s < self->num_levels; s++) {
+		struct level *lv = &self->levels[s];
+		const bina_real *y = (const bina_real *) lv->ready + lv->length
+			+ lv->phase * block_length;
+
+		for (int i = 0; i < block_length; i++) {
+			out[i] += y[i];
+		}
+
+		lv->phase = (lv->phase + 1) % lv->period;
+	}
+
+	return 0;
+}
+
+/* Frees a partitioned convolver.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_partitioned_convolver_free(bina_partitioned_convolver conv)
+{
+	struct partitioned_convolver *self = conv;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	for (int s = 0; s < self->num_levels; s++) {
+		if (self->levels[s].forward) {
+			bina_transform_free(self->levels[s].forward);
+		}
+
+		if (self->levels[s].inverse) {
+			bina_transform_free(self->levels[s].inverse);
+		}
+	}
+
+	if (self->arena.mapping) {
+		arena_release(&self->arena);
+	}
+
+	free(self);
+
+	return 0;
+}
+
+/* Cuts the filter into levels. A level hands over to partitions
+ * BINA_PARTITION_GROWTH times larger once it has covered two of them, so
+ * every later level starts at twice its partition length (a level starting
+ * at 2L covers at most 3L before that point). The last level takes
+ * whatever is left.
+ *
+ * @self: The convolver
+ * @filter_length: Number of taps
+ * @max_partition_length: Largest partition
+ *
+ * @return None
+ */
+static void plan_levels(struct partitioned_convolver *self,
+		int filter_length, int max_partition_length)
+{
+	long length = self->block_length;
+	long offset = 0;
+	int s = 0;
+
+	while (offset < filter_length) {
+		struct level *lv = &self->levels[s++];
+		long next = length * BINA_PARTITION_GROWTH;
+		long handover = 2 * next;
+		int partitions = (filter_length - offset + length - 1) / length;
+
+		lv->length = length;
+		lv->offset = offset;
+		lv->period = length / self->block_length;
+
+		if (next <= max_partition_length && s < MAX_LEVELS
+				&& offset + partitions * length > handover) {
+			lv->partitions = (handover - offset) / length;
+			offset = handover;
+			length = next;
+		} else {
+			lv->partitions = partitions;
+			offset = filter_length;
+		}
+	}
+
+	self->num_levels = s;
+}
+
+/* Returns the number of arena bytes the buffers of a level take up.
+ *
+ * @lv: The level, with its lengths set
+ *
+ * @return Number of bytes
+ */
+static size_t level_size(const struct level *lv)
+{
+	size_t length = lv->length;
+	size_t spectra = (size_t) lv->partitions * (length + 1);
+	size_t size = 0;
+
+	size += arena_size(3 * 2 * length * sizeof(bina_real));
+	size += 2 * arena_size(spectra * sizeof(bina_complex));
+	size += arena_size((length + 1) * sizeof(bina_complex));
+	size += arena_size(length * sizeof(bina_complex));
+	size += arena_size(length * sizeof(bina_complex));
+	size += arena_size(RADIX2_R2C_FFT_PAIRS(2 * length)
+			* sizeof(bina_complex));
+
+	/* The first level plays what it computes */
+	if (lv->period > 1) {
+		size += arena_size(length * sizeof(bina_complex));
+	}
+
+	return size;
+}
+
+/* Carves the buffers of a level, in the order of level_size().
+ *
+ * @lv: The level
+ * @arena: Arena sized with level_size()
+ *
+ * @return None
+ */
+static void level_carve(struct level *lv, struct arena *arena)
+{
+	size_t length = lv->length;
+	size_t spectra = (size_t) lv->partitions * (length + 1);
+
+	lv->frames = arena_carve(arena, 3 * 2 * length * sizeof(bina_real));
+	lv->fdl = arena_carve(arena, spectra * sizeof(bina_complex));
+	lv->response = arena_carve(arena, spectra * sizeof(bina_complex));
+	lv->sum = arena_carve(arena, (length + 1) * sizeof(bina_complex));
+	lv->merged = arena_carve(arena, length * sizeof(bina_complex));
+	lv->pending = arena_carve(arena, length * sizeof(bina_complex));
+	lv->twiddle = arena_carve(arena, RADIX2_R2C_FFT_PAIRS(2 * length)
+			* sizeof(bina_complex));
+	lv->ready = lv->pending;
+
+	if (lv->period > 1) {
+		lv->ready = arena_carve(arena, length * sizeof(bina_complex));
+	}
+}
+
+/* Computes the partition spectra of a level, zero padded to 2L taps and
+ * divided by 2L to fold in the scaling of the inverse transform.
+ *
+ * @lv: The level
+ * @filter: Impulse response
+ * @filter_length: Number of taps
+ *
+ * @return None
+ */
+static void level_transform_filter(struct level *lv, const bina_real *filter,
+		int filter_length)
+{
+	long units = level_forward_units(lv);
+	int bins = lv->length + 1;
+	/* Borrow an input frame, they are all zero still */
+	bina_real *pad = lv->frames;
+
+	for (int p = 0; p < lv->partitions; p++) {
+		bina_complex *dst = lv->response + (size_t) p * bins;
+		int first = lv->offset + p * lv->length;
+		int count = filter_length - first;
+
+		if (count > lv->length) {
+			count = lv->length;
+		}
+
+		memset(pad, 0, lv->length * sizeof(bina_real));
+		memcpy(pad, filter + first, count * sizeof(bina_real));
+
+		for (long pos = 0; pos < units;) {
+			pos += run_forward(lv, (const bina_complex *) pad, dst,
+					pos, units - pos);
+		}
+
+		for (int k = 0; k < bins; k++) {
+			dst[k] /= 2.0 * lv->length;
+		}
+	}
+
+	memset(pad, 0, lv->length * sizeof(bina_real));
+}
+
+/* Units of the real transform of one 2L sample frame.
+ *
+ * @lv: The level
+ *
+ * @return Number of units
+ */
+static long level_forward_units(const struct level *lv)
+{
+	return (long) radix2_c2c_fft_steps(lv->forward)
+		* radix2_c2c_fft_step_units(lv->forward)
+		+ RADIX2_R2C_FFT_PAIRS(2 * lv->length);
+}
+
+/* Units of work per period: forward transform, products, inverse
+ * transform (the same size as the forward one).
+ *
+ * @lv: The level
+ *
+ * @return Number of units
+ */
+static long level_units(const struct level *lv)
+{
+	return 2 * level_forward_units(lv)
+		+ (long) lv->partitions * (lv->length + 1);
+}
+
+/* Stores input samples into the frame being filled, and into the first
+ * half of the next one, which overlaps it.
+ *
+ * @lv: The level
+ * @in: Input samples
+ * @length: Number of samples
+ *
+ * @return None
+ */
+static void level_write(struct level *lv, const bina_real *in, int length)
+{
+	size_t frame_length = 2 * lv->length;
+	int pos = lv->phase * length;
+	bina_real *cur = lv->frames + lv->frame * frame_length;
+	bina_real *next = lv->frames + ((lv->frame + 1) % 3) * frame_length;
+
+	memcpy(cur + lv->length + pos, in, length * sizeof(bina_real));
+	memcpy(next + pos, in, length * sizeof(bina_real));
+}
+
+/* Starts a period: the frame just filled is handed to the transform, its
+ * spectrum replaces the oldest one in the FDL, and the output computed in
+ * the previous period starts playing.
+ *
+ * @lv: The level
+ *
+ * @return None
+ */
+static void level_begin(struct level *lv)
+{
+	bina_complex *played = lv->ready;
+
+	lv->source = (const bina_complex *)
+		(lv->frames + lv->frame * 2 * lv->length);
+	lv->frame = (lv->frame + 1) % 3;
+	lv->head = (lv->head + 1) % lv->partitions;
+	lv->done = 0;
+
+	lv->ready = lv->pending;
+	lv->pending = played;
+}
+
+/* Carries on with the work of the period, for at most `budget' units.
+ *
+ * @lv: The level
+ * @budget: Number of units
+ *
+ * @return None
+ */
+static void level_run(struct level *lv, long budget)
+{
+	long forward = level_forward_units(lv);
+	long product = (long) lv->partitions * (lv->length + 1);
+	long total = level_units(lv);
+
+	while (budget > 0 && lv->done < total) {
+		long pos = lv->done;
+		long n = 0;
+
+		if (pos < forward) {
+			n = run_forward(lv, lv->source,
+					lv->fdl + (size_t) lv->head
+					* (lv->length + 1), pos, budget);
+		} else if (pos < forward + product) {
+			n = run_product(lv, pos - forward, budget);
+		} else {
+			n = run_inverse(lv, pos - forward - product, budget);
+		}
+
+		lv->done += n;
+		budget -= n;
+	}
+}
+
+/* Runs units of the real transform of a frame, up to the end of the step
+ * that `pos' falls in.
+ *
+ * @lv: The level
+ * @src: 2L real samples
+ * @dst: L + 1 bins
+ * @pos: First unit
+ * @budget: Most units to run
+ *
+ * @return Number of units run
+ */
+static long run_forward(struct level *lv, const bina_complex *src,
+		bina_complex *dst, long pos, long budget)
+{
+	long units = radix2_c2c_fft_step_units(lv->forward);
+	long steps = radix2_c2c_fft_steps(lv->forward);
+	long n;
+
+	if (pos < steps * units) {
+		n = units - pos % units;
+		n = (n < budget) ? n : budget;
+		radix2_c2c_fft_execute_step(lv->forward, src, dst,
+				pos / units, pos % units, n);
+		return n;
+	}
+
+	pos -= steps * units;
+	n = RADIX2_R2C_FFT_PAIRS(2 * lv->length) - pos;
+	n = (n < budget) ? n : budget;
+	radix2_r2c_fft_split(dst, lv->twiddle, 2 * lv->length, pos, n);
+
+	return n;
+}
+
+/* Runs units (bins) of the products of the FDL with the filter, one
+ * partition after another.
+ *
+ * @lv: The level
+ * @pos: First unit
+ * @budget: Most units to run
+ *
+ * @return Number of units run
+ */
+static long run_product(struct level *lv, long pos, long budget)
+{
+	int bins = lv->length + 1;
+	int p = pos / bins;
+	int first = pos % bins;
+	int slot = (lv->head - p + lv->partitions) % lv->partitions;
+	const double *x = (const double *) (lv->fdl + (size_t) slot * bins
+			+ first);
+	const double *h = (const double *) (lv->response + (size_t) p * bins
+			+ first);
+	double *acc = (double *) (lv->sum + first);
+	long n = bins - first;
+
+	n = (n < budget) ? n : budget;
+
+	if (p == 0) {
+		complex_multiply(acc, x, h, n);
+	} else {
+		complex_multiply_accumulate(acc, x, h, n);
+	}
+
+	return n;
+}
+
+/* Runs units of the inverse real transform of the products into the
+ * pending output, up to the end of the step that `pos' falls in.
+ *
+ * @lv: The level
+ * @pos: First unit
+ * @budget: Most units to run
+ *
+ * @return Number of units run
+ */
+static long run_inverse(struct level *lv, long pos, long budget)
+{
+	long pairs = RADIX2_R2C_FFT_PAIRS(2 * lv->length);
+	long units = radix2_c2c_fft_step_units(lv->inverse);
+	long n;
+
+	if (pos < pairs) {
+		n = pairs - pos;
+		n = (n < budget) ? n : budget;
+		radix2_r2c_fft_merge(lv->sum, lv->merged, lv->twiddle,
+				2 * lv->length, pos, n);
+		return n;
+	}
+
+	pos -= pairs;
+	n = units - pos % units;
+	n = (n < budget) ? n : budget;
+	radix2_c2c_fft_execute_step(lv->inverse, lv->merged, lv->pending,
+			pos / units, pos % units, n);
+
+	return n;
+}
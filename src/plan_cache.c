@@ -0,0 +1,505 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* plan_cache.c - On-disk cache of precomputed transform tables. The file is
+* mapped read-only, so every process on a host that opens the same cache
+* shares the physical pages, and planning becomes a page fault instead of a
+* loop of sin()/cos() calls.
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) || defined(__unix)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAS_MMAP (1)
+#else
+/* no mmap(), the whole file is read into memory instead */
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/* Tables are placed on cache line boundaries within the file */
+#define PLAN_CACHE_ALIGNMENT (64U)
+
+#define PLAN_CACHE_MAGIC "BINAFFT"
+#define PLAN_CACHE_VERSION (1U)
+#define PLAN_CACHE_BYTE_ORDER (0x01020304U)
+
+/*******************************************************************************
+* File format
+*
+* +--------+-----------+-----+-----------+----+---------+----+--------+-----+
+* | header | entry[0]  | ... | entry[n]  | // | twiddle | // | perm   | ... |
+* +--------+-----------+-----+-----------+----+---------+----+--------+-----+
+*
+* All fields are in the byte order of the host that wrote the file, which is
+* recorded in the header so a foreign file is rejected rather than misread.
+* Offsets are from the start of the file.
+*******************************************************************************/
+struct plan_cache_header {
+	char magic[8];                  /* PLAN_CACHE_MAGIC */
+	uint32_t version;               /* PLAN_CACHE_VERSION */
+	uint32_t byte_order;            /* PLAN_CACHE_BYTE_ORDER */
+	uint32_t real_size;             /* sizeof(bina_real), the precision */
+	uint32_t index_size;            /* Size of a permutation entry */
+	uint32_t num_entries;           /* Number of plan_cache_entry */
+	uint32_t reserved;
+	uint64_t file_size;             /* Total size of the file in bytes */
+};
+
+struct plan_cache_entry {
+	uint32_t fft_length;            /* Number of points of FFT */
+	uint32_t flags;                 /* Table layout flags */
+	uint64_t twiddle_offset;
+	uint64_t twiddle_count;
+	uint64_t perm_offset;
+	uint64_t perm_count;
+};
+
+/* An open cache */
+struct plan_cache {
+	unsigned char *base;            /* Start of the file contents */
+	size_t size;                    /* Size of the file contents */
+	int mapped;                     /* Nonzero if `base' is mmap()ed */
+	const struct plan_cache_header *header;
+	const struct plan_cache_entry *entries;
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static int write_padding(FILE *fp, uint64_t *offset);
+
+static int validate(const struct plan_cache *self);
+
+static const struct plan_cache_entry *find_entry(
+		const struct plan_cache *self, int fft_length, int flags);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Precomputes the tables of radix-2 transforms and stores them in a
+ * cache file. The file is written next to `path' and renamed over it once
+ * complete, so processes opening the cache never see a partial file.
+ *
+ * @path: Path of the cache file
+ * @fft_lengths: Problem sizes to store, powers of two
+ * @count: Number of problem sizes
+ * @flags: Plan flags the tables are made for
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_plan_cache_write(const char *path, const int *fft_lengths,
+		int count, int flags)
+{
+	struct plan_cache_header header;
+	struct plan_cache_entry *entries = NULL;
+	char *temp_path = NULL;
+	FILE *fp = NULL;
+	uint64_t offset = 0;
+	int status = -1;
+
+	if (path == NULL || fft_lengths == NULL || count <= 0) {
+		return -1;
+	}
+
+	/* One bad size would make the whole file unusable, check them all
+	 * before anything is written.
+	 */
+	for (int i = 0; i < count; i++) {
+		if (fft_lengths[i] <= 0 || !ispowtwo(fft_lengths[i])) {
+			log_error("Length is not power of two\n");
+			return -1;
+		}
+	}
+
+	entries = calloc(count, sizeof(struct plan_cache_entry));
+	temp_path = malloc(strlen(path) + sizeof(".tmp"));
+
+	if (entries == NULL || temp_path == NULL) {
+		log_error("Allocating plan cache index\n");
+		goto cleanup;
+	}
+
+	strcpy(temp_path, path);
+	strcat(temp_path, ".tmp");
+
+	if ((fp = fopen(temp_path, "wb")) == NULL) {
+		log_error("Opening plan cache %s\n", temp_path);
+		goto cleanup;
+	}
+
+	/* Leave room for the header and index, they are written last */
+	offset = sizeof(header) + count * sizeof(struct plan_cache_entry);
+
+	if (fseek(fp, (long) offset, SEEK_SET) != 0) {
+		goto cleanup;
+	}
+
+	for (int i = 0; i < count; i++) {
+		struct plan_cache_entry *entry = &entries[i];
+		bina_complex *twiddle = NULL;
+		unsigned int *perm = NULL;
+		size_t twiddle_count = 0;
+		size_t perm_count = 0;
+		int ok = 0;
+
+		if (radix2_c2c_fft_tables(fft_lengths[i], flags, &twiddle,
+				&twiddle_count, &perm, &perm_count) != 0) {
+			goto cleanup;
+		}
+
+		entry->fft_length = fft_lengths[i];
+		entry->flags = radix2_c2c_fft_table_layout(fft_lengths[i],
+				flags, NULL, NULL);
+		entry->twiddle_count = twiddle_count;
+		entry->perm_count = perm_count;
+
+		if (write_padding(fp, &offset) == 0) {
+			entry->twiddle_offset = offset;
+			ok = fwrite(twiddle, sizeof(bina_complex), twiddle_count,
+					fp) == twiddle_count;
+			offset += twiddle_count * sizeof(bina_complex);
+		}
+
+		if (ok && write_padding(fp, &offset) == 0) {
+			entry->perm_offset = offset;
+			ok = fwrite(perm, sizeof(unsigned int), perm_count,
+					fp) == perm_count;
+			offset += perm_count * sizeof(unsigned int);
+		}
+
+		aligned_free(twiddle);
+		aligned_free(perm);
+
+		if (!ok) {
+			log_error("Writing plan cache tables\n");
+			goto cleanup;
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PLAN_CACHE_MAGIC, sizeof(PLAN_CACHE_MAGIC));
+	header.version = PLAN_CACHE_VERSION;
+	header.byte_order = PLAN_CACHE_BYTE_ORDER;
+	header.real_size = sizeof(bina_real);
+	header.index_size = sizeof(unsigned int);
+	header.num_entries = count;
+	header.file_size = offset;
+
+	if (fseek(fp, 0, SEEK_SET) != 0
+			|| fwrite(&header, sizeof(header), 1, fp) != 1
+			|| fwrite(entries, sizeof(struct plan_cache_entry), count,
+				fp) != (size_t) count) {
+		log_error("Writing plan cache index\n");
+		goto cleanup;
+	}
+
+	status = fclose(fp);
+	fp = NULL;
+
+	if (status == 0 && (status = rename(temp_path, path)) != 0) {
+		log_error("Renaming plan cache to %s\n", path);
+	}
+
+cleanup:
+	if (fp != NULL) {
+		fclose(fp);
+	}
+
+	if (status != 0 && temp_path != NULL) {
+		remove(temp_path);
+	}
+
+	free(temp_path);
+	free(entries);
+
+	return status;
+}
+
+/* Opens a cache file written by bina_plan_cache_write(). The cache must stay
+ * open for as long as any transform created from it.
+ *
+ * @path: Path of the cache file
+ *
+ * @return The cache, or NULL if the file is missing, corrupt, or was written
+ * for a different version, precision or byte order.
+ */
+bina_plan_cache bina_plan_cache_open(const char *path)
+{
+	struct plan_cache *self = NULL;
+
+	if ((self = calloc(1, sizeof(struct plan_cache))) == NULL) {
+		return NULL;
+	}
+
+#	ifdef HAS_MMAP
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+
+	if (fd < 0) {
+		free(self);
+		return NULL;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		free(self);
+		return NULL;
+	}
+
+	self->size = st.st_size;
+	self->base = mmap(NULL, self->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (self->base == MAP_FAILED) {
+		log_error("Mapping plan cache %s\n", path);
+		free(self);
+		return NULL;
+	}
+
+	self->mapped = 1;
+#	else
+	FILE *fp = fopen(path, "rb");
+	long size = 0;
+
+	if (fp == NULL) {
+		free(self);
+		return NULL;
+	}
+
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0
+			|| fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		free(self);
+		return NULL;
+	}
+
+	self->size = size;
+	self->base = aligned_calloc(PLAN_CACHE_ALIGNMENT, self->size, 1);
+
+	if (self->base == NULL
+			|| fread(self->base, 1, self->size, fp) != self->size) {
+		fclose(fp);
+		aligned_free(self->base);
+		free(self);
+		return NULL;
+	}
+
+	fclose(fp);
+#	endif			/* ifdef HAS_MMAP */
+
+	self->header = (const struct plan_cache_header *) self->base;
+	self->entries = (const struct plan_cache_entry *) (self->header + 1);
+
+	if (validate(self) != 0) {
+		log_error("Rejecting plan cache %s\n", path);
+		bina_plan_cache_close(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Closes a cache opened by bina_plan_cache_open().
+ *
+ * @cache: The cache
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_plan_cache_close(bina_plan_cache cache)
+{
+	struct plan_cache *self = cache;
+	int status = 0;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+#	ifdef HAS_MMAP
+	if (self->mapped) {
+		status = munmap(self->base, self->size);
+	}
+#	else
+	aligned_free(self->base);
+#	endif
+
+	free(self);
+
+	return status;
+}
+
+/* Allocates a radix-2 complex-to-complex FFT transform class whose tables
+ * point into a plan cache. If the cache holds no tables for the problem, the
+ * tables are computed as by bina_transform_create_radix2_c2c_fft().
+ *
+ * @cache: Cache opened by bina_plan_cache_open(), may be NULL
+ * @in: Pointer to input buffer
+ * @out: Pointer to output buffer
+ * @fft_length: Length of the problem (MUST be power of two)
+ * @flags: Extra flags
+ *
+ * @returns A new transform class
+ */
+bina_transform bina_transform_create_radix2_c2c_fft_cached(
+		bina_plan_cache cache, bina_complex *in, bina_complex *out,
+		int fft_length, int flags)
+{
+	const struct plan_cache *self = cache;
+	const struct plan_cache_entry *entry = NULL;
+
+	if (self == NULL
+		|| (entry = find_entry(self, fft_length, flags)) == NULL) {
+		return bina_transform_create_radix2_c2c_fft(in, out,
+				fft_length, flags);
+	}
+
+	return radix2_c2c_fft_create_with_tables(in, out, fft_length, flags,
+			(const bina_complex *) (self->base
+				+ entry->twiddle_offset),
+			(const unsigned int *) (self->base
+				+ entry->perm_offset));
+}
+
+/* Pads the file with zeros up to the next PLAN_CACHE_ALIGNMENT boundary.
+ *
+ * @fp: File being written
+ * @offset: Current offset, updated
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int write_padding(FILE *fp, uint64_t *offset)
+{
+	static const unsigned char zeros[PLAN_CACHE_ALIGNMENT];
+	size_t padding = (PLAN_CACHE_ALIGNMENT
+			- (*offset & (PLAN_CACHE_ALIGNMENT - 1)))
+			& (PLAN_CACHE_ALIGNMENT - 1);
+
+	if (padding && fwrite(zeros, 1, padding, fp) != padding) {
+		return -1;
+	}
+
+	*offset += padding;
+
+	return 0;
+}
+
+/* Checks that the header matches this build and that every table lies
+ * within the file, suitably aligned and of the expected size.
+ *
+ * @self: The cache
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int validate(const struct plan_cache *self)
+{
+	const struct plan_cache_header *header = self->header;
+	uint64_t index_end = 0;
+
+	if (self->size < sizeof(*header)) {
+		return -1;
+	}
+
+	if (memcmp(header->magic, PLAN_CACHE_MAGIC, sizeof(PLAN_CACHE_MAGIC))
+			|| header->version != PLAN_CACHE_VERSION
+			|| header->byte_order != PLAN_CACHE_BYTE_ORDER
+			|| header->real_size != sizeof(bina_real)
+			|| header->index_size != sizeof(unsigned int)
+			|| header->file_size != self->size) {
+		return -1;
+	}
+
+	index_end = sizeof(*header)
+		+ (uint64_t) header->num_entries * sizeof(*self->entries);
+
+	if (index_end > self->size) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < header->num_entries; i++) {
+		const struct plan_cache_entry *entry = &self->entries[i];
+		size_t twiddle_count = 0;
+		size_t perm_count = 0;
+
+		uint64_t twiddle_bytes = 0;
+		uint64_t perm_bytes = 0;
+
+		if (entry->fft_length > INT32_MAX
+			|| !ispowtwo(entry->fft_length)) {
+			return -1;
+		}
+
+		radix2_c2c_fft_table_layout(entry->fft_length, entry->flags,
+				&twiddle_count, &perm_count);
+		twiddle_bytes = (uint64_t) twiddle_count * sizeof(bina_complex);
+		perm_bytes = (uint64_t) perm_count * sizeof(unsigned int);
+
+		/* Offsets come from the file, compare without adding them up
+		 * so a huge one cannot wrap around.
+		 */
+		if (entry->twiddle_count != twiddle_count
+			|| entry->perm_count != perm_count
+			|| entry->twiddle_offset % BINA_FFT_ALIGNMENT
+			|| entry->perm_offset % BINA_FFT_ALIGNMENT
+			|| entry->twiddle_offset < index_end
+			|| entry->perm_offset < index_end
+			|| twiddle_bytes > self->size
+			|| perm_bytes > self->size
+			|| entry->twiddle_offset > self->size - twiddle_bytes
+			|| entry->perm_offset > self->size - perm_bytes) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Looks up the tables of a problem.
+ *
+ * @self: The cache
+ * @fft_length: Length of the problem
+ * @flags: Plan flags
+ *
+ * @return The matching entry, or NULL.
+ */
+static const struct plan_cache_entry *find_entry(
+		const struct plan_cache *self, int fft_length, int flags)
+{
+	uint32_t layout = 0;
+
+	if (fft_length <= 0) {
+		return NULL;
+	}
+
+	layout = radix2_c2c_fft_table_layout(fft_length, flags, NULL, NULL);
+
+	for (uint32_t i = 0; i < self->header->num_entries; i++) {
+		const struct plan_cache_entry *entry = &self->entries[i];
+
+		if (entry->fft_length == (uint32_t) fft_length
+				&& entry->flags == layout) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,282 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* sdft.c - Sliding DFT. With x[0] the oldest of the last N samples and r
+* the damping,
+*
+*   X[k] = sum r^(N-1-n) x[n] exp(-2 pi i k n / N)
+*
+* and a new sample moves every bin along in O(1):
+*
+*   X[k] <- exp(2 pi i k / N) (r X[k] - r^N x[0] + x[N])
+*
+* The recursion accumulates rounding errors; with r < 1 they fade, and a
+* full (windowed) FFT of the history puts the bins back on track every so
+* often either way.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct sdft {
+	int fft_length;                 /* N, samples in the window */
+
+	int num_bins;                   /* K, tracked bins */
+
+	int *bins;                      /* Index of each tracked bin */
+
+	bina_complex *rotation;         /* exp(2 pi i k / N) of each bin */
+
+	bina_complex *spectrum;         /* K current bin values */
+
+	double damping;                 /* r */
+
+	double damping_n;               /* r^N */
+
+	double *window;                 /* r^(N-1-n), or NULL if r = 1 */
+
+	bina_complex *history;          /* Last N samples, stored twice so
+					 * that they are always contiguous at
+					 * history + position.
+					 */
+
+	int position;                   /* Oldest sample in `history' */
+
+	int resync_interval;            /* Samples between full transforms */
+
+	int since_resync;               /* Samples since the last one */
+
+	bina_transform fft;             /* N point transform */
+
+	bina_complex *scratch;          /* Full spectrum at resync */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void resync(struct sdft *self);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a sliding DFT, starting from a history of zeros.
+ *
+ * @fft_length: Samples in the window (MUST be power of two)
+ * @bins: Bins to track, in [0, fft_length), or NULL for all
+ * @num_bins: Number of bins in `bins'
+ * @damping: r in (0, 1], 1 for the plain DFT
+ * @resync_interval: Samples between full transforms, 0 for fft_length
+ * @flags: Transform flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @return A new sliding DFT, or NULL on failure.
+ */
+bina_sdft bina_sdft_create(int fft_length, const int *bins, int num_bins,
+		double damping, int resync_interval, int flags)
+{
+	struct sdft *self = NULL;
+	int n = fft_length;
+
+	if (!ispowtwo(n) || !(damping > 0.0 && damping <= 1.0)
+			|| resync_interval < 0
+			|| (bins != NULL && num_bins <= 0)) {
+		log_error("Bad sliding DFT length, bins or damping\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct sdft))) == NULL) {
+		log_error("Allocating sliding DFT instance\n");
+		return NULL;
+	}
+
+	self->fft_length = n;
+	self->num_bins = (bins != NULL) ? num_bins : n;
+	self->damping = damping;
+	self->damping_n = pow(damping, n);
+	self->resync_interval = resync_interval ? resync_interval : n;
+
+	self->bins = calloc(self->num_bins, sizeof(int));
+	self->rotation = aligned_malloc(BINA_FFT_ALIGNMENT, self->num_bins,
+			sizeof(bina_complex));
+	self->spectrum = aligned_calloc(BINA_FFT_ALIGNMENT, self->num_bins,
+			sizeof(bina_complex));
+	self->history = aligned_calloc(BINA_FFT_ALIGNMENT, 2 * n,
+			sizeof(bina_complex));
+	self->scratch = aligned_malloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(bina_complex));
+	self->fft = bina_transform_create_radix2_c2c_fft(NULL, NULL, n,
+			flags & BINA_FFT_COMPACT_TWIDDLE);
+
+	if (damping < 1.0) {
+		self->window = aligned_malloc(BINA_FFT_ALIGNMENT, n,
+				sizeof(double));
+	}
+
+	if (self->bins == NULL || self->rotation == NULL
+			|| self->spectrum == NULL || self->history == NULL
+			|| self->scratch == NULL || self->fft == NULL
+			|| (damping < 1.0 && self->window == NULL)) {
+		log_error("Allocating sliding DFT buffers\n");
+		bina_sdft_free(self);
+		return NULL;
+	}
+
+	for (int j = 0; j < self->num_bins; j++) {
+		int k = (bins != NULL) ? bins[j] : j;
+
+		if (k < 0 || k >= n) {
+			log_error("Bin %d out of range\n", k);
+			bina_sdft_free(self);
+			return NULL;
+		}
+
+		self->bins[j] = k;
+		self->rotation[j] = cos(2.0 * M_PI * k / n)
+			+ sin(2.0 * M_PI * k / n) * I;
+	}
+
+	for (int i = 0; self->window && i < n; i++) {
+		self->window[i] = pow(damping, n - 1 - i);
+	}
+
+	return self;
+}
+
+/* Replaces the history with a frame of samples and computes the bins from
+ * it with a full transform.
+ *
+ * @sdft: The sliding DFT
+ * @frame: fft_length samples, oldest first
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_sdft_seed(bina_sdft sdft, const bina_complex *frame)
+{
+	struct sdft *self = sdft;
+	int n = self->fft_length;
+
+	memcpy(self->history, frame, n * sizeof(bina_complex));
+	memcpy(self->history + n, frame, n * sizeof(bina_complex));
+	self->position = 0;
+	resync(self);
+
+	return 0;
+}
+
+/* Slides the window one sample at a time.
+ *
+ * @sdft: The sliding DFT
+ * @in: Input samples
+ * @length: Number of samples
+ * @out: Tracked bins after every sample, `length' x num_bins values, or
+ *       NULL
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_sdft_process(bina_sdft sdft, const bina_complex *in, int length,
+		bina_complex *out)
+{
+	struct sdft *self = sdft;
+	int n = self->fft_length;
+	int num_bins = self->num_bins;
+	const bina_complex *rotation = self->rotation;
+	bina_complex *spectrum = self->spectrum;
+	double r = self->damping;
+
+	if (length < 0) {
+		return -1;
+	}
+
+	for (int i = 0; i < length; i++) {
+		int pos = self->position;
+		bina_complex delta = in[i] - self->damping_n * self->history[pos];
+
+		self->history[pos] = in[i];
+		self->history[pos + n] = in[i];
+		self->position = (pos + 1) & (n - 1);
+
+		for (int j = 0; j < num_bins; j++) {
+			spectrum[j] = rotation[j] * (r * spectrum[j] + delta);
+		}
+
+		if (++self->since_resync >= self->resync_interval) {
+			resync(self);
+		}
+
+		if (out) {
+			memcpy(out + (size_t) i * num_bins, spectrum,
+					num_bins * sizeof(bina_complex));
+		}
+	}
+
+	return 0;
+}
+
+/* Frees a sliding DFT.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_sdft_free(bina_sdft sdft)
+{
+	struct sdft *self = sdft;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	free(self->bins);
+	aligned_free(self->rotation);
+	aligned_free(self->spectrum);
+	aligned_free(self->window);
+	aligned_free(self->history);
+	aligned_free(self->scratch);
+	free(self);
+
+	return 0;
+}
+
+/* Recomputes the tracked bins from the history with a full transform, the
+ * damping applied as a window in its first stage.
+ *
+ * @self: The sliding DFT
+ *
+ * @return None
+ */
+static void resync(struct sdft *self)
+{
+	radix2_c2c_fft_execute_fused(self->fft,
+			self->history + self->position, self->window,
+			self->scratch, NULL, RADIX2_C2C_FFT_SPECTRUM);
+
+	for (int j = 0; j < self->num_bins; j++) {
+		self->spectrum[j] = self->scratch[self->bins[j]];
+	}
+
+	self->since_resync = 0;
+}
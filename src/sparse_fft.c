@@ -0,0 +1,556 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* sparse_fft.c - Experimental sparse FFT, for spectra with a few significant
+* bins (on the bin grid) out of a large N. Each round permutes the spectrum
+* at random, x'[n] = x[s n mod N] moves bin g to s g, and hashes it into B
+* buckets by subsampling:
+*
+*   y[j] = x'[j N/B + t]  ->  Y[b] = B/N sum X'[f] exp(2 pi i f t / N)
+*
+* the sum running over f = b (mod B). A bucket holding a single bin gives
+* its location from the phase between t = 0 and t = 1, and a third random
+* offset tells single bins from collisions. Bins found in earlier rounds
+* are peeled off the buckets of later ones. A round costs three B point
+* transforms, with B a small multiple of the sparsity.
+*
+* Subsampling hashes by the low bits of the frequency, and no odd
+* multiplier changes the power of two dividing the distance of two bins,
+* so bins that are a multiple of B apart share a bucket in every round.
+* When a round finds nothing new but leaves energy in the buckets, the
+* next one uses twice as many buckets.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/* Buckets per expected bin */
+#ifndef BINA_SPARSE_FFT_LOAD
+#define BINA_SPARSE_FFT_LOAD (4)
+#endif
+
+/* Hashing rounds at most, and rounds in a row without news to stop */
+#ifndef BINA_SPARSE_FFT_ROUNDS
+#define BINA_SPARSE_FFT_ROUNDS (16)
+#endif
+
+#ifndef BINA_SPARSE_FFT_QUIET_ROUNDS
+#define BINA_SPARSE_FFT_QUIET_ROUNDS (2)
+#endif
+
+/* Doublings of the number of buckets at most */
+#ifndef BINA_SPARSE_FFT_LEVELS
+#define BINA_SPARSE_FFT_LEVELS (8)
+#endif
+
+/* Time samples checked against the recovered spectrum */
+#ifndef BINA_SPARSE_FFT_PROBES
+#define BINA_SPARSE_FFT_PROBES (64)
+#endif
+
+/* Relative mismatch at the third offset that marks a collision */
+#ifndef BINA_SPARSE_FFT_TOLERANCE
+#define BINA_SPARSE_FFT_TOLERANCE (1e-6)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct sparse_fft {
+	int fft_length;                 /* N */
+
+	int sparsity;                   /* k, bins wanted */
+
+	int buckets;                    /* B */
+
+	int levels;                     /* Numbers of buckets, B 2^level */
+
+	int capacity;                   /* Bins held while searching */
+
+	int flags;                      /* Flags of the transforms */
+
+	bina_transform *fft;            /* B 2^level point transforms, made
+					 * when first needed.
+					 */
+
+	int hash_length;                /* Buckets `hash' has room for */
+
+	bina_complex *hash[3];          /* Buckets at offsets 0, 1 and t */
+
+	int *found_bins;                /* Bins found so far */
+
+	bina_complex *found_values;
+
+	int found;
+
+	uint64_t random;                /* xorshift64 state */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static uint32_t next_random(struct sparse_fft *self);
+
+static int use_level(struct sparse_fft *self, int level);
+
+static double hash_round(struct sparse_fft *self, const bina_complex *in,
+		int level, uint32_t sigma, const uint32_t *offset,
+		double *residual);
+
+static int find_bins(struct sparse_fft *self, int level,
+		uint32_t sigma_inverse, uint32_t offset, double energy);
+
+static void keep_largest(struct sparse_fft *self);
+
+static double check_probes(struct sparse_fft *self, const bina_complex *in);
+
+static bina_complex unit(uint32_t f, uint32_t t, int fft_length);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a sparse FFT plan.
+ *
+ * @fft_length: N (MUST be power of two)
+ * @sparsity: k, the number of bins to recover
+ * @flags: Transform flags of the internal transforms
+ *
+ * @return A new plan, or NULL on failure.
+ */
+bina_sparse_fft bina_sparse_fft_create(int fft_length, int sparsity,
+		int flags)
+{
+	struct sparse_fft *self = NULL;
+	int n = fft_length;
+	int b = 1;
+
+	if (!ispowtwo(n) || sparsity <= 0 || sparsity > n) {
+		log_error("Bad length or sparsity\n");
+		return NULL;
+	}
+
+	while (b < BINA_SPARSE_FFT_LOAD * sparsity && b < n) {
+		b *= 2;
+	}
+
+	if ((self = calloc(1, sizeof(struct sparse_fft))) == NULL) {
+		log_error("Allocating sparse FFT instance\n");
+		return NULL;
+	}
+
+	self->fft_length = n;
+	self->sparsity = sparsity;
+	self->buckets = b;
+	self->levels = 1;
+	self->flags = flags & BINA_FFT_COMPACT_TWIDDLE;
+	/* Room for spurious bins, weeded out when the search ends */
+	self->capacity = 2 * sparsity + b;
+	self->random = 0x9e3779b97f4a7c15ULL;
+
+	while (self->levels <= BINA_SPARSE_FFT_LEVELS
+			&& (b << (self->levels - 1)) < n) {
+		self->levels++;
+	}
+
+	self->fft = calloc(self->levels, sizeof(bina_transform));
+	self->found_bins = calloc(self->capacity, sizeof(int));
+	self->found_values = aligned_malloc(BINA_FFT_ALIGNMENT,
+			self->capacity, sizeof(bina_complex));
+
+	if (self->fft == NULL || self->found_bins == NULL
+			|| self->found_values == NULL || use_level(self, 0) != 0) {
+		log_error("Allocating sparse FFT buffers\n");
+		bina_sparse_fft_free(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Recovers the (up to) k largest bins of the spectrum of a signal, reading
+ * O(k) samples per round.
+ *
+ * @sparse: The plan
+ * @in: N samples; only a few of them are read
+ * @bins: Destination of the bins, k entries
+ * @values: Destination of their values, k entries
+ * @confidence: Fraction of the energy of a few random samples that the
+ *              recovered bins explain, near 1 if the spectrum really is
+ *              that sparse; NULL if not wanted. Fall back to a dense
+ *              transform if it is low.
+ *
+ * @return Number of bins recovered, or -1 on failure.
+ */
+int bina_sparse_fft_execute(bina_sparse_fft sparse, const bina_complex *in,
+		int *bins, bina_complex *values, double *confidence)
+{
+	struct sparse_fft *self = sparse;
+	uint32_t mask = self->fft_length - 1;
+	double energy;
+	double residual;
+	int level = 0;
+	int quiet = 0;
+
+	self->found = 0;
+
+	for (int round = 0; round < BINA_SPARSE_FFT_ROUNDS
+			&& quiet < BINA_SPARSE_FFT_QUIET_ROUNDS; round++) {
+		uint32_t sigma = (next_random(self) | 1) & mask;
+		uint32_t sigma_inverse = sigma;
+		/* An odd third offset tells apart any two bins of a bucket */
+		uint32_t offset[3] = { 0, 1, (next_random(self) | 3) & mask };
+
+		/* Inverse modulo 2^32, hence modulo N, by Newton's method */
+		for (int i = 0; i < 5; i++) {
+			sigma_inverse *= 2 - sigma * sigma_inverse;
+		}
+
+		if (use_level(self, level) != 0) {
+			return -1;
+		}
+
+		energy = hash_round(self, in, level, sigma, offset, &residual);
+
+		if (find_bins(self, level, sigma_inverse & mask, offset[2],
+					energy)) {
+			quiet = 0;
+		} else if (residual > energy * 1e-12
+				&& level + 1 < self->levels) {
+			/* Bins left that collide at this number of buckets */
+			level++;
+			quiet = 0;
+		} else {
+			quiet++;
+		}
+	}
+
+	keep_largest(self);
+
+	memcpy(bins, self->found_bins, self->found * sizeof(int));
+	memcpy(values, self->found_values,
+			self->found * sizeof(bina_complex));
+
+	if (confidence) {
+		*confidence = check_probes(self, in);
+	}
+
+	return self->found;
+}
+
+/* Frees a sparse FFT plan.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_sparse_fft_free(bina_sparse_fft sparse)
+{
+	struct sparse_fft *self = sparse;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	for (int i = 0; self->fft && i < self->levels; i++) {
+		if (self->fft[i]) {
+			bina_transform_free(self->fft[i]);
+		}
+	}
+
+	free(self->fft);
+
+	for (int i = 0; i < 3; i++) {
+		aligned_free(self->hash[i]);
+	}
+
+	free(self->found_bins);
+	aligned_free(self->found_values);
+	free(self);
+
+	return 0;
+}
+
+/* xorshift64, good enough to pick permutations and probes */
+static uint32_t next_random(struct sparse_fft *self)
+{
+	self->random ^= self->random << 13;
+	self->random ^= self->random >> 7;
+	self->random ^= self->random << 17;
+
+	return (uint32_t) (self->random >> 32);
+}
+
+/* Makes the transform and the buckets of a level, if not made yet.
+ *
+ * @self: The plan
+ * @level: The level, B 2^level buckets
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int use_level(struct sparse_fft *self, int level)
+{
+	int b = self->buckets << level;
+
+	if (self->fft[level] == NULL) {
+		self->fft[level] = bina_transform_create_radix2_c2c_fft(NULL,
+				NULL, b, self->flags);
+
+		if (self->fft[level] == NULL) {
+			return -1;
+		}
+	}
+
+	for (int h = 0; b > self->hash_length && h < 3; h++) {
+		aligned_free(self->hash[h]);
+		self->hash[h] = aligned_malloc(BINA_FFT_ALIGNMENT, b,
+				sizeof(bina_complex));
+
+		if (self->hash[h] == NULL) {
+			log_error("Allocating sparse FFT buckets\n");
+			self->hash_length = 0;
+			return -1;
+		}
+	}
+
+	if (b > self->hash_length) {
+		self->hash_length = b;
+	}
+
+	return 0;
+}
+
+/* Hashes the permuted spectrum into the buckets at the three offsets, and
+ * peels the bins found so far off them.
+ *
+ * @self: The plan
+ * @in: N samples
+ * @level: The level, B 2^level buckets
+ * @sigma: Odd multiplier of the permutation
+ * @offset: The three time offsets
+ * @residual: Energy of the buckets at offset 0 after peeling
+ *
+ * @return Energy of the buckets at offset 0 before peeling.
+ */
+static double hash_round(struct sparse_fft *self, const bina_complex *in,
+		int level, uint32_t sigma, const uint32_t *offset,
+		double *residual)
+{
+	int n = self->fft_length;
+	int b = self->buckets << level;
+	uint32_t mask = n - 1;
+	uint32_t stride = n / b;
+	double scale = (double) b / n;
+	double energy = 0.0;
+
+	*residual = 0.0;
+
+	for (int h = 0; h < 3; h++) {
+		bina_complex *y = self->hash[h];
+
+		for (int j = 0; j < b; j++) {
+			y[j] = in[(sigma * (j * stride + offset[h])) & mask];
+		}
+
+		radix2_c2c_fft_execute_on(self->fft[level], y, y);
+
+		for (int j = 0; h == 0 && j < b; j++) {
+			energy += creal(y[j] * conj(y[j]));
+		}
+
+		for (int i = 0; i < self->found; i++) {
+			uint32_t f = (sigma * self->found_bins[i]) & mask;
+
+			y[f & (b - 1)] -= scale * self->found_values[i]
+				* unit(f, offset[h], n);
+		}
+
+		for (int j = 0; h == 0 && j < b; j++) {
+			*residual += creal(y[j] * conj(y[j]));
+		}
+	}
+
+	return energy;
+}
+
+/* Looks for buckets that hold a single bin, and adds those bins (or their
+ * corrections) to the ones found so far. Buckets hold permuted bins sigma k,
+ * which are mapped back to k before they are stored.
+ *
+ * @self: The plan
+ * @level: The level, B 2^level buckets
+ * @sigma_inverse: Inverse modulo N of the odd multiplier of the permutation
+ * @offset: Third time offset
+ * @energy: Energy of the buckets before peeling
+ *
+ * @return Number of bins found or corrected.
+ */
+static int find_bins(struct sparse_fft *self, int level,
+		uint32_t sigma_inverse, uint32_t offset, double energy)
+{
+	int n = self->fft_length;
+	int b = self->buckets << level;
+	uint32_t mask = n - 1;
+	const bina_complex *y0 = self->hash[0];
+	const bina_complex *y1 = self->hash[1];
+	const bina_complex *y2 = self->hash[2];
+	/* Buckets well below the average are rounding noise */
+	double floor_energy = energy / b * 1e-20;
+	int news = 0;
+
+	for (int j = 0; j < b; j++) {
+		double p = creal(y0[j] * conj(y0[j]));
+		double phase;
+		uint32_t f;
+		uint32_t g;
+		int i;
+
+		if (p <= floor_energy || p == 0.0) {
+			continue;
+		}
+
+		/* Y1 / Y0 = exp(2 pi i f / N) for a single bin */
+		phase = carg(y1[j] * conj(y0[j]));
+		f = (uint32_t) lround(phase / (2.0 * M_PI) * n) & mask;
+
+		if ((int) (f & (b - 1)) != j || cabs(y2[j] - y0[j]
+				* unit(f, offset, n)) > BINA_SPARSE_FFT_TOLERANCE
+				* cabs(y0[j])) {
+			continue;
+		}
+
+		/* Undo the permutation */
+		g = (sigma_inverse * f) & mask;
+
+		for (i = 0; i < self->found; i++) {
+			if (self->found_bins[i] == (int) g) {
+				break;
+			}
+		}
+
+		if (i == self->found) {
+			if (self->found == self->capacity) {
+				continue;
+			}
+
+			self->found_bins[i] = g;
+			self->found_values[i] = 0.0;
+			self->found++;
+		}
+
+		self->found_values[i] += (double) n / b * y0[j];
+		news++;
+	}
+
+	return news;
+}
+
+/* Keeps the k largest of the bins found, sorted by bin.
+ *
+ * @self: The plan
+ *
+ * @return None
+ */
+static void keep_largest(struct sparse_fft *self)
+{
+	int *bins = self->found_bins;
+	bina_complex *values = self->found_values;
+
+	/* Selection by magnitude; k and the number found are small */
+	for (int i = 0; i < self->found && i < self->sparsity; i++) {
+		int best = i;
+		int tb;
+		bina_complex tv;
+
+		for (int j = i + 1; j < self->found; j++) {
+			if (cabs(values[j]) > cabs(values[best])) {
+				best = j;
+			}
+		}
+
+		tb = bins[i];
+		tv = values[i];
+		bins[i] = bins[best];
+		values[i] = values[best];
+		bins[best] = tb;
+		values[best] = tv;
+	}
+
+	if (self->found > self->sparsity) {
+		self->found = self->sparsity;
+	}
+
+	for (int i = 1; i < self->found; i++) {
+		for (int j = i; j > 0 && bins[j - 1] > bins[j]; j--) {
+			int tb = bins[j];
+			bina_complex tv = values[j];
+
+			bins[j] = bins[j - 1];
+			values[j] = values[j - 1];
+			bins[j - 1] = tb;
+			values[j - 1] = tv;
+		}
+	}
+}
+
+/* Compares random samples of the signal with the inverse transform of the
+ * recovered bins at the same times.
+ *
+ * @self: The plan
+ * @in: N samples
+ *
+ * @return 1 - residual energy / signal energy of the samples, in [0, 1].
+ */
+static double check_probes(struct sparse_fft *self, const bina_complex *in)
+{
+	int n = self->fft_length;
+	double signal = 0.0;
+	double residual = 0.0;
+
+	for (int p = 0; p < BINA_SPARSE_FFT_PROBES; p++) {
+		uint32_t t = next_random(self) & (n - 1);
+		bina_complex x = 0.0;
+
+		for (int i = 0; i < self->found; i++) {
+			x += self->found_values[i]
+				* unit(self->found_bins[i], t, n);
+		}
+
+		x = in[t] - x / n;
+		signal += creal(in[t] * conj(in[t]));
+		residual += creal(x * conj(x));
+	}
+
+	if (signal == 0.0) {
+		return (residual == 0.0) ? 1.0 : 0.0;
+	}
+
+	return fmax(0.0, 1.0 - residual / signal);
+}
+
+/* exp(2 pi i f t / N), with f t reduced modulo N first */
+static bina_complex unit(uint32_t f, uint32_t t, int fft_length)
+{
+	uint32_t ft = (uint32_t) (((uint64_t) f * t) & (fft_length - 1));
+	double a = 2.0 * M_PI * ft / fft_length;
+
+	return cos(a) + sin(a) * I;
+}
@@ -0,0 +1,327 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* stft.c - Short time Fourier transform (spectrogram) of a sample stream.
+* The window is applied by the first stage of the transform and the power
+* by its permutation, so a frame is never copied or rescanned.
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/window.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+struct stft {
+	int fft_length;                 /* N, samples per frame */
+
+	int hop;                        /* Samples between frame starts */
+
+	int flags;                      /* Transform flags */
+
+	int output;                     /* RADIX2_C2C_FFT_* */
+
+	size_t frame_size;              /* Bytes per output frame */
+
+	double *window;                 /* N window values */
+
+	bina_complex *twiddle;          /* Tables shared by all the plans */
+
+	unsigned int *permutation;
+
+	bina_transform fft;             /* Plan of the stream */
+
+	bina_complex *history;          /* Samples of the next frame */
+
+	bina_complex *scratch;          /* Spectrum, for the power outputs */
+
+	int fill;                       /* Samples in `history' */
+
+	int skip;                       /* Samples to drop before the next
+					 * frame starts, when hop > N.
+					 */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void emit_frame(struct stft *self, bina_transform fft,
+		const bina_complex *frame, bina_complex *scratch, void *dst);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a short time Fourier transform.
+ *
+ * @fft_length: Samples per frame (MUST be power of two)
+ * @hop: Samples between the starts of frames, may exceed `fft_length'
+ * @window: One of BINA_WINDOW_*
+ * @flags: Transform flags, and BINA_STFT_POWER or BINA_STFT_LOG_POWER for
+ *         power frames instead of spectra. Of the transform flags, only
+ *         BINA_FFT_COMPACT_TWIDDLE and BINA_FFT_INVERSE are used.
+ *
+ * @return A new STFT, or NULL on failure.
+ */
+bina_stft bina_stft_create(int fft_length, int hop, int window, int flags)
+{
+	struct stft *self = NULL;
+
+	if (!ispowtwo(fft_length) || hop <= 0) {
+		log_error("Length is not power of two, or no hop\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct stft))) == NULL) {
+		log_error("Allocating STFT instance\n");
+		return NULL;
+	}
+
+	self->fft_length = fft_length;
+	self->hop = hop;
+	self->flags = flags & (BINA_FFT_COMPACT_TWIDDLE | BINA_FFT_INVERSE);
+	self->output = RADIX2_C2C_FFT_SPECTRUM;
+	self->frame_size = fft_length * sizeof(bina_complex);
+
+	if (flags & (BINA_STFT_POWER | BINA_STFT_LOG_POWER)) {
+		self->output = (flags & BINA_STFT_LOG_POWER) ?
+			RADIX2_C2C_FFT_LOG_POWER : RADIX2_C2C_FFT_POWER;
+		self->frame_size = fft_length * sizeof(double);
+	}
+
+	self->window = aligned_malloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(double));
+	self->history = aligned_calloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+	self->scratch = aligned_malloc(BINA_FFT_ALIGNMENT, fft_length,
+			sizeof(bina_complex));
+
+	if (self->window == NULL || self->history == NULL
+			|| self->scratch == NULL
+			|| window_fill(self->window, fft_length, window) != 0
+			|| radix2_c2c_fft_tables(fft_length, self->flags,
+				&self->twiddle, NULL, &self->permutation,
+				NULL) != 0) {
+		log_error("Allocating STFT buffers\n");
+		bina_stft_free(self);
+		return NULL;
+	}
+
+	self->fft = radix2_c2c_fft_create_with_tables(NULL, NULL, fft_length,
+			self->flags, self->twiddle, self->permutation);
+
+	if (self->fft == NULL) {
+		bina_stft_free(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Returns the number of frames bina_stft_process() writes for the next
+ * `length' samples.
+ *
+ * @stft: The STFT
+ * @length: Number of samples
+ *
+ * @return Number of frames
+ */
+int bina_stft_frame_count(bina_stft stft, int length)
+{
+	struct stft *self = stft;
+	int need = self->skip + self->fft_length - self->fill;
+
+	if (length < need) {
+		return 0;
+	}
+
+	return 1 + (length - need) / self->hop;
+}
+
+/* Feeds samples to the STFT, and writes the frames they complete. Frames
+ * are fft_length complex values (or doubles, for the power outputs).
+ *
+ * @stft: The STFT
+ * @in: Input samples
+ * @length: Number of samples
+ * @frames: Room for bina_stft_frame_count() frames
+ *
+ * @return Number of frames written, or -1 on failure.
+ */
+int bina_stft_process(bina_stft stft, const bina_complex *in, int length,
+		void *frames)
+{
+	struct stft *self = stft;
+	int fft_length = self->fft_length;
+	int hop = self->hop;
+	int count = 0;
+
+	if (length < 0) {
+		return -1;
+	}
+
+	while (length > 0) {
+		int n;
+
+		if (self->skip) {
+			n = (self->skip < length) ? self->skip : length;
+			self->skip -= n;
+			in += n;
+			length -= n;
+			continue;
+		}
+
+		n = fft_length - self->fill;
+		n = (n < length) ? n : length;
+		memcpy(self->history + self->fill, in, n * sizeof(bina_complex));
+		self->fill += n;
+		in += n;
+		length -= n;
+
+		if (self->fill < fft_length) {
+			break;
+		}
+
+		emit_frame(self, self->fft, self->history, self->scratch,
+				(unsigned char *) frames
+				+ count * self->frame_size);
+		count++;
+
+		/* Keep the overlap with the next frame */
+		if (hop < fft_length) {
+			memmove(self->history, self->history + hop,
+					(fft_length - hop)
+					* sizeof(bina_complex));
+			self->fill = fft_length - hop;
+		} else {
+			self->fill = 0;
+			self->skip = hop - fft_length;
+		}
+	}
+
+	return count;
+}
+
+/* Computes all frames of a whole signal at once, spread over threads when
+ * built with OpenMP. Frames are read straight from `signal'. The stream
+ * state of bina_stft_process() is not used or changed.
+ *
+ * @stft: The STFT
+ * @signal: Input samples
+ * @length: Number of samples
+ * @frames: Room for (length - fft_length) / hop + 1 frames
+ *
+ * @return Number of frames written, or -1 on failure.
+ */
+int bina_stft_spectrogram(bina_stft stft, const bina_complex *signal,
+		int length, void *frames)
+{
+	struct stft *self = stft;
+	int fft_length = self->fft_length;
+	int count = (length >= fft_length) ?
+		(length - fft_length) / self->hop + 1 : 0;
+	int failed = 0;
+
+#	ifdef _OPENMP
+#	pragma omp parallel if (count > 1) reduction(|:failed)
+#	endif
+	{
+		/* The plans only share the read-only tables */
+		bina_transform fft = radix2_c2c_fft_create_with_tables(NULL,
+				NULL, fft_length, self->flags, self->twiddle,
+				self->permutation);
+		bina_complex *scratch = aligned_malloc(BINA_FFT_ALIGNMENT,
+				fft_length, sizeof(bina_complex));
+
+		failed = (fft == NULL || scratch == NULL);
+
+#		ifdef _OPENMP
+#		pragma omp for schedule(static)
+#		endif
+		for (int f = 0; f < count; f++) {
+			if (!failed) {
+				emit_frame(self, fft,
+						signal + (size_t) f * self->hop,
+						scratch,
+						(unsigned char *) frames
+						+ f * self->frame_size);
+			}
+		}
+
+		if (fft) {
+			bina_transform_free(fft);
+		}
+
+		aligned_free(scratch);
+	}
+
+	if (failed) {
+		log_error("Allocating spectrogram buffers\n");
+		return -1;
+	}
+
+	return count;
+}
+
+/* Frees an STFT.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_stft_free(bina_stft stft)
+{
+	struct stft *self = stft;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	if (self->fft) {
+		bina_transform_free(self->fft);
+	}
+
+	aligned_free(self->window);
+	aligned_free(self->history);
+	aligned_free(self->scratch);
+	aligned_free(self->twiddle);
+	aligned_free(self->permutation);
+	free(self);
+
+	return 0;
+}
+
+/* Windows, transforms and stores one frame.
+ *
+ * @self: The STFT
+ * @fft: Plan to use
+ * @frame: fft_length input samples
+ * @scratch: fft_length complex values of scratch
+ * @dst: Output frame
+ *
+ * @return None
+ */
+static void emit_frame(struct stft *self, bina_transform fft,
+		const bina_complex *frame, bina_complex *scratch, void *dst)
+{
+	if (self->output == RADIX2_C2C_FFT_SPECTRUM) {
+		radix2_c2c_fft_execute_fused(fft, frame, self->window, dst,
+				NULL, self->output);
+	} else {
+		radix2_c2c_fft_execute_fused(fft, frame, self->window,
+				scratch, dst, self->output);
+	}
+}
@@ -0,0 +1,421 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* welch.c - Welch power spectral density estimate of a real sample stream.
+* Segments are transformed with the real FFT, and the pass that splits the
+* half length transform adds the power straight into the average.
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/bitmagic.h"
+#include "internal/log.h"
+#include "internal/radix2_c2c_fft.h"
+#include "internal/radix2_r2c_fft.h"
+#include "internal/window.h"
+
+#ifndef BINA_FFT_ALIGNMENT
+#define BINA_FFT_ALIGNMENT (16U)
+#endif
+
+/*******************************************************************************
+* Data structure
+*******************************************************************************/
+
+/* Everything one thread needs to add segments to its own accumulator */
+struct welch_worker {
+	bina_transform fft;             /* n/2 point complex transform */
+
+	bina_complex *segment;          /* Windowed segment, as n/2 pairs */
+
+	double *power;                  /* n/2 + 1 accumulators */
+};
+
+struct welch {
+	int segment_length;             /* n, samples per segment */
+
+	int hop;                        /* Samples between segment starts */
+
+	double alpha;                   /* Exponential weight, 0 for linear */
+
+	double *window;                 /* n window values */
+
+	double window_power;            /* sum of w[i]^2 */
+
+	bina_complex *twiddle;          /* Tables shared by all workers */
+
+	unsigned int *permutation;
+
+	bina_complex *split_twiddle;
+
+	int num_workers;
+
+	struct welch_worker *workers;
+
+	double *average;                /* n/2 + 1, sum or average of power */
+
+	long segments;                  /* Segments averaged */
+
+	bina_real *history;             /* Start of the next segment */
+
+	int fill;                       /* Samples in `history' */
+
+	int skip;                       /* Samples to drop before the next
+					 * segment starts, when hop > n.
+					 */
+};
+
+/*******************************************************************************
+* Functions
+*******************************************************************************/
+
+static void add_segment(const struct welch *self, struct welch_worker *worker,
+		const bina_real *head, int head_length, const bina_real *tail,
+		double weight);
+
+static double segment_weight(const struct welch *self, int index, int count);
+
+/*******************************************************************************
+* Implementations
+*******************************************************************************/
+
+/* Creates a Welch PSD estimator.
+ *
+ * @segment_length: Samples per segment (MUST be power of two, at least 2)
+ * @hop: Samples between the starts of segments, segment_length / 2 is the
+ *       usual 50% overlap
+ * @window: One of BINA_WINDOW_*
+ * @alpha: 0 for the plain average, (0, 1] for an exponential average
+ * @flags: Transform flags, BINA_FFT_COMPACT_TWIDDLE
+ *
+ * @return A new estimator, or NULL on failure.
+ */
+bina_welch bina_welch_create(int segment_length, int hop, int window,
+		double alpha, int flags)
+{
+	struct welch *self = NULL;
+	int n = segment_length;
+	int failed = 0;
+
+	if (!ispowtwo(n) || n < 2 || hop <= 0 || alpha < 0.0 || alpha > 1.0) {
+		log_error("Bad segment length, hop or weight\n");
+		return NULL;
+	}
+
+	if ((self = calloc(1, sizeof(struct welch))) == NULL) {
+		log_error("Allocating Welch instance\n");
+		return NULL;
+	}
+
+	self->segment_length = n;
+	self->hop = hop;
+	self->alpha = alpha;
+	self->num_workers = 1;
+	flags &= BINA_FFT_COMPACT_TWIDDLE;
+
+#	ifdef _OPENMP
+	self->num_workers = omp_get_max_threads();
+#	endif
+
+	self->window = aligned_malloc(BINA_FFT_ALIGNMENT, n, sizeof(double));
+	self->split_twiddle = aligned_malloc(BINA_FFT_ALIGNMENT,
+			RADIX2_R2C_FFT_PAIRS(n), sizeof(bina_complex));
+	self->average = aligned_calloc(BINA_FFT_ALIGNMENT, n / 2 + 1,
+			sizeof(double));
+	self->history = aligned_calloc(BINA_FFT_ALIGNMENT, n,
+			sizeof(bina_real));
+	self->workers = calloc(self->num_workers,
+			sizeof(struct welch_worker));
+
+	failed = (self->window == NULL || self->split_twiddle == NULL
+			|| self->average == NULL || self->history == NULL
+			|| self->workers == NULL
+			|| window_fill(self->window, n, window) != 0
+			|| radix2_c2c_fft_tables(n / 2, flags, &self->twiddle,
+				NULL, &self->permutation, NULL) != 0);
+
+	for (int t = 0; !failed && t < self->num_workers; t++) {
+		struct welch_worker *worker = &self->workers[t];
+
+		worker->fft = radix2_c2c_fft_create_with_tables(NULL, NULL,
+				n / 2, flags, self->twiddle, self->permutation);
+		worker->segment = aligned_malloc(BINA_FFT_ALIGNMENT, n / 2,
+				sizeof(bina_complex));
+		worker->power = aligned_calloc(BINA_FFT_ALIGNMENT, n / 2 + 1,
+				sizeof(double));
+
+		failed = (worker->fft == NULL || worker->segment == NULL
+				|| worker->power == NULL);
+	}
+
+	if (failed) {
+		log_error("Allocating Welch buffers\n");
+		bina_welch_free(self);
+		return NULL;
+	}
+
+	radix2_r2c_fft_fill_twiddle(self->split_twiddle, n);
+
+	for (int i = 0; i < n; i++) {
+		self->window_power += self->window[i] * self->window[i];
+	}
+
+	return self;
+}
+
+/* Feeds samples to the estimator. The segments they complete are added to
+ * the average, spread over threads when built with OpenMP.
+ *
+ * @welch: The estimator
+ * @in: Input samples
+ * @length: Number of samples
+ *
+ * @return Number of segments added, or -1 on failure.
+ */
+int bina_welch_process(bina_welch welch, const bina_real *in, int length)
+{
+	struct welch *self = welch;
+	int n = self->segment_length;
+	int hop = self->hop;
+	int fill = self->fill;
+	int count = 0;
+	long total;
+	long next;
+
+	if (length < 0) {
+		return -1;
+	}
+
+	if (self->skip) {
+		int drop = (self->skip < length) ? self->skip : length;
+
+		self->skip -= drop;
+		in += drop;
+		length -= drop;
+	}
+
+	/* Segments start every hop samples into [history | in] */
+	total = (long) fill + length;
+
+	if (total >= n) {
+		count = (total - n) / hop + 1;
+	}
+
+	if (count > 0) {
+		double decay = pow(1.0 - self->alpha, count);
+
+		for (int t = 0; t < self->num_workers; t++) {
+			memset(self->workers[t].power, 0,
+					(n / 2 + 1) * sizeof(double));
+		}
+
+#		ifdef _OPENMP
+#		pragma omp parallel num_threads(self->num_workers) \
+			if (count > 1)
+#		endif
+		{
+			int t = 0;
+
+#			ifdef _OPENMP
+			t = omp_get_thread_num();
+#			endif
+
+			struct welch_worker *worker = &self->workers[t];
+
+#			ifdef _OPENMP
+#			pragma omp for schedule(static)
+#			endif
+			for (int j = 0; j < count; j++) {
+				long start = (long) j * hop;
+				const bina_real *head = NULL;
+				int head_length = 0;
+				const bina_real *tail = in;
+
+				if (start < fill) {
+					head = self->history + start;
+					head_length = fill - start;
+				} else {
+					tail = in + (start - fill);
+				}
+
+				add_segment(self, worker, head, head_length,
+						tail,
+						segment_weight(self, j, count));
+			}
+		}
+
+		/* Older segments fade by (1 - alpha) per new segment */
+		if (self->alpha > 0.0) {
+			for (int k = 0; k <= n / 2; k++) {
+				self->average[k] *= decay;
+			}
+		}
+
+		for (int t = 0; t < self->num_workers; t++) {
+			for (int k = 0; k <= n / 2; k++) {
+				self->average[k] += self->workers[t].power[k];
+			}
+		}
+
+		self->segments += count;
+	}
+
+	/* Keep what the next segment needs */
+	next = (long) count * hop;
+
+	if (next <= total) {
+		long keep = total - next;
+
+		if (next < fill) {
+			memmove(self->history, self->history + next,
+					(fill - next) * sizeof(bina_real));
+			memcpy(self->history + (fill - next), in,
+					length * sizeof(bina_real));
+		} else {
+			memcpy(self->history, in + (next - fill),
+					keep * sizeof(bina_real));
+		}
+
+		self->fill = keep;
+	} else {
+		self->fill = 0;
+		self->skip = next - total;
+	}
+
+	return count;
+}
+
+/* Writes the one-sided power spectral density, n/2 + 1 bins, per unit of
+ * sample rate (divide by the sample rate for physical units). Bins other
+ * than DC and Nyquist hold the power of their negative frequency too.
+ *
+ * @welch: The estimator
+ * @psd: Destination, n/2 + 1 values
+ *
+ * @return Number of segments in the estimate.
+ */
+int bina_welch_psd(bina_welch welch, bina_real *psd)
+{
+	struct welch *self = welch;
+	int half = self->segment_length / 2;
+	double scale = 1.0 / self->window_power;
+
+	if (self->alpha == 0.0 && self->segments > 0) {
+		scale /= self->segments;
+	}
+
+	for (int k = 0; k <= half; k++) {
+		double twice = (k == 0 || k == half) ? 1.0 : 2.0;
+
+		psd[k] = self->average[k] * scale * twice;
+	}
+
+	return self->segments;
+}
+
+/* Frees a Welch PSD estimator.
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int bina_welch_free(bina_welch welch)
+{
+	struct welch *self = welch;
+
+	if (self == NULL) {
+		return -1;
+	}
+
+	for (int t = 0; self->workers && t < self->num_workers; t++) {
+		if (self->workers[t].fft) {
+			bina_transform_free(self->workers[t].fft);
+		}
+
+		aligned_free(self->workers[t].segment);
+		aligned_free(self->workers[t].power);
+	}
+
+	free(self->workers);
+	aligned_free(self->window);
+	aligned_free(self->split_twiddle);
+	aligned_free(self->average);
+	aligned_free(self->history);
+	aligned_free(self->twiddle);
+	aligned_free(self->permutation);
+	free(self);
+
+	return 0;
+}
+
+/* Windows one segment, which may start in the history and end in the new
+ * input, transforms it, and adds its power to the accumulator of a worker.
+ *
+ * @self: The estimator
+ * @worker: The worker
+ * @head: First part of the segment
+ * @head_length: Samples in the first part
+ * @tail: Rest of the segment
+ * @weight: Weight of the segment
+ *
+ * @return None
+ */
+static void add_segment(const struct welch *self, struct welch_worker *worker,
+		const bina_real *head, int head_length, const bina_real *tail,
+		double weight)
+{
+	int n = self->segment_length;
+	const double *w = self->window;
+	/* Adjacent real samples are the (re, im) of a complex one */
+	double *x = (double *) worker->segment;
+
+	for (int i = 0; i < head_length; i++) {
+		x[i] = head[i] * w[i];
+	}
+
+	for (int i = head_length; i < n; i++) {
+		x[i] = tail[i - head_length] * w[i];
+	}
+
+	radix2_c2c_fft_execute_on(worker->fft, worker->segment,
+			worker->segment);
+	radix2_r2c_fft_split_power(worker->segment, self->split_twiddle, n,
+			weight, worker->power);
+}
+
+/* Weight of segment `index' of a batch of `count'. The plain average adds
+ * all segments up; the exponential one weights the newest by alpha and
+ * each older one by another factor of (1 - alpha). The very first segment
+ * starts the average at full weight.
+ *
+ * @self: The estimator
+ * @index: Segment in the batch
+ * @count: Segments in the batch
+ *
+ * @return Weight
+ */
+static double segment_weight(const struct welch *self, int index, int count)
+{
+	double age;
+
+	if (self->alpha == 0.0) {
+		return 1.0;
+	}
+
+	age = pow(1.0 - self->alpha, count - 1 - index);
+
+	if (index == 0 && self->segments == 0) {
+		return age;
+	}
+
+	return self->alpha * age;
+}
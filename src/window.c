@@ -0,0 +1,128 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* window.c - Analysis windows for the spectral estimators.
+*******************************************************************************/
+
+#include <math.h>
+
+#include "binafft.h"
+#include "internal/log.h"
+#include "internal/window.h"
+
+#ifndef M_PI
+#define M_PI   (3.14159265358979323846264338327950288)
+#endif
+
+/* Kaiser-Bessel-derived window shape, as in AAC */
+#define KBD_ALPHA (4.0)
+
+static int kbd_fill(double *window, int length);
+
+/* Fills a window of the given type. Windows are periodic (the sample that
+ * would close the period is left out), which is what frames that overlap
+ * and get transformed want. The sine and Kaiser-Bessel-derived windows are
+ * instead symmetric about the middle of the frame, with w[n]^2 +
+ * w[n + length/2]^2 = 1, as the MDCT needs; their length must be even.
+ *
+ * @window: Destination, `length' values
+ * @length: Number of values
+ * @type: One of BINA_WINDOW_*
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+int window_fill(double *window, int length, int type)
+{
+	const double step = 2.0 * M_PI / length;
+
+	if (type == BINA_WINDOW_KBD) {
+		return kbd_fill(window, length);
+	}
+
+	for (int n = 0; n < length; n++) {
+		switch (type) {
+		case BINA_WINDOW_RECTANGULAR:
+			window[n] = 1.0;
+			break;
+		case BINA_WINDOW_HANN:
+			window[n] = 0.5 - 0.5 * cos(step * n);
+			break;
+		case BINA_WINDOW_HAMMING:
+			window[n] = 0.54 - 0.46 * cos(step * n);
+			break;
+		case BINA_WINDOW_BLACKMAN:
+			window[n] = 0.42 - 0.5 * cos(step * n)
+				+ 0.08 * cos(2.0 * step * n);
+			break;
+		case BINA_WINDOW_SINE:
+			window[n] = sin(0.5 * step * (n + 0.5));
+			break;
+		default:
+			log_error("Unknown window type %d\n", type);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Fills a Kaiser-Bessel-derived window: the running sums of a Kaiser
+ * window of length/2 + 1 points, square rooted, and mirrored.
+ *
+ * @window: Destination, `length' values
+ * @length: Number of values (MUST be even)
+ *
+ * @return Nonzero value is returned upon failure, and zero upon success.
+ */
+static int kbd_fill(double *window, int length)
+{
+	int half = length / 2;
+	double beta = M_PI * KBD_ALPHA;
+	double total = 0.0;
+	double sum = 0.0;
+
+	if (length <= 0 || length % 2) {
+		log_error("Kaiser-Bessel-derived window of odd length\n");
+		return -1;
+	}
+
+	for (int k = 0; k <= half; k++) {
+		double r = 2.0 * k / half - 1.0;
+
+		total += window_bessel_i0(beta * sqrt(1.0 - r * r));
+	}
+
+	for (int n = 0; n < half; n++) {
+		double r = 2.0 * n / half - 1.0;
+
+		sum += window_bessel_i0(beta * sqrt(1.0 - r * r));
+		window[n] = sqrt(sum / total);
+		window[length - 1 - n] = window[n];
+	}
+
+	return 0;
+}
+
+/* Modified Bessel function of the first kind of order zero, by its power
+ * series. It converges quickly for the arguments of the Kaiser-Bessel
+ * shapes, here and in the NUFFT kernel.
+ *
+ * @x: Argument
+ *
+ * @return I0(x)
+ */
+double window_bessel_i0(double x)
+{
+	double term = 1.0;
+	double sum = 1.0;
+	double q = 0.25 * x * x;
+
+	for (int k = 1; term > sum * 1e-17; k++) {
+		term *= q / ((double) k * k);
+		sum += term;
+	}
+
+	return sum;
+}
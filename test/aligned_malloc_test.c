@@ -8,6 +8,7 @@
 #include "internal/aligned_malloc.h"
 
 static int is_aligned(void *ptr, size_t alignment);
+static void pitched_test(void);
 #define ALIGNMENT (16)
 
 int main()
@@ -27,15 +28,52 @@ int main()
 	/* Testing `b' */
 	assert(b != NULL);
 	for (k = 0; k < colums; k++) {
-		memset(b[k], 0xffu, size * sizeof(float));
+		memset(b[k], 0xffu, rows * sizeof(float));
 		CHECK(is_aligned(b[k], ALIGNMENT));
 	}
 
 	aligned_free(a);
 	aligned_free(b);
+
+	pitched_test();
 	return 0;
 }
 
+/* Testing aligned_pitched_calloc() */
+static void pitched_test(void)
+{
+	size_t pitch = 0;
+	size_t r = 0;
+	unsigned char *c = NULL;
+
+	puts("pitched_test");
+
+	/* No more padding than the alignment needs */
+	CHECK(aligned_pitch(ALIGNMENT, 3, sizeof(float), 0) == 16);
+	CHECK(aligned_pitch(ALIGNMENT, 256, 16, 0) == 4096);
+
+	/* Power of two pitches get one extra cache line */
+	CHECK(aligned_pitch(ALIGNMENT, 256, 16, ALIGNED_PITCH_AVOID_ALIASING)
+	      == 4096 + ALIGNED_CACHE_LINE);
+	CHECK(aligned_pitch(ALIGNMENT, 3, sizeof(float),
+			    ALIGNED_PITCH_AVOID_ALIASING) == 16);
+
+	c = aligned_pitched_calloc(ALIGNMENT, 100, 256, 16,
+				   ALIGNED_PITCH_AVOID_ALIASING, &pitch);
+	assert(c != NULL);
+	CHECK(pitch == 4096 + ALIGNED_CACHE_LINE);
+
+	for (r = 0; r < 100; r++) {
+		memset(c + r * pitch, 0xffu, 256 * 16);
+		CHECK(is_aligned(c + r * pitch, ALIGNMENT));
+	}
+
+	aligned_free(c);
+
+	CHECK(aligned_pitched_calloc(3, 1, 1, 1, 0, &pitch) == NULL);
+	CHECK(aligned_pitched_calloc(ALIGNMENT, 0, 1, 1, 0, &pitch) == NULL);
+}
+
 static int is_aligned(void *ptr, size_t alignment)
 {
 	uintptr_t address = (uintptr_t) ptr;
@@ -1,14 +1,28 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <complex.h>
+#include <math.h>
 
 #include "binafft.h"
 #include "internal/aligned_malloc.h"
+#include "internal/check.h"
+#include "internal/radix2_c2c_fft.h"
 
 #define bina_complex_alloc(n) aligned_calloc(16, n, sizeof(bina_complex))
 #define bina_complex_free(ptr) aligned_free(ptr)
 
 static void printc(bina_complex *arr, size_t len);
+static double max_error_vs_dft(int fft_len, int flags);
+static double max_error_vs_dft_2d(int rows, int columns, int flags);
+static double max_error_r2c_vs_dft(int fft_len, int flags);
+static int segments_match_contiguous(int fft_len, int head_length,
+		int flags, int cache_length);
+static double max_error_scrambled(int fft_len, int flags, int cache_length);
+static double max_error_tone(int fft_len, int bin, int flags,
+		int cache_length);
+static double max_error_compact_vs_full(int fft_len, int flags);
+static int fused_rejects_scrambled_inverse(int fft_len);
+static int segments_into_ring(int fft_len, int head_length, int flags);
 
 int main()
 {
@@ -17,7 +31,7 @@ int main()
 
 	bina_complex *in = bina_complex_alloc(fft_len);
 	bina_complex *out = bina_complex_alloc(fft_len);
-	bina_transform transform = bina_transform_create_radix2_c2c_fft(in, out, fft_len, 0);
+	bina_transform transform = bina_transform_create_radix2_c2c_fft(in, out, fft_len, flags);
 
 	in[0] = 0.0 + 1.0*I;
 	bina_transform_execute(transform);
@@ -28,9 +42,576 @@ int main()
 	bina_transform_free(transform);
 	bina_complex_free(in);
 	bina_complex_free(out);
+
+	puts("radix2_c2c_fft_test");
+
+	CHECK(max_error_vs_dft(2, 0) < 1e-9);
+	CHECK(max_error_vs_dft(4, 0) < 1e-9);
+	CHECK(max_error_vs_dft(8, 0) < 1e-9);
+	CHECK(max_error_vs_dft(64, 0) < 1e-9);
+	CHECK(max_error_vs_dft(1024, 0) < 1e-9);
+	CHECK(max_error_vs_dft(8, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(64, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(4096, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(4, BINA_FFT_INVERSE) < 1e-9);
+	CHECK(max_error_vs_dft(256, BINA_FFT_INVERSE) < 1e-9);
+	CHECK(max_error_vs_dft(256, BINA_FFT_INVERSE
+				| BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(16, BINA_FFT_NONZERO_INPUTS(0)) < 1e-9);
+	CHECK(max_error_vs_dft(1024, BINA_FFT_NONZERO_INPUTS(4)) < 1e-9);
+	CHECK(max_error_vs_dft(64, BINA_FFT_NONZERO_INPUTS(6)) < 1e-9);
+	CHECK(max_error_vs_dft(16384, BINA_FFT_NONZERO_INPUTS(8)
+				| BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(512, BINA_FFT_NONZERO_INPUTS(7)
+				| BINA_FFT_INVERSE) < 1e-9);
+
+	puts("radix2_c2c_fft_compact_test");
+
+	/* One, two and many twiddle chunks per stage */
+	CHECK(max_error_compact_vs_full(512, 0) < 1e-15);
+	CHECK(max_error_compact_vs_full(1024, 0) < 1e-15);
+	CHECK(max_error_compact_vs_full(1 << 16, 0) < 1e-15);
+	CHECK(max_error_compact_vs_full(512, BINA_FFT_INVERSE) < 1e-15);
+	CHECK(max_error_compact_vs_full(1024, BINA_FFT_INVERSE) < 1e-15);
+	CHECK(max_error_compact_vs_full(1 << 16, BINA_FFT_INVERSE) < 1e-15);
+
+	puts("radix2_c2c_fft_segments_test");
+
+	CHECK(segments_match_contiguous(1, 0, 0, 0));
+	CHECK(segments_match_contiguous(2, 1, 0, 0));
+	CHECK(segments_match_contiguous(64, 0, 0, 0));
+	CHECK(segments_match_contiguous(64, 64, 0, 0));
+	CHECK(segments_match_contiguous(64, 13, 0, 0));
+	CHECK(segments_match_contiguous(64, 32, BINA_FFT_INVERSE, 0));
+	CHECK(segments_match_contiguous(64, 50, 0, 0));
+	CHECK(segments_match_contiguous(4096, 1000, BINA_FFT_COMPACT_TWIDDLE,
+				0));
+	CHECK(segments_match_contiguous(4096, 3001, BINA_FFT_COMPACT_TWIDDLE,
+				0));
+	CHECK(segments_match_contiguous(1024, 5, BINA_FFT_NONZERO_INPUTS(4),
+				0));
+	CHECK(segments_match_contiguous(1024, 500,
+				BINA_FFT_NONZERO_INPUTS(4), 0));
+	CHECK(segments_match_contiguous(2, 1, BINA_FFT_INVERSE
+				| BINA_FFT_SCRAMBLED, 0));
+	CHECK(segments_match_contiguous(64, 13, BINA_FFT_INVERSE
+				| BINA_FFT_SCRAMBLED, 0));
+	CHECK(segments_match_contiguous(4096, 1000, BINA_FFT_INVERSE
+				| BINA_FFT_SCRAMBLED | BINA_FFT_COMPACT_TWIDDLE,
+				0));
+	CHECK(segments_match_contiguous(1 << 18, 77777, BINA_FFT_INVERSE
+				| BINA_FFT_SCRAMBLED, 1 << 12));
+	CHECK(segments_into_ring(64, 13, 0));
+	CHECK(segments_into_ring(4096, 1000, BINA_FFT_COMPACT_TWIDDLE));
+	CHECK(segments_into_ring(1024, 5, BINA_FFT_NONZERO_INPUTS(4)));
+	CHECK(segments_into_ring(4096, 100, BINA_FFT_NONZERO_INPUTS(9)
+				| BINA_FFT_COMPACT_TWIDDLE));
+
+	puts("radix2_c2c_fft_scrambled_test");
+
+	CHECK(max_error_scrambled(1, 0, 0) < 1e-9);
+	CHECK(max_error_scrambled(2, 0, 0) < 1e-9);
+	CHECK(max_error_scrambled(8, 0, 0) < 1e-9);
+	CHECK(max_error_scrambled(1024, 0, 0) < 1e-9);
+	CHECK(max_error_scrambled(4096, BINA_FFT_COMPACT_TWIDDLE, 0) < 1e-9);
+	CHECK(max_error_scrambled(1024, BINA_FFT_NONZERO_INPUTS(5), 0)
+			< 1e-9);
+	CHECK(bina_transform_create_radix2_c2c_fft(NULL, NULL, 64,
+				BINA_FFT_INVERSE | BINA_FFT_SCRAMBLED
+				| BINA_FFT_NONZERO_INPUTS(3)) == NULL);
+	CHECK(fused_rejects_scrambled_inverse(64));
+
+	/* Past the cache length, the stages run depth first, whatever the L2
+	 * of the host; the shortest one splits down to single butterflies.
+	 */
+	CHECK(max_error_scrambled(1 << 18, 0, 1 << 12) < 1e-9);
+	CHECK(max_error_scrambled(1 << 17, BINA_FFT_COMPACT_TWIDDLE, 1 << 10)
+			< 1e-9);
+	CHECK(max_error_scrambled(4096, BINA_FFT_NONZERO_INPUTS(11), 2)
+			< 1e-9);
+	CHECK(max_error_tone(1 << 18, 12345, 0, 1 << 12) < 1e-9);
+	CHECK(max_error_tone(1 << 17, 777, BINA_FFT_COMPACT_TWIDDLE
+				| BINA_FFT_INVERSE, 1 << 10) < 1e-9);
+	CHECK(max_error_tone(1024, 3, BINA_FFT_INVERSE, 2) < 1e-9);
+
+	puts("radix2_r2c_fft_test");
+
+	CHECK(max_error_r2c_vs_dft(2, 0) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(4, 0) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(64, 0) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(2048, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(64, BINA_FFT_NONZERO_INPUTS(0)) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(64, BINA_FFT_NONZERO_INPUTS(3)) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(1024, BINA_FFT_NONZERO_INPUTS(9)) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(16, BINA_FFT_NONZERO_INPUTS(4)) < 1e-9);
+	CHECK(max_error_r2c_vs_dft(64, BINA_FFT_SCRAMBLED) < 1e-9);
+
+	puts("radix2_c2c_fft_2d_test");
+
+	CHECK(max_error_vs_dft_2d(1, 8, 0) < 1e-9);
+	CHECK(max_error_vs_dft_2d(8, 2, 0) < 1e-9);
+	CHECK(max_error_vs_dft_2d(32, 64, 0) < 1e-9);
+	CHECK(max_error_vs_dft_2d(64, 16, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft_2d(8, 16, BINA_FFT_NONZERO_INPUTS(2)) < 1e-9);
+	CHECK(max_error_vs_dft_2d(8, 16, BINA_FFT_SCRAMBLED) < 1e-9);
+
 	return 0;
 }
 
+/* Compares the transform of a random signal against a direct DFT,
+ * X[k] = sum x[n] exp(-2 pi i n k / N), or exp(+...) for BINA_FFT_INVERSE.
+ * With BINA_FFT_NONZERO_INPUTS() the padding is filled with garbage, which
+ * the transform must not read.
+ */
+static double max_error_vs_dft(int fft_len, int flags)
+{
+	bina_complex *in = bina_complex_alloc(fft_len);
+	bina_complex *out = bina_complex_alloc(fft_len);
+	bina_transform transform = bina_transform_create_radix2_c2c_fft(in, out, fft_len, flags);
+	double error = 0.0;
+	long double sign = (flags & BINA_FFT_INVERSE) ? 1.0L : -1.0L;
+	int lg_m = ((flags & BINA_FFT_NONZERO_INPUTS_MASK) >> 16) - 1;
+	int nonzero = (lg_m >= 0 && (1 << lg_m) < fft_len) ? 1 << lg_m
+		: fft_len;
+
+	if (transform == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < fft_len; i++) {
+		in[i] = 1e6;
+	}
+
+	for (int i = 0; i < nonzero; i++) {
+		in[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	bina_transform_execute(transform);
+
+	for (int k = 0; k < fft_len; k++) {
+		long double complex sum = 0;
+
+		for (int n = 0; n < nonzero; n++) {
+			/* Reduce n * k first to keep the argument small */
+			long double t = 2.0L * M_PI * ((n * k) % fft_len) / fft_len;
+			sum += in[n] * (cosl(t) + sign * sinl(t) * I);
+		}
+
+		error = fmax(error, cabs(out[k] - (bina_complex) sum));
+	}
+
+	bina_transform_free(transform);
+	bina_complex_free(in);
+	bina_complex_free(out);
+
+	return error;
+}
+
+/* Compares the real-to-complex transform of a random signal against a
+ * direct DFT, and the complex-to-real transform of that against the signal.
+ * With BINA_FFT_NONZERO_INPUTS() the padding is filled with garbage, which
+ * the transform must not read.
+ */
+static double max_error_r2c_vs_dft(int fft_len, int flags)
+{
+	bina_real *in = calloc(fft_len, sizeof(bina_real));
+	bina_real *back = calloc(fft_len, sizeof(bina_real));
+	bina_complex *out = bina_complex_alloc(fft_len / 2 + 1);
+	bina_transform r2c = bina_transform_create_radix2_r2c_fft(in, out, fft_len, flags);
+	bina_transform c2r = bina_transform_create_radix2_c2r_fft(out, back, fft_len, flags);
+	double error = 0.0;
+	int lg_m = ((flags & BINA_FFT_NONZERO_INPUTS_MASK) >> 16) - 1;
+	int nonzero = (lg_m >= 0 && (1 << lg_m) < fft_len) ? 1 << lg_m
+		: fft_len;
+
+	if (r2c == NULL || c2r == NULL) {
+		return INFINITY;
+	}
+
+	/* Samples are read in pairs */
+	nonzero = (nonzero < 2) ? 2 : nonzero;
+
+	for (int i = 0; i < fft_len; i++) {
+		in[i] = (i < nonzero) ? rand() / (double) RAND_MAX - 0.5 : 1e6;
+	}
+
+	bina_transform_execute(r2c);
+	bina_transform_execute(c2r);
+
+	for (int k = 0; k <= fft_len / 2; k++) {
+		long double complex sum = 0;
+
+		for (int n = 0; n < nonzero; n++) {
+			long double t = 2.0L * M_PI * ((n * k) % fft_len) / fft_len;
+			sum += in[n] * (cosl(t) - sinl(t) * I);
+		}
+
+		error = fmax(error, cabs(out[k] - (bina_complex) sum));
+	}
+
+	for (int n = 0; n < fft_len; n++) {
+		double expected = (n < nonzero) ? in[n] : 0.0;
+
+		error = fmax(error, fabs(back[n] / fft_len - expected));
+	}
+
+	bina_transform_free(r2c);
+	bina_transform_free(c2r);
+	free(in);
+	free(back);
+	bina_complex_free(out);
+
+	return error;
+}
+
+/* Same as max_error_vs_dft(), for a row-major 2-D transform (in place) */
+static double max_error_vs_dft_2d(int rows, int columns, int flags)
+{
+	int len = rows * columns;
+	bina_complex *in = bina_complex_alloc(len);
+	bina_complex *out = bina_complex_alloc(len);
+	bina_transform transform = bina_transform_create_radix2_c2c_fft_2d(out, out, rows, columns, flags);
+	double error = 0.0;
+
+	if (transform == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < len; i++) {
+		in[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+		out[i] = in[i];
+	}
+
+	bina_transform_execute(transform);
+
+	for (int k = 0; k < rows; k++) {
+		for (int l = 0; l < columns; l++) {
+			long double complex sum = 0;
+
+			for (int m = 0; m < rows; m++) {
+				for (int n = 0; n < columns; n++) {
+					long double t = 2.0L * M_PI
+						* ((double) ((m * k) % rows) / rows
+						+ (double) ((n * l) % columns) / columns);
+					sum += in[m * columns + n] * (cosl(t) - sinl(t) * I);
+				}
+			}
+
+			error = fmax(error, cabs(out[k * columns + l] - (bina_complex) sum));
+		}
+	}
+
+	bina_transform_free(transform);
+	bina_complex_free(in);
+	bina_complex_free(out);
+
+	return error;
+}
+
+/* Transforms a frame split at `head_length' into two segments, the head
+ * at the end of a ring buffer and the rest at its start, and checks the
+ * result against the one of the contiguous frame. A nonzero cache length
+ * is set on the split plan, see radix2_c2c_fft_set_cache_length().
+ */
+static int segments_match_contiguous(int fft_len, int head_length,
+		int flags, int cache_length)
+{
+	bina_complex *frame = bina_complex_alloc(fft_len);
+	bina_complex *ring = bina_complex_alloc(fft_len + 7);
+	bina_complex *expected = bina_complex_alloc(fft_len);
+	bina_complex *out = bina_complex_alloc(fft_len);
+	bina_transform contiguous = bina_transform_create_radix2_c2c_fft(frame,
+			expected, fft_len, flags);
+	bina_transform split = bina_transform_create_radix2_c2c_fft(NULL, out,
+			fft_len, flags);
+	int tail_length = fft_len - head_length;
+	int ok = (contiguous != NULL && split != NULL);
+
+	if (ok && cache_length > 0) {
+		ok = (radix2_c2c_fft_set_cache_length(split, cache_length)
+				== 0);
+	}
+
+	for (int i = 0; i < fft_len; i++) {
+		frame[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	/* Head in the last slots, tail wrapped around to the first */
+	for (int i = 0; i < head_length; i++) {
+		ring[fft_len + 7 - head_length + i] = frame[i];
+	}
+
+	for (int i = 0; i < tail_length; i++) {
+		ring[i] = frame[head_length + i];
+	}
+
+	bina_transform_execute(contiguous);
+	ok = ok && bina_transform_execute_segments(split,
+			ring + fft_len + 7 - head_length, head_length,
+			ring, tail_length) == 0;
+
+	for (int k = 0; k < fft_len && ok; k++) {
+		ok = (cabs(out[k] - expected[k]) < 1e-12);
+	}
+
+	ok = ok && bina_transform_execute_segments(split, ring, head_length,
+			ring, tail_length + 1) != 0;
+
+	bina_transform_free(contiguous);
+	bina_transform_free(split);
+	bina_complex_free(frame);
+	bina_complex_free(ring);
+	bina_complex_free(expected);
+	bina_complex_free(out);
+
+	return ok;
+}
+
+/* Checks that a scrambled forward transform is the bit reversal of the
+ * plain one, and that the scrambled inverse takes it back to n times the
+ * input, in place. Returns the largest error relative to the largest bin.
+ * A nonzero cache length is set on all three plans.
+ */
+static double max_error_scrambled(int fft_len, int flags, int cache_length)
+{
+	bina_complex *in = bina_complex_alloc(fft_len);
+	bina_complex *natural = bina_complex_alloc(fft_len);
+	bina_complex *scrambled = bina_complex_alloc(fft_len);
+	bina_transform plain = bina_transform_create_radix2_c2c_fft(in,
+			natural, fft_len, flags);
+	bina_transform forward = bina_transform_create_radix2_c2c_fft(in,
+			scrambled, fft_len, flags | BINA_FFT_SCRAMBLED);
+	bina_transform inverse = bina_transform_create_radix2_c2c_fft(
+			scrambled, scrambled, fft_len,
+			(flags & BINA_FFT_COMPACT_TWIDDLE) | BINA_FFT_INVERSE
+			| BINA_FFT_SCRAMBLED);
+	int bits = 0;
+	int nonzero = fft_len;
+	double error = 0.0;
+	double scale = 0.0;
+
+	if (plain == NULL || forward == NULL || inverse == NULL) {
+		return INFINITY;
+	}
+
+	if (cache_length > 0
+			&& (radix2_c2c_fft_set_cache_length(plain,
+					cache_length) != 0
+				|| radix2_c2c_fft_set_cache_length(forward,
+					cache_length) != 0
+				|| radix2_c2c_fft_set_cache_length(inverse,
+					cache_length) != 0)) {
+		return INFINITY;
+	}
+
+	while ((1 << bits) < fft_len) {
+		bits++;
+	}
+
+	if (flags & BINA_FFT_NONZERO_INPUTS_MASK) {
+		nonzero = 1 << (((flags & BINA_FFT_NONZERO_INPUTS_MASK) >> 16)
+				- 1);
+	}
+
+	for (int i = 0; i < nonzero; i++) {
+		in[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	bina_transform_execute(plain);
+	bina_transform_execute(forward);
+
+	for (int j = 0; j < fft_len; j++) {
+		int rev = 0;
+
+		for (int b = 0; b < bits; b++) {
+			rev |= ((j >> b) & 1) << (bits - 1 - b);
+		}
+
+		error = fmax(error, cabs(scrambled[j] - natural[rev]));
+		scale = fmax(scale, cabs(natural[rev]));
+	}
+
+	bina_transform_execute(inverse);
+
+	for (int i = 0; i < fft_len; i++) {
+		error = fmax(error, cabs(scrambled[i] / fft_len - in[i]));
+	}
+
+	bina_transform_free(plain);
+	bina_transform_free(forward);
+	bina_transform_free(inverse);
+	bina_complex_free(in);
+	bina_complex_free(natural);
+	bina_complex_free(scrambled);
+
+	return error / scale;
+}
+
+/* Transforms a complex exponential at the given bin, whose spectrum is n
+ * at that bin and zero elsewhere, and returns the largest error relative
+ * to n. Cheap enough to check lengths a direct DFT would take long on.
+ * A nonzero cache length is set on the plan.
+ */
+static double max_error_tone(int fft_len, int bin, int flags,
+		int cache_length)
+{
+	bina_complex *in = bina_complex_alloc(fft_len);
+	bina_complex *out = bina_complex_alloc(fft_len);
+	bina_transform fft = bina_transform_create_radix2_c2c_fft(in, out,
+			fft_len, flags);
+	double sign = (flags & BINA_FFT_INVERSE) ? -1.0 : 1.0;
+	double error = 0.0;
+
+	if (fft == NULL || (cache_length > 0
+				&& radix2_c2c_fft_set_cache_length(fft,
+					cache_length) != 0)) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < fft_len; i++) {
+		double a = 2.0 * M_PI * (((long) i * bin) % fft_len) / fft_len;
+
+		in[i] = cos(a) + sign * sin(a) * I;
+	}
+
+	bina_transform_execute(fft);
+
+	for (int j = 0; j < fft_len; j++) {
+		error = fmax(error, cabs(out[j] - ((j == bin) ? fft_len : 0)));
+	}
+
+	bina_transform_free(fft);
+	bina_complex_free(in);
+	bina_complex_free(out);
+
+	return error / fft_len;
+}
+
+/* A scrambled inverse takes bit reversed input, which the fused window and
+ * power passes do not expect: both must fail rather than run on it.
+ */
+static int fused_rejects_scrambled_inverse(int fft_len)
+{
+	bina_complex *in = bina_complex_alloc(fft_len);
+	bina_complex *out = bina_complex_alloc(fft_len);
+	double *window = calloc(fft_len, sizeof(double));
+	double *power = calloc(fft_len, sizeof(double));
+	bina_transform transform = bina_transform_create_radix2_c2c_fft(NULL,
+			NULL, fft_len, BINA_FFT_INVERSE | BINA_FFT_SCRAMBLED);
+	int ok = 0;
+
+	if (transform == NULL) {
+		return 0;
+	}
+
+	ok = radix2_c2c_fft_execute_fused(transform, in, window, out, NULL,
+			RADIX2_C2C_FFT_SPECTRUM) != 0
+		&& radix2_c2c_fft_execute_fused(transform, in, NULL, out,
+				power, RADIX2_C2C_FFT_POWER) != 0
+		&& radix2_c2c_fft_execute_fused(transform, in, NULL, out,
+				NULL, RADIX2_C2C_FFT_SPECTRUM) == 0;
+
+	bina_transform_free(transform);
+	bina_complex_free(in);
+	bina_complex_free(out);
+	free(window);
+	free(power);
+
+	return ok;
+}
+
+/* Same as segments_match_contiguous(), with the output written over the
+ * ring buffer that holds the segments, from the start of the tail on.
+ */
+static int segments_into_ring(int fft_len, int head_length, int flags)
+{
+	bina_complex *frame = bina_complex_alloc(fft_len);
+	bina_complex *ring = bina_complex_alloc(fft_len + 7);
+	bina_complex *expected = bina_complex_alloc(fft_len);
+	bina_transform contiguous = bina_transform_create_radix2_c2c_fft(frame,
+			expected, fft_len, flags);
+	bina_transform split = bina_transform_create_radix2_c2c_fft(NULL, ring,
+			fft_len, flags);
+	int tail_length = fft_len - head_length;
+	int ok = (contiguous != NULL && split != NULL);
+
+	for (int i = 0; i < fft_len; i++) {
+		frame[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	for (int i = 0; i < head_length; i++) {
+		ring[fft_len + 7 - head_length + i] = frame[i];
+	}
+
+	for (int i = 0; i < tail_length; i++) {
+		ring[i] = frame[head_length + i];
+	}
+
+	bina_transform_execute(contiguous);
+	ok = ok && bina_transform_execute_segments(split,
+			ring + fft_len + 7 - head_length, head_length,
+			ring, tail_length) == 0;
+
+	for (int k = 0; k < fft_len && ok; k++) {
+		ok = (cabs(ring[k] - expected[k]) < 1e-12);
+	}
+
+	bina_transform_free(contiguous);
+	bina_transform_free(split);
+	bina_complex_free(frame);
+	bina_complex_free(ring);
+	bina_complex_free(expected);
+
+	return ok;
+}
+
+/* Runs the same random signal through a plan with the full twiddle table
+ * and one with BINA_FFT_COMPACT_TWIDDLE, and returns the largest difference
+ * relative to the largest bin.
+ */
+static double max_error_compact_vs_full(int fft_len, int flags)
+{
+	bina_complex *in = bina_complex_alloc(fft_len);
+	bina_complex *full = bina_complex_alloc(fft_len);
+	bina_complex *compact = bina_complex_alloc(fft_len);
+	bina_transform t0 = bina_transform_create_radix2_c2c_fft(in, full,
+			fft_len, flags);
+	bina_transform t1 = bina_transform_create_radix2_c2c_fft(in, compact,
+			fft_len, flags | BINA_FFT_COMPACT_TWIDDLE);
+	double error = 0.0;
+	double scale = 0.0;
+
+	if (t0 == NULL || t1 == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < fft_len; i++) {
+		in[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	bina_transform_execute(t0);
+	bina_transform_execute(t1);
+
+	for (int k = 0; k < fft_len; k++) {
+		error = fmax(error, cabs(compact[k] - full[k]));
+		scale = fmax(scale, cabs(full[k]));
+	}
+
+	bina_transform_free(t0);
+	bina_transform_free(t1);
+	bina_complex_free(in);
+	bina_complex_free(full);
+	bina_complex_free(compact);
+
+	return error / scale;
+}
+
 static void printc(bina_complex *arr, size_t len)
 {
 	const char *line = "-------------------------";
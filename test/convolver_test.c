@@ -0,0 +1,109 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* convolver_test.c - Unit test functions for the streaming convolver
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_direct(int filter_length, int fft_length,
+		int signal_length, int max_chunk);
+
+int main(int argc, char *argv[])
+{
+	bina_complex h[4] = { 1 };
+	bina_convolver conv = NULL;
+
+	puts("convolver_test");
+
+	/* Overlap of M - 1 samples, latency is the rest of the block */
+	CHECK((conv = bina_convolver_create(h, 4, 16, 0)) != NULL);
+	CHECK(bina_convolver_latency(conv) == 13);
+	CHECK(bina_convolver_free(conv) == 0);
+
+	/* Automatic size is larger than the filter, and not absurdly so */
+	CHECK((conv = bina_convolver_create(h, 4, 0, 0)) != NULL);
+	CHECK(bina_convolver_latency(conv) > 4);
+	CHECK(bina_convolver_latency(conv) < 64);
+	CHECK(bina_convolver_free(conv) == 0);
+
+	CHECK(bina_convolver_create(h, 4, 2, 0) == NULL);
+	CHECK(bina_convolver_create(h, 4, 24, 0) == NULL);
+
+	CHECK(max_error_vs_direct(1, 8, 100, 3) < 1e-9);
+	CHECK(max_error_vs_direct(8, 8, 100, 5) < 1e-9);
+	CHECK(max_error_vs_direct(33, 64, 1000, 17) < 1e-9);
+	CHECK(max_error_vs_direct(100, 0, 5000, 700) < 1e-9);
+	CHECK(max_error_vs_direct(257, 0, 5000, 1) < 1e-9);
+
+	return 0;
+}
+
+/* Streams a random signal through a convolver in random sized chunks and
+ * compares it against direct convolution, delayed by the latency.
+ */
+static double max_error_vs_direct(int filter_length, int fft_length,
+		int signal_length, int max_chunk)
+{
+	bina_complex *h = calloc(filter_length, sizeof(bina_complex));
+	bina_complex *x = calloc(signal_length, sizeof(bina_complex));
+	bina_complex *y = calloc(signal_length, sizeof(bina_complex));
+	bina_convolver conv = NULL;
+	double error = 0.0;
+	int latency;
+
+	for (int i = 0; i < filter_length; i++) {
+		h[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	for (int i = 0; i < signal_length; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	conv = bina_convolver_create(h, filter_length, fft_length, 0);
+
+	if (conv == NULL) {
+		return INFINITY;
+	}
+
+	latency = bina_convolver_latency(conv);
+
+	for (int i = 0; i < signal_length;) {
+		int n = 1 + rand() % max_chunk;
+
+		if (n > signal_length - i) {
+			n = signal_length - i;
+		}
+
+		bina_convolver_process(conv, x + i, y + i, n);
+		i += n;
+	}
+
+	for (int i = 0; i < signal_length; i++) {
+		int t = i - latency;
+		bina_complex sum = 0;
+
+		for (int k = 0; k < filter_length && k <= t; k++) {
+			sum += h[k] * x[t - k];
+		}
+
+		error = fmax(error, cabs(y[i] - sum));
+	}
+
+	bina_convolver_free(conv);
+	free(h);
+	free(x);
+	free(y);
+
+	return error;
+}
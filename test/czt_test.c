@@ -0,0 +1,79 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* czt_test.c - Unit test functions for the chirp-Z transform
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_direct(int n, int m, double start, double step,
+		int flags);
+
+int main(int argc, char *argv[])
+{
+	puts("czt_test");
+
+	CHECK(bina_transform_create_czt(NULL, NULL, 0, 4, 0.0, 0.1, 0) == NULL);
+	CHECK(bina_transform_create_czt(NULL, NULL, 4, 0, 0.0, 0.1, 0) == NULL);
+
+	CHECK(max_error_vs_direct(1, 1, 0.0, 0.0, 0) < 1e-9);
+	/* The DFT, of a length that is not a power of two */
+	CHECK(max_error_vs_direct(100, 100, 0.0, 0.01, 0) < 1e-9);
+	CHECK(max_error_vs_direct(37, 5, -0.3, 0.123, 0) < 1e-9);
+	/* Zoom into a narrow band */
+	CHECK(max_error_vs_direct(1000, 2048, 0.1, 1e-5, 0) < 1e-8);
+	CHECK(max_error_vs_direct(3000, 700, 0.25, 3e-4,
+				BINA_FFT_COMPACT_TWIDDLE) < 1e-8);
+
+	return 0;
+}
+
+/* Compares the transform of a random signal with the direct sum */
+static double max_error_vs_direct(int n, int m, double start, double step,
+		int flags)
+{
+	bina_complex *x = calloc(n, sizeof(bina_complex));
+	bina_complex *y = calloc(m, sizeof(bina_complex));
+	bina_transform czt = bina_transform_create_czt(x, y, n, m, start, step,
+			flags);
+	double error = 0.0;
+
+	if (czt == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < n; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	bina_transform_execute(czt);
+
+	for (int k = 0; k < m; k++) {
+		long double f = start + (long double) k * step;
+		long double complex sum = 0;
+
+		for (int i = 0; i < n; i++) {
+			long double c = f * i;
+			long double t = 2.0L * M_PI * (c - floorl(c));
+
+			sum += x[i] * (cosl(t) - sinl(t) * I);
+		}
+
+		error = fmax(error, cabs(y[k] - (bina_complex) sum));
+	}
+
+	bina_transform_free(czt);
+	free(x);
+	free(y);
+
+	return error;
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* file_fft_test.c - Unit test functions for the out-of-core FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double error_vs_memory(size_t n, size_t budget, int flags);
+
+static int fails_on_short_input(void);
+
+int main(int argc, char *argv[])
+{
+	puts("file_fft_test");
+
+	CHECK(bina_file_fft_create(3, 1 << 20, 0) == NULL);
+	CHECK(bina_file_fft_create(1 << 12, 32 * 64 - 1, 0) == NULL);
+
+	/* Narrowest blocks, several blocks, and the whole file in one */
+	CHECK(error_vs_memory(2, 64, 0) < 1e-15);
+	CHECK(error_vs_memory(1 << 12, 32 * 64, 0) < 1e-14);
+	CHECK(error_vs_memory(1 << 11, 32 * 256, BINA_FFT_INVERSE) < 1e-14);
+	CHECK(error_vs_memory(1 << 13, 1 << 20, 0) < 1e-14);
+	CHECK(fails_on_short_input());
+
+	return 0;
+}
+
+/* Writes random points to a temporary file, transforms it into another,
+ * and returns the largest error against the in-memory transform, relative
+ * to the largest bin.
+ */
+static double error_vs_memory(size_t n, size_t budget, int flags)
+{
+	char in_path[] = "/tmp/file_fft_in_XXXXXX";
+	char out_path[] = "/tmp/file_fft_out_XXXXXX";
+	int in_fd = mkstemp(in_path);
+	int out_fd = mkstemp(out_path);
+	bina_complex *x = malloc(n * sizeof(bina_complex));
+	bina_complex *y = malloc(n * sizeof(bina_complex));
+	bina_file_fft fft = bina_file_fft_create(n, budget, flags);
+	bina_transform plain = bina_transform_create_radix2_c2c_fft(x, x,
+			(int) n, flags);
+	double error = INFINITY;
+	double scale = 0.0;
+
+	for (size_t i = 0; i < n; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	if (in_fd >= 0 && out_fd >= 0 && fft != NULL && plain != NULL
+			&& write(in_fd, x, n * sizeof(bina_complex))
+				== (ssize_t) (n * sizeof(bina_complex))
+			&& bina_file_fft_execute(fft, in_fd, out_fd) == 0
+			&& pread(out_fd, y, n * sizeof(bina_complex), 0)
+				== (ssize_t) (n * sizeof(bina_complex))) {
+		bina_transform_execute(plain);
+		error = 0.0;
+
+		for (size_t k = 0; k < n; k++) {
+			error = fmax(error, cabs(y[k] - x[k]));
+			scale = fmax(scale, cabs(x[k]));
+		}
+
+		error /= scale;
+	}
+
+	bina_file_fft_free(fft);
+	bina_transform_free(plain);
+	close(in_fd);
+	close(out_fd);
+	unlink(in_path);
+	unlink(out_path);
+	free(x);
+	free(y);
+
+	return error;
+}
+
+/* A missing input file or one shorter than N points is an error */
+static int fails_on_short_input(void)
+{
+	char in_path[] = "/tmp/file_fft_in_XXXXXX";
+	char out_path[] = "/tmp/file_fft_out_XXXXXX";
+	int in_fd = mkstemp(in_path);
+	int out_fd = mkstemp(out_path);
+	bina_complex x[100] = { 0 };
+	bina_file_fft fft = bina_file_fft_create(128, 1 << 16, 0);
+	int ok = (in_fd >= 0 && out_fd >= 0 && fft != NULL
+			&& write(in_fd, x, sizeof(x)) == sizeof(x));
+
+	close(in_fd);
+	close(out_fd);
+	ok = ok && bina_file_fft_execute_path(fft, in_path,
+			"/nonexistent/file_fft_out") != 0;
+	ok = ok && bina_file_fft_execute_path(fft, in_path, out_path) != 0;
+
+	bina_file_fft_free(fft);
+	unlink(in_path);
+	unlink(out_path);
+
+	return ok;
+}
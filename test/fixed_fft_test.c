@@ -0,0 +1,99 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* fixed_fft_test.c - Unit test functions for the fixed-point FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double error_vs_double(int n, int amplitude, int flags,
+		int *exponent);
+
+int main(int argc, char *argv[])
+{
+	int16_t x[4] = { 0 };
+	int exponent = 0;
+
+	puts("fixed_fft_test");
+
+	CHECK(bina_transform_create_fixed_c2c_fft(x, x, 3, 0) == NULL);
+
+	/* Relative to the largest bin, about 16 bits less a bit per stage */
+	CHECK(error_vs_double(1, 32767, 0, &exponent) < 1e-9);
+	CHECK(exponent == 0);
+	CHECK(error_vs_double(2, 32767, 0, &exponent) < 1e-4);
+	CHECK(error_vs_double(64, 32767, 0, &exponent) < 1e-3);
+	CHECK(error_vs_double(1024, 32767, 0, &exponent) < 3e-3);
+	CHECK(exponent >= 5 && exponent <= 12);
+	CHECK(error_vs_double(1024, 32767, BINA_FFT_INVERSE, &exponent)
+			< 3e-3);
+
+	/* Quiet inputs keep their precision, with no shifts early on */
+	CHECK(error_vs_double(1024, 100, 0, &exponent) < 3e-2);
+	CHECK(exponent < 5);
+
+	/* Full scale DC, the worst case for growth, must not wrap around */
+	CHECK(error_vs_double(4096, -1, 0, &exponent) < 1e-3);
+	CHECK(exponent == 12 || exponent == 13);
+
+	return 0;
+}
+
+/* Largest error of the transform of random samples of the given amplitude
+ * (-1 for a constant -32768 - 32768i), against a double precision DFT,
+ * relative to its largest bin.
+ */
+static double error_vs_double(int n, int amplitude, int flags,
+		int *exponent)
+{
+	int16_t *x = calloc(2 * n, sizeof(int16_t));
+	int16_t *y = calloc(2 * n, sizeof(int16_t));
+	bina_transform fft = bina_transform_create_fixed_c2c_fft(x, y, n,
+			flags);
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	double scale = 0.0;
+	double error = 0.0;
+
+	if (fft == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < 2 * n; i++) {
+		x[i] = (amplitude < 0) ? INT16_MIN
+			: rand() % (2 * amplitude + 1) - amplitude;
+	}
+
+	bina_transform_execute(fft);
+	*exponent = bina_fixed_fft_exponent(fft);
+
+	for (int k = 0; k < n; k++) {
+		bina_complex sum = 0.0;
+		bina_complex got = ldexp(y[2 * k], *exponent)
+			+ ldexp(y[2 * k + 1], *exponent) * I;
+
+		for (int i = 0; i < n; i++) {
+			double a = 2.0 * M_PI * (((long) i * k) % n) / n;
+
+			sum += (x[2 * i] + x[2 * i + 1] * I)
+				* (cos(a) + sign * sin(a) * I);
+		}
+
+		error = fmax(error, cabs(got - sum));
+		scale = fmax(scale, cabs(sum));
+	}
+
+	bina_transform_free(fft);
+	free(x);
+	free(y);
+
+	return error / scale;
+}
@@ -0,0 +1,189 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* half_fft_test.c - Unit test functions for the half precision FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static int passes_through(const uint16_t *values, int count, int flags);
+
+static double error_vs_double(int n, int flags);
+
+static int in_place_matches(int n, int flags);
+
+int main(int argc, char *argv[])
+{
+	/* Zeros, one, largest, smallest subnormal and normal, a subnormal
+	 * with a carry, infinities and a quiet NaN.
+	 */
+	const uint16_t half[] = { 0x0000, 0x8000, 0x3c00, 0x7bff, 0x0001,
+		0x0400, 0x83ff, 0x7c00, 0xfc00, 0x7e00 };
+	const uint16_t bfloat[] = { 0x0000, 0x8000, 0x3f80, 0x7f7f, 0x0001,
+		0xc2f7, 0x7f80, 0xff80, 0x7fc0, 0x3eab };
+	uint16_t x[2] = { 0 };
+
+	puts("half_fft_test");
+
+	CHECK(bina_transform_create_half_c2c_fft(x, x, 3, 0) == NULL);
+
+	/* A one point transform converts there and back exactly */
+	CHECK(passes_through(half, 10, 0));
+	CHECK(passes_through(bfloat, 10, BINA_FFT_BFLOAT16));
+
+	CHECK(error_vs_double(1024, 0) < 1e-3);
+	CHECK(error_vs_double(1024, BINA_FFT_INVERSE) < 1e-3);
+	CHECK(error_vs_double(1024, BINA_FFT_BFLOAT16) < 1e-2);
+	CHECK(error_vs_double(16, BINA_FFT_COMPACT_TWIDDLE) < 1e-3);
+	CHECK(error_vs_double(64, BINA_FFT_NONZERO_INPUTS(2)) < 1e-3);
+	CHECK(error_vs_double(64, BINA_FFT_SCRAMBLED) < 1e-3);
+	CHECK(error_vs_double(64, BINA_FFT_SCRAMBLED | BINA_FFT_INVERSE)
+			< 1e-3);
+
+	/* Many blocks through the first stage and out of the last */
+	CHECK(error_vs_double(4096, BINA_FFT_COMPACT_TWIDDLE) < 1e-3);
+	CHECK(in_place_matches(2, 0));
+	CHECK(in_place_matches(4096, BINA_FFT_BFLOAT16));
+
+	return 0;
+}
+
+/* Runs each value through one point transforms, as the real then the
+ * imaginary part, and checks it comes out bit for bit.
+ */
+static int passes_through(const uint16_t *values, int count, int flags)
+{
+	uint16_t x[2];
+	uint16_t y[2];
+	bina_transform fft = bina_transform_create_half_c2c_fft(x, y, 1,
+			flags);
+	int ok = (fft != NULL);
+
+	for (int i = 0; i < count && ok; i++) {
+		x[0] = values[i];
+		x[1] = values[count - 1 - i];
+		bina_transform_execute(fft);
+		ok = (y[0] == x[0] && y[1] == x[1]);
+	}
+
+	bina_transform_free(fft);
+
+	return ok;
+}
+
+static float to_float(uint16_t h, int flags)
+{
+	float f;
+
+	if (flags & BINA_FFT_BFLOAT16) {
+		uint32_t bits = (uint32_t) h << 16;
+
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	return ldexpf((h & 0x3ff) | ((h & 0x7c00) ? 0x400 : 0),
+			((h >> 10) & 0x1f) ? ((h >> 10) & 0x1f) - 25 : -24)
+		* ((h & 0x8000) ? -1.0f : 1.0f);
+}
+
+/* Largest error of the transform of random samples in [-1, 1), read back
+ * from storage, against a double precision DFT of the stored input,
+ * relative to the largest bin.
+ */
+static double error_vs_double(int n, int flags)
+{
+	uint16_t *x = calloc(2 * n, sizeof(uint16_t));
+	uint16_t *y = calloc(2 * n, sizeof(uint16_t));
+	bina_transform fft = bina_transform_create_half_c2c_fft(x, y, n,
+			flags);
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	double error = 0.0;
+	double scale = 0.0;
+
+	if (fft == NULL) {
+		return INFINITY;
+	}
+
+	/* Random magnitudes in [2^-4, 1), both signs */
+	for (int i = 0; i < 2 * n; i++) {
+		x[i] = (flags & BINA_FFT_BFLOAT16) ?
+			(uint16_t) (0x3d80 + rand() % 0x200)
+			: (uint16_t) (0x2c00 + rand() % 0x1000);
+		x[i] |= (rand() & 1) ? 0x8000 : 0;
+	}
+
+	bina_transform_execute(fft);
+
+	for (int k = 0; k < n; k++) {
+		bina_complex sum = 0.0;
+		bina_complex got = to_float(y[2 * k], flags)
+			+ to_float(y[2 * k + 1], flags) * I;
+
+		for (int i = 0; i < n; i++) {
+			double a = 2.0 * M_PI * (((long) i * k) % n) / n;
+
+			sum += (to_float(x[2 * i], flags)
+					+ to_float(x[2 * i + 1], flags) * I)
+				* (cos(a) + sign * sin(a) * I);
+		}
+
+		error = fmax(error, cabs(got - sum));
+		scale = fmax(scale, cabs(sum));
+	}
+
+	bina_transform_free(fft);
+	free(x);
+	free(y);
+
+	return error / scale;
+}
+
+/* Runs the same random samples in place and out of place, and checks the
+ * results are the same bit for bit.
+ */
+static int in_place_matches(int n, int flags)
+{
+	uint16_t *x = calloc(2 * n, sizeof(uint16_t));
+	uint16_t *y = calloc(2 * n, sizeof(uint16_t));
+	bina_transform out_of_place = bina_transform_create_half_c2c_fft(x, y,
+			n, flags);
+	bina_transform in_place = bina_transform_create_half_c2c_fft(x, x, n,
+			flags);
+	int ok = (out_of_place != NULL && in_place != NULL);
+
+	for (int i = 0; i < 2 * n; i++) {
+		x[i] = (flags & BINA_FFT_BFLOAT16) ?
+			(uint16_t) (0x3d80 + rand() % 0x200)
+			: (uint16_t) (0x2c00 + rand() % 0x1000);
+	}
+
+	if (ok) {
+		bina_transform_execute(out_of_place);
+		bina_transform_execute(in_place);
+		ok = (memcmp(x, y, 2 * n * sizeof(uint16_t)) == 0);
+	}
+
+	if (out_of_place) {
+		bina_transform_free(out_of_place);
+	}
+
+	if (in_place) {
+		bina_transform_free(in_place);
+	}
+
+	free(x);
+	free(y);
+
+	return ok;
+}
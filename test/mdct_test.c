@@ -0,0 +1,139 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* mdct_test.c - Unit test functions for the MDCT
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_direct(int n, int frames);
+
+static double max_error_round_trip(int n, int window, int frames);
+
+int main(int argc, char *argv[])
+{
+	puts("mdct_test");
+
+	CHECK(bina_mdct_create(12, BINA_WINDOW_SINE, 0) == NULL);
+	CHECK(bina_mdct_create(16, BINA_WINDOW_HANN, 0) == NULL);
+
+	CHECK(max_error_vs_direct(2, 5) < 1e-12);
+	CHECK(max_error_vs_direct(16, 5) < 1e-12);
+	CHECK(max_error_vs_direct(64, 4) < 1e-12);
+
+	CHECK(max_error_round_trip(2, BINA_WINDOW_SINE, 50) < 1e-12);
+	CHECK(max_error_round_trip(256, BINA_WINDOW_SINE, 40) < 1e-12);
+	CHECK(max_error_round_trip(1024, BINA_WINDOW_KBD, 20) < 1e-12);
+
+	return 0;
+}
+
+/* Largest error of the frames of a random stream, fed in random sized
+ * chunks, against the definition over the last 2N samples, with the sine
+ * window.
+ */
+static double max_error_vs_direct(int n, int frames)
+{
+	const long double pi = 3.14159265358979323846264338327950288L;
+	int length = n * frames;
+	double *x = calloc(n + length, sizeof(double));
+	double *w = calloc(2 * n, sizeof(double));
+	double *coef = calloc(length, sizeof(double));
+	bina_mdct mdct = bina_mdct_create(n, BINA_WINDOW_SINE, 0);
+	double error = 0.0;
+	int count = 0;
+
+	if (mdct == NULL) {
+		return INFINITY;
+	}
+
+	/* N zeros, then the stream */
+	for (int i = n; i < n + length; i++) {
+		x[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	for (int i = 0; i < 2 * n; i++) {
+		w[i] = sin(M_PI * (i + 0.5) / (2 * n));
+	}
+
+	for (int i = 0; i < length;) {
+		int len = 1 + rand() % (2 * n);
+
+		len = (len < length - i) ? len : length - i;
+		count += bina_mdct_forward(mdct, x + n + i, len,
+				coef + (size_t) count * n);
+		i += len;
+	}
+
+	for (int f = 0; f < frames; f++) {
+		for (int k = 0; k < n; k++) {
+			long double sum = 0.0L;
+
+			for (int i = 0; i < 2 * n; i++) {
+				sum += w[i] * x[f * n + i] * cosl(pi / n
+						* (i + 0.5L + n / 2.0L)
+						* (k + 0.5L));
+			}
+
+			error = fmax(error, fabs(coef[(size_t) f * n + k]
+						- (double) sum));
+		}
+	}
+
+	bina_mdct_free(mdct);
+	free(x);
+	free(w);
+	free(coef);
+
+	return (count == frames) ? error : INFINITY;
+}
+
+/* Largest error of a random stream through the MDCT and its inverse, which
+ * should return it N samples late.
+ */
+static double max_error_round_trip(int n, int window, int frames)
+{
+	int length = n * frames;
+	double *x = calloc(length, sizeof(double));
+	double *coef = calloc(length, sizeof(double));
+	double *y = calloc(length, sizeof(double));
+	bina_mdct analysis = bina_mdct_create(n, window, 0);
+	bina_mdct synthesis = bina_mdct_create(n, window, 0);
+	double error = 0.0;
+
+	if (analysis == NULL || synthesis == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < length; i++) {
+		x[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	if (bina_mdct_forward(analysis, x, length, coef) != frames
+			|| bina_mdct_inverse(synthesis, coef, frames, y) != 0) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < n; i++) {
+		error = fmax(error, fabs(y[i]));
+	}
+
+	for (int i = n; i < length; i++) {
+		error = fmax(error, fabs(y[i] - x[i - n]));
+	}
+
+	bina_mdct_free(analysis);
+	bina_mdct_free(synthesis);
+	free(x);
+	free(coef);
+	free(y);
+
+	return error;
+}
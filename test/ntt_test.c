@@ -0,0 +1,218 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* ntt_test.c - Unit test functions for the number-theoretic transform
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+typedef unsigned __int128 wide;
+
+static uint64_t random64(void);
+
+static int matches_direct_dft(int n, int prime, int flags);
+
+static int round_trips(int n, int prime);
+
+static int convolution_matches(int a_length, int b_length, int bits);
+
+int main(int argc, char *argv[])
+{
+	uint64_t x[4] = { 0 };
+
+	puts("ntt_test");
+
+	CHECK(bina_ntt_modulus(3) == 0);
+	CHECK(bina_transform_create_ntt(x, x, 3, 0, 0) == NULL);
+	CHECK(bina_transform_create_ntt(x, x, 4, 3, 0) == NULL);
+	CHECK(bina_ntt_convolver_create(0) == NULL);
+
+	for (int prime = 0; prime < 3; prime++) {
+		CHECK(matches_direct_dft(1, prime, 0));
+		CHECK(matches_direct_dft(2, prime, 0));
+		CHECK(matches_direct_dft(64, prime, 0));
+		CHECK(matches_direct_dft(64, prime, BINA_FFT_INVERSE));
+		CHECK(round_trips(1 << 12, prime));
+	}
+
+	CHECK(convolution_matches(1, 1, 64));
+	CHECK(convolution_matches(7, 5, 64));
+	CHECK(convolution_matches(300, 1000, 64));
+	CHECK(convolution_matches(1000, 1000, 20));
+	CHECK(convolution_matches(4096, 4097, 64));
+
+	return 0;
+}
+
+static uint64_t random64(void)
+{
+	uint64_t r = 0;
+
+	for (int i = 0; i < 4; i++) {
+		r = (r << 16) ^ (uint64_t) (rand() & 0xffff);
+	}
+
+	return r;
+}
+
+static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t p)
+{
+	return (uint64_t) (((wide) a * b) % p);
+}
+
+static uint64_t pow_mod(uint64_t a, uint64_t e, uint64_t p)
+{
+	uint64_t r = 1;
+
+	for (; e; e >>= 1, a = mul_mod(a, a, p)) {
+		if (e & 1) {
+			r = mul_mod(r, a, p);
+		}
+	}
+
+	return r;
+}
+
+/* Checks a transform against the sum over a root of unity of order n,
+ * found as the n-th power of the generator of the transform of a unit
+ * impulse at index 1.
+ */
+static int matches_direct_dft(int n, int prime, int flags)
+{
+	uint64_t p = bina_ntt_modulus(prime);
+	uint64_t *x = calloc(n, sizeof(uint64_t));
+	uint64_t *y = calloc(n, sizeof(uint64_t));
+	bina_transform ntt = bina_transform_create_ntt(x, y, n, prime, flags);
+	uint64_t root;
+	int ok = 1;
+
+	if (ntt == NULL) {
+		return 0;
+	}
+
+	/* y[k] = w^k for an impulse at 1, so w = y[1] */
+	x[n > 1] = 1;
+	bina_transform_execute(ntt);
+	root = (n > 1) ? y[1] : 1;
+	ok = (pow_mod(root, n, p) == 1)
+		&& (n < 2 || pow_mod(root, n / 2, p) == p - 1);
+
+	for (int i = 0; i < n; i++) {
+		x[i] = random64() % p;
+	}
+
+	bina_transform_execute(ntt);
+
+	for (int k = 0; k < n && ok; k++) {
+		uint64_t sum = 0;
+		uint64_t wk = pow_mod(root, k, p);
+		uint64_t w = 1;
+
+		for (int i = 0; i < n; i++) {
+			sum = (sum + mul_mod(x[i], w, p)) % p;
+			w = mul_mod(w, wk, p);
+		}
+
+		ok = (y[k] == sum);
+	}
+
+	bina_transform_free(ntt);
+	free(x);
+	free(y);
+
+	return ok;
+}
+
+/* Forward then inverse, in place, gives back n times the input */
+static int round_trips(int n, int prime)
+{
+	uint64_t p = bina_ntt_modulus(prime);
+	uint64_t *x = calloc(n, sizeof(uint64_t));
+	uint64_t *y = calloc(n, sizeof(uint64_t));
+	bina_transform forward = bina_transform_create_ntt(y, y, n, prime, 0);
+	bina_transform inverse = bina_transform_create_ntt(y, y, n, prime,
+			BINA_FFT_INVERSE);
+	int ok = (forward != NULL && inverse != NULL);
+
+	for (int i = 0; i < n; i++) {
+		x[i] = y[i] = random64() % p;
+	}
+
+	bina_transform_execute(forward);
+	bina_transform_execute(inverse);
+
+	for (int i = 0; i < n && ok; i++) {
+		ok = (y[i] == mul_mod(x[i], n, p));
+	}
+
+	bina_transform_free(forward);
+	bina_transform_free(inverse);
+	free(x);
+	free(y);
+
+	return ok;
+}
+
+/* Checks an exact convolution of random numbers of the given bits against
+ * the schoolbook sums in 192-bit arithmetic, on a few outputs.
+ */
+static int convolution_matches(int a_length, int b_length, int bits)
+{
+	int n = a_length + b_length - 1;
+	uint64_t mask = (bits == 64) ? ~0ULL : (1ULL << bits) - 1;
+	uint64_t *a = calloc(a_length, sizeof(uint64_t));
+	uint64_t *b = calloc(b_length, sizeof(uint64_t));
+	uint64_t *out = calloc(3 * (size_t) n, sizeof(uint64_t));
+	bina_ntt_convolver conv = bina_ntt_convolver_create(n);
+	int ok = (conv != NULL);
+
+	for (int i = 0; i < a_length; i++) {
+		a[i] = (i % 3) ? random64() & mask : mask;
+	}
+
+	for (int i = 0; i < b_length; i++) {
+		b[i] = (i % 5) ? random64() & mask : mask;
+	}
+
+	ok = ok && bina_ntt_convolve(conv, a, a_length, b, b_length,
+			out) == 0;
+
+	for (int k = 0; k < n && ok; k += 1 + n / 50) {
+		uint64_t w[3] = { 0 };
+
+		for (int i = 0; i < a_length; i++) {
+			wide t;
+
+			if (k - i < 0 || k - i >= b_length) {
+				continue;
+			}
+
+			t = (wide) a[i] * b[k - i];
+			w[0] += (uint64_t) t;
+			t = (t >> 64) + (w[0] < (uint64_t) t) + w[1];
+			w[1] = (uint64_t) t;
+			w[2] += (uint64_t) (t >> 64);
+		}
+
+		ok = (out[3 * k] == w[0] && out[3 * k + 1] == w[1]
+				&& out[3 * k + 2] == w[2]);
+	}
+
+	/* The last output is the product of the last terms alone */
+	ok = ok && out[3 * (n - 1)] == (uint64_t) ((wide) a[a_length - 1]
+			* b[b_length - 1]);
+
+	bina_ntt_convolver_free(conv);
+	free(a);
+	free(b);
+	free(out);
+
+	return ok;
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* nufft_test.c - Unit test functions for the non-uniform FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double error_vs_nudft(int type, int modes, int num_points,
+		double tolerance, int flags);
+
+int main(int argc, char *argv[])
+{
+	double x = 0.5;
+
+	puts("nufft_test");
+
+	CHECK(bina_nufft_create(3, 16, &x, 1, 1e-6, 0) == NULL);
+	CHECK(bina_nufft_create(1, 15, &x, 1, 1e-6, 0) == NULL);
+	CHECK(bina_nufft_create(2, 16, &x, 0, 1e-6, 0) == NULL);
+	CHECK(bina_nufft_create(2, 16, &x, 1, 0.0, 0) == NULL);
+
+	CHECK(error_vs_nudft(1, 2, 1, 1e-6, 0) < 1e-5);
+	CHECK(error_vs_nudft(1, 64, 200, 1e-6, 0) < 1e-5);
+	CHECK(error_vs_nudft(2, 64, 200, 1e-6, 0) < 1e-5);
+	CHECK(error_vs_nudft(1, 100, 1000, 1e-12, BINA_FFT_INVERSE) < 1e-11);
+	CHECK(error_vs_nudft(2, 100, 1000, 1e-12, BINA_FFT_INVERSE) < 1e-11);
+	CHECK(error_vs_nudft(1, 256, 3000, 1e-9,
+				BINA_NUFFT_KAISER_BESSEL) < 1e-8);
+	CHECK(error_vs_nudft(2, 256, 3000, 1e-9, BINA_NUFFT_KAISER_BESSEL
+				| BINA_FFT_COMPACT_TWIDDLE) < 1e-8);
+	CHECK(error_vs_nudft(1, 32, 5000, 1e-3, 0) < 1e-2);
+
+	return 0;
+}
+
+/* Relative l2 error of a NUFFT of random data at random points, some well
+ * outside [-pi, pi), against the direct sums.
+ */
+static double error_vs_nudft(int type, int modes, int num_points,
+		double tolerance, int flags)
+{
+	int in_length = (type == 1) ? num_points : modes;
+	int out_length = (type == 1) ? modes : num_points;
+	double *x = calloc(num_points, sizeof(double));
+	bina_complex *in = calloc(in_length, sizeof(bina_complex));
+	bina_complex *out = calloc(out_length, sizeof(bina_complex));
+	double sign = (flags & BINA_FFT_INVERSE) ? 1.0 : -1.0;
+	double error = 0.0;
+	double norm = 0.0;
+	bina_nufft nufft;
+
+	for (int j = 0; j < num_points; j++) {
+		x[j] = (rand() / (double) RAND_MAX - 0.5) * 2.0 * M_PI;
+
+		if (j % 7 == 0) {
+			x[j] += 2.0 * M_PI * (rand() % 5 - 2);
+		}
+	}
+
+	for (int i = 0; i < in_length; i++) {
+		in[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	nufft = bina_nufft_create(type, modes, x, num_points, tolerance,
+			flags);
+
+	if (nufft == NULL || bina_nufft_execute(nufft, in, out) != 0) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < out_length; i++) {
+		long double complex sum = 0;
+
+		for (int m = 0; m < in_length; m++) {
+			int j = (type == 1) ? m : i;
+			int k = ((type == 1) ? i : m) - modes / 2;
+			long double a = sign * k * (long double) x[j];
+
+			sum += in[m] * (cosl(a) + sinl(a) * I);
+		}
+
+		error += pow(cabs(out[i] - (bina_complex) sum), 2.0);
+		norm += pow(cabs((bina_complex) sum), 2.0);
+	}
+
+	bina_nufft_free(nufft);
+	free(x);
+	free(in);
+	free(out);
+
+	return sqrt(error / norm);
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* partitioned_convolver_test.c - Unit test functions for the partitioned
+* convolver
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_direct(int filter_length, int block_length,
+		int max_partition_length, int signal_length, int flags);
+
+int main(int argc, char *argv[])
+{
+	bina_real h[4] = { 1 };
+
+	puts("partitioned_convolver_test");
+
+	CHECK(bina_partitioned_convolver_create(h, 4, 3, 0, 0) == NULL);
+	CHECK(bina_partitioned_convolver_create(h, 4, 16, 8, 0) == NULL);
+	CHECK(bina_partitioned_convolver_create(h, 0, 16, 0, 0) == NULL);
+
+	/* Uniform partitions */
+	CHECK(max_error_vs_direct(1, 2, 0, 100, 0) < 1e-9);
+	CHECK(max_error_vs_direct(100, 16, 0, 1000, 0) < 1e-9);
+
+	/* Growing partitions, up to four sizes */
+	CHECK(max_error_vs_direct(100, 16, 1024, 1000, 0) < 1e-9);
+	CHECK(max_error_vs_direct(700, 8, 32, 3000, 0) < 1e-9);
+	CHECK(max_error_vs_direct(5000, 16, 1024, 12000, 0) < 1e-9);
+	CHECK(max_error_vs_direct(3000, 64, 4096, 8000,
+				BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+
+	return 0;
+}
+
+/* Streams a random signal through a partitioned convolver block by block,
+ * in place, and compares it against direct convolution.
+ */
+static double max_error_vs_direct(int filter_length, int block_length,
+		int max_partition_length, int signal_length, int flags)
+{
+	bina_real *h = calloc(filter_length, sizeof(bina_real));
+	bina_real *x = calloc(signal_length, sizeof(bina_real));
+	bina_real *y = calloc(signal_length, sizeof(bina_real));
+	bina_partitioned_convolver conv = NULL;
+	double error = 0.0;
+
+	for (int i = 0; i < filter_length; i++) {
+		h[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	for (int i = 0; i < signal_length; i++) {
+		x[i] = y[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	conv = bina_partitioned_convolver_create(h, filter_length,
+			block_length, max_partition_length, flags);
+
+	if (conv == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i + block_length <= signal_length; i += block_length) {
+		bina_partitioned_convolver_process(conv, y + i, y + i);
+	}
+
+	for (int i = 0; i < signal_length / block_length * block_length; i++) {
+		double sum = 0.0;
+
+		for (int k = 0; k < filter_length && k <= i; k++) {
+			sum += h[k] * x[i - k];
+		}
+
+		error = fmax(error, fabs(y[i] - sum));
+	}
+
+	bina_partitioned_convolver_free(conv);
+	free(h);
+	free(x);
+	free(y);
+
+	return error;
+}
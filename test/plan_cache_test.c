@@ -0,0 +1,100 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* plan_cache_test.c - Unit test functions for the on-disk plan cache
+*******************************************************************************/
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/aligned_malloc.h"
+#include "internal/check.h"
+
+#define CACHE_PATH "plan_cache_test.bin"
+
+static int same_as_uncached(bina_plan_cache cache, int fft_len, int flags);
+
+int main(int argc, char *argv[])
+{
+	const int lengths[] = { 2, 16, 1024, 4096 };
+	const int zero_length[] = { 16, 0, 1024 };
+	const int odd_length[] = { 16, 12 };
+	bina_plan_cache cache = NULL;
+	FILE *fp = NULL;
+
+	puts("plan_cache_test");
+
+	CHECK(bina_plan_cache_write(CACHE_PATH, lengths, 4, 0) == 0);
+	CHECK((cache = bina_plan_cache_open(CACHE_PATH)) != NULL);
+
+	CHECK(same_as_uncached(cache, 16, 0));
+	CHECK(same_as_uncached(cache, 4096, 0));
+	/* Not in the cache, computed instead */
+	CHECK(same_as_uncached(cache, 64, 0));
+	CHECK(same_as_uncached(cache, 1024, BINA_FFT_COMPACT_TWIDDLE));
+
+	CHECK(bina_plan_cache_close(cache) == 0);
+
+	CHECK(bina_plan_cache_write(CACHE_PATH, lengths, 4,
+			BINA_FFT_COMPACT_TWIDDLE) == 0);
+	CHECK((cache = bina_plan_cache_open(CACHE_PATH)) != NULL);
+	CHECK(same_as_uncached(cache, 1024, BINA_FFT_COMPACT_TWIDDLE));
+	CHECK(bina_plan_cache_close(cache) == 0);
+
+	/* A truncated file is rejected */
+	fp = fopen(CACHE_PATH, "r+b");
+	CHECK(fp != NULL && fseek(fp, 0, SEEK_END) == 0);
+	fputc(0, fp);
+	fclose(fp);
+	CHECK(bina_plan_cache_open(CACHE_PATH) == NULL);
+
+	CHECK(bina_plan_cache_open("does/not/exist") == NULL);
+
+	remove(CACHE_PATH);
+
+	/* One bad size rejects the whole call, and nothing is written */
+	CHECK(bina_plan_cache_write(CACHE_PATH, zero_length, 3, 0) == -1);
+	CHECK(bina_plan_cache_write(CACHE_PATH, odd_length, 2, 0) == -1);
+	CHECK((fp = fopen(CACHE_PATH, "rb")) == NULL);
+	CHECK((fp = fopen(CACHE_PATH ".tmp", "rb")) == NULL);
+
+	return 0;
+}
+
+/* Runs the same input through a cached and an uncached plan, the results
+ * must match bit for bit.
+ */
+static int same_as_uncached(bina_plan_cache cache, int fft_len, int flags)
+{
+	bina_complex *in = aligned_calloc(16, fft_len, sizeof(bina_complex));
+	bina_complex *out0 = aligned_calloc(16, fft_len, sizeof(bina_complex));
+	bina_complex *out1 = aligned_calloc(16, fft_len, sizeof(bina_complex));
+	bina_transform t0 = bina_transform_create_radix2_c2c_fft(in, out0,
+			fft_len, flags);
+	bina_transform t1 = bina_transform_create_radix2_c2c_fft_cached(cache,
+			in, out1, fft_len, flags);
+	int same = (t0 != NULL) && (t1 != NULL);
+
+	for (int i = 0; i < fft_len; i++) {
+		in[i] = rand() / (double) RAND_MAX + I * rand() / (double) RAND_MAX;
+	}
+
+	if (same) {
+		bina_transform_execute(t0);
+		bina_transform_execute(t1);
+		same = memcmp(out0, out1, fft_len * sizeof(bina_complex)) == 0;
+	}
+
+	bina_transform_free(t0);
+	bina_transform_free(t1);
+	aligned_free(in);
+	aligned_free(out0);
+	aligned_free(out1);
+
+	return same;
+}
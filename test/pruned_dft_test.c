@@ -0,0 +1,92 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* pruned_dft_test.c - Unit test functions for the pruned DFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_dft(int n, int num_bins, int flags);
+
+int main(int argc, char *argv[])
+{
+	int bins[] = { 0, 5, 9 };
+
+	puts("pruned_dft_test");
+
+	CHECK(bina_transform_create_pruned_dft(NULL, NULL, 12, bins, 3, 0)
+			== NULL);
+	CHECK(bina_transform_create_pruned_dft(NULL, NULL, 8, bins, 3, 0)
+			== NULL);
+
+	/* Few bins run the Goertzel bank, many the pruned FFT */
+	CHECK(max_error_vs_dft(1, 1, 0) < 1e-9);
+	CHECK(max_error_vs_dft(2, 2, 0) < 1e-9);
+	CHECK(max_error_vs_dft(64, 1, 0) < 1e-9);
+	CHECK(max_error_vs_dft(4096, 4, 0) < 1e-8);
+	CHECK(max_error_vs_dft(4096, 40, 0) < 1e-8);
+	CHECK(max_error_vs_dft(4096, 40, BINA_FFT_INVERSE) < 1e-8);
+	CHECK(max_error_vs_dft(1024, 300, BINA_FFT_COMPACT_TWIDDLE) < 1e-9);
+	CHECK(max_error_vs_dft(256, 256, 0) < 1e-9);
+	CHECK(max_error_vs_dft(256, 100, BINA_FFT_NONZERO_INPUTS(3)) < 1e-9);
+	CHECK(max_error_vs_dft(256, 100, BINA_FFT_SCRAMBLED) < 1e-9);
+	CHECK(max_error_vs_dft(256, 100, BINA_FFT_SCRAMBLED
+				| BINA_FFT_INVERSE) < 1e-9);
+
+	return 0;
+}
+
+/* Picks random bins (repeats allowed) and compares them with a direct DFT */
+static double max_error_vs_dft(int n, int num_bins, int flags)
+{
+	bina_complex *x = calloc(n, sizeof(bina_complex));
+	bina_complex *y = calloc(num_bins, sizeof(bina_complex));
+	int *bins = calloc(num_bins, sizeof(int));
+	bina_transform plan;
+	long double sign = (flags & BINA_FFT_INVERSE) ? 1.0L : -1.0L;
+	double error = 0.0;
+
+	for (int j = 0; j < num_bins; j++) {
+		bins[j] = rand() % n;
+	}
+
+	for (int i = 0; i < n; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	plan = bina_transform_create_pruned_dft(x, y, n, bins, num_bins,
+			flags);
+
+	if (plan == NULL || bina_transform_execute(plan) != 0) {
+		return INFINITY;
+	}
+
+	for (int j = 0; j < num_bins; j++) {
+		long double complex sum = 0;
+
+		for (int i = 0; i < n; i++) {
+			long double t = 2.0L * M_PI
+				* (((long) i * bins[j]) % n) / n;
+
+			sum += x[i] * (cosl(t) + sign * sinl(t) * I);
+		}
+
+		error = fmax(error, cabs(y[j] - (bina_complex) sum));
+	}
+
+	bina_transform_free(plan);
+	free(x);
+	free(y);
+	free(bins);
+
+	return error;
+}
@@ -0,0 +1,157 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* r2r_test.c - Unit test functions for the cosine and sine transforms
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static long double direct(int kind, const double *x, int n, int k);
+
+static double max_error_vs_direct(int kind, int n, int flags);
+
+static double max_error_round_trip(int kind, int inverse_kind, int n);
+
+int main(int argc, char *argv[])
+{
+	double x[8] = { 0 };
+
+	puts("r2r_test");
+
+	CHECK(bina_transform_create_r2r(x, x, 6, BINA_DCT_II, 0) == NULL);
+	CHECK(bina_transform_create_r2r(x, x, 8, BINA_DCT_I, 0) == NULL);
+	CHECK(bina_transform_create_r2r(x, x, 1, BINA_DCT_II, 0) == NULL);
+	CHECK(bina_transform_create_r2r(x, x, 8, 6, 0) == NULL);
+
+	for (int kind = BINA_DCT_I; kind <= BINA_DST_III; kind++) {
+		CHECK(max_error_vs_direct(kind, 2, 0) < 1e-12);
+		CHECK(max_error_vs_direct(kind, 4, 0) < 1e-12);
+		CHECK(max_error_vs_direct(kind, 64, 0) < 1e-12);
+		CHECK(max_error_vs_direct(kind, 1024,
+					BINA_FFT_COMPACT_TWIDDLE) < 1e-11);
+	}
+
+	CHECK(max_error_round_trip(BINA_DCT_II, BINA_DCT_III, 256) < 1e-12);
+	CHECK(max_error_round_trip(BINA_DST_II, BINA_DST_III, 256) < 1e-12);
+	CHECK(max_error_round_trip(BINA_DCT_I, BINA_DCT_I, 256) < 1e-12);
+	CHECK(max_error_round_trip(BINA_DCT_IV, BINA_DCT_IV, 256) < 1e-12);
+
+	return 0;
+}
+
+/* Output k of a transform by its definition */
+static long double direct(int kind, const double *x, int n, int k)
+{
+	const long double pi = 3.14159265358979323846264338327950288L;
+	long double sum = 0.0L;
+
+	for (int i = 0; i < n; i++) {
+		switch (kind) {
+		case BINA_DCT_I:
+			sum += x[i] * cosl(pi * i * k / n);
+			break;
+		case BINA_DCT_II:
+			sum += x[i] * cosl(pi * (2 * i + 1) * k / (2 * n));
+			break;
+		case BINA_DCT_III:
+			sum += x[i] * cosl(pi * i * (2 * k + 1) / (2 * n))
+				* (i ? 1.0L : 0.5L);
+			break;
+		case BINA_DCT_IV:
+			sum += x[i] * cosl(pi * (2 * i + 1) * (2 * k + 1)
+					/ (4 * n));
+			break;
+		case BINA_DST_II:
+			sum += x[i] * sinl(pi * (2 * i + 1) * (k + 1)
+					/ (2 * n));
+			break;
+		case BINA_DST_III:
+			sum += x[i] * sinl(pi * (i + 1) * (2 * k + 1)
+					/ (2 * n)) * (i < n - 1 ? 1.0L : 0.5L);
+			break;
+		}
+	}
+
+	if (kind == BINA_DCT_I) {
+		sum += 0.5L * ((k % 2 ? -x[n] : x[n]) - x[0]);
+	}
+
+	return sum;
+}
+
+/* Largest error of a transform of random data, done in place, relative to
+ * the largest output.
+ */
+static double max_error_vs_direct(int kind, int n, int flags)
+{
+	int points = (kind == BINA_DCT_I) ? n + 1 : n;
+	double *x = calloc(points, sizeof(double));
+	double *y = calloc(points, sizeof(double));
+	bina_transform fft = bina_transform_create_r2r(y, y, points, kind,
+			flags);
+	double error = 0.0;
+	double scale = 0.0;
+
+	if (fft == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < points; i++) {
+		x[i] = y[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	bina_transform_execute(fft);
+
+	for (int k = 0; k < points; k++) {
+		long double expected = direct(kind, x, n, k);
+
+		error = fmax(error, fabs(y[k] - (double) expected));
+		scale = fmax(scale, fabs((double) expected));
+	}
+
+	bina_transform_free(fft);
+	free(x);
+	free(y);
+
+	return error / scale;
+}
+
+/* Largest error of a transform followed by its inverse, times 2 / N */
+static double max_error_round_trip(int kind, int inverse_kind, int n)
+{
+	int points = (kind == BINA_DCT_I) ? n + 1 : n;
+	double *x = calloc(points, sizeof(double));
+	double *y = calloc(points, sizeof(double));
+	double *z = calloc(points, sizeof(double));
+	bina_transform forward = bina_transform_create_r2r(x, y, points,
+			kind, 0);
+	bina_transform inverse = bina_transform_create_r2r(y, z, points,
+			inverse_kind, 0);
+	double error = 0.0;
+
+	for (int i = 0; i < points; i++) {
+		x[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	bina_transform_execute(forward);
+	bina_transform_execute(inverse);
+
+	for (int i = 0; i < points; i++) {
+		error = fmax(error, fabs(z[i] * 2.0 / n - x[i]));
+	}
+
+	bina_transform_free(forward);
+	bina_transform_free(inverse);
+	free(x);
+	free(y);
+	free(z);
+
+	return error;
+}
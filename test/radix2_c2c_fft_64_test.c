@@ -0,0 +1,83 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* radix2_c2c_fft_64_test.c - Unit test functions for the 64-bit length FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double error_vs_plain(size_t n, int in_place, int flags);
+
+int main(int argc, char *argv[])
+{
+	bina_complex x[4] = { 0 };
+
+	puts("radix2_c2c_fft_64_test");
+
+	CHECK(bina_transform_create_radix2_c2c_fft_64(x, x, 0, 0) == NULL);
+	CHECK(bina_transform_create_radix2_c2c_fft_64(x, x, 3, 0) == NULL);
+	CHECK(bina_transform_create_radix2_c2c_fft_64(x, x,
+				(size_t) 1 << 61, 0) == NULL);
+
+	/* Short lengths are the plain transform, long ones four steps with
+	 * square and oblong splits.
+	 */
+	CHECK(error_vs_plain(1024, 0, 0) == 0.0);
+	CHECK(error_vs_plain((size_t) 1 << 21, 0, 0) < 1e-13);
+	CHECK(error_vs_plain((size_t) 1 << 21, 1, BINA_FFT_INVERSE) < 1e-13);
+	CHECK(error_vs_plain((size_t) 1 << 22, 1, BINA_FFT_COMPACT_TWIDDLE)
+			< 1e-13);
+
+	return 0;
+}
+
+/* Largest error against the plain transform of the same random input,
+ * relative to the largest bin.
+ */
+static double error_vs_plain(size_t n, int in_place, int flags)
+{
+	bina_complex *x = malloc(n * sizeof(bina_complex));
+	bina_complex *y = malloc(n * sizeof(bina_complex));
+	bina_complex *z = malloc(n * sizeof(bina_complex));
+	bina_transform fft = bina_transform_create_radix2_c2c_fft_64(x,
+			in_place ? x : y, n, flags);
+	bina_transform plain = bina_transform_create_radix2_c2c_fft(z, z,
+			(int) n, flags);
+	double error = 0.0;
+	double scale = 0.0;
+
+	if (fft == NULL || plain == NULL) {
+		return INFINITY;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	memcpy(z, x, n * sizeof(bina_complex));
+	bina_transform_execute(fft);
+	bina_transform_execute(plain);
+
+	for (size_t k = 0; k < n; k++) {
+		error = fmax(error, cabs((in_place ? x : y)[k] - z[k]));
+		scale = fmax(scale, cabs(z[k]));
+	}
+
+	bina_transform_free(fft);
+	bina_transform_free(plain);
+	free(x);
+	free(y);
+	free(z);
+
+	return error / scale;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* sdft_test.c - Unit test functions for the sliding DFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_dft(int n, const int *bins, int num_bins,
+		double damping, int resync_interval, int seed, int length,
+		int flags);
+
+int main(int argc, char *argv[])
+{
+	int bins[] = { 0, 3, 7, 8, 15 };
+
+	puts("sdft_test");
+
+	CHECK(bina_sdft_create(12, NULL, 0, 1.0, 0, 0) == NULL);
+	CHECK(bina_sdft_create(16, NULL, 0, 1.5, 0, 0) == NULL);
+	CHECK(bina_sdft_create(4, bins, 5, 1.0, 0, 0) == NULL);
+
+	CHECK(max_error_vs_dft(1, NULL, 0, 1.0, 0, 0, 20, 0) < 1e-9);
+	CHECK(max_error_vs_dft(16, NULL, 0, 1.0, 0, 0, 300, 0) < 1e-9);
+	CHECK(max_error_vs_dft(16, bins, 5, 1.0, 7, 1, 300, 0) < 1e-9);
+	CHECK(max_error_vs_dft(16, bins, 5, 0.999, 0, 1, 300, 0) < 1e-9);
+	CHECK(max_error_vs_dft(64, NULL, 0, 0.99, 1000, 0, 500, 0) < 1e-9);
+	CHECK(max_error_vs_dft(16, NULL, 0, 1.0, 0, 0, 300,
+				BINA_FFT_NONZERO_INPUTS(1)) < 1e-9);
+	CHECK(max_error_vs_dft(16, NULL, 0, 1.0, 0, 0, 300,
+				BINA_FFT_SCRAMBLED) < 1e-9);
+
+	/* Drift stays bounded over a long run */
+	CHECK(max_error_vs_dft(32, bins, 5, 1.0, 0, 0, 200000, 0) < 1e-9);
+
+	return 0;
+}
+
+/* Slides a random signal through a sliding DFT in random sized chunks, and
+ * checks the bins after every sample against a direct DFT of the damped
+ * window. Only the last 500 samples are checked on long runs.
+ */
+static double max_error_vs_dft(int n, const int *bins, int num_bins,
+		double damping, int resync_interval, int seed, int length,
+		int flags)
+{
+	int k_count = bins ? num_bins : n;
+	int start = seed ? n : 0;
+	bina_complex *x = calloc(start + length, sizeof(bina_complex));
+	bina_complex *out = calloc((size_t) length * k_count,
+			sizeof(bina_complex));
+	bina_sdft sdft = bina_sdft_create(n, bins, num_bins, damping,
+			resync_interval, flags);
+	double error = 0.0;
+
+	if (sdft == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < start + length; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	if (seed) {
+		bina_sdft_seed(sdft, x);
+	}
+
+	for (int i = 0; i < length;) {
+		int len = 1 + rand() % (2 * n);
+
+		if (len > length - i) {
+			len = length - i;
+		}
+
+		bina_sdft_process(sdft, x + start + i, len,
+				out + (size_t) i * k_count);
+		i += len;
+	}
+
+	for (int i = (length > 500) ? length - 500 : 0; i < length; i++) {
+		/* Window ends at sample start + i */
+		long last = start + i;
+
+		for (int j = 0; j < k_count; j++) {
+			int k = bins ? bins[j] : j;
+			long double complex sum = 0;
+
+			for (int m = 0; m < n; m++) {
+				long idx = last - (n - 1) + m;
+				long double a = 2.0L * M_PI * ((m * k) % n) / n;
+
+				if (idx < 0) {
+					continue;
+				}
+
+				sum += x[idx] * powl(damping, n - 1 - m)
+					* (cosl(a) - sinl(a) * I);
+			}
+
+			error = fmax(error, cabs(out[(size_t) i * k_count + j]
+						- (bina_complex) sum));
+		}
+	}
+
+	bina_sdft_free(sdft);
+	free(x);
+	free(out);
+
+	return error;
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* sparse_fft_test.c - Unit test functions for the sparse FFT
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_sparse(int n, int tones, double noise,
+		double *confidence);
+
+int main(int argc, char *argv[])
+{
+	double confidence = 0.0;
+
+	puts("sparse_fft_test");
+
+	CHECK(bina_sparse_fft_create(1000, 4, 0) == NULL);
+	CHECK(bina_sparse_fft_create(1024, 0, 0) == NULL);
+
+	CHECK(max_error_sparse(16, 1, 0.0, &confidence) < 1e-9);
+	CHECK(confidence > 0.999);
+	CHECK(max_error_sparse(1 << 12, 8, 0.0, &confidence) < 1e-9);
+	CHECK(confidence > 0.999);
+	CHECK(max_error_sparse(1 << 18, 50, 0.0, &confidence) < 1e-6);
+	CHECK(confidence > 0.999);
+
+	/* A dense spectrum is flagged */
+	max_error_sparse(1 << 12, 8, 1.0, &confidence);
+	CHECK(confidence < 0.5);
+
+	return 0;
+}
+
+/* Builds a signal of random tones on the bin grid, plus uniform noise of
+ * the given amplitude, and compares the recovered bins with the tones.
+ */
+static double max_error_sparse(int n, int tones, double noise,
+		double *confidence)
+{
+	bina_complex *x = calloc(n, sizeof(bina_complex));
+	int *bins = calloc(tones, sizeof(int));
+	bina_complex *amplitude = calloc(tones, sizeof(bina_complex));
+	int *found = calloc(tones, sizeof(int));
+	bina_complex *values = calloc(tones, sizeof(bina_complex));
+	bina_sparse_fft sparse = bina_sparse_fft_create(n, tones, 0);
+	double error = 0.0;
+	int count;
+
+	if (sparse == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < tones; i++) {
+		int fresh;
+
+		do {
+			bins[i] = rand() % n;
+			fresh = 1;
+
+			for (int j = 0; j < i; j++) {
+				fresh &= (bins[j] != bins[i]);
+			}
+		} while (!fresh);
+
+		amplitude[i] = (1.0 + rand() / (double) RAND_MAX)
+			* cexp(2.0 * M_PI * I * rand() / (double) RAND_MAX);
+	}
+
+	for (int t = 0; t < n; t++) {
+		x[t] = noise * ((rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I);
+
+		for (int i = 0; i < tones; i++) {
+			double a = 2.0 * M_PI * (((long) bins[i] * t) % n) / n;
+
+			x[t] += amplitude[i] * cexp(I * a);
+		}
+	}
+
+	count = bina_sparse_fft_execute(sparse, x, found, values, confidence);
+
+	if (count != tones) {
+		error = INFINITY;
+	}
+
+	/* X[k] = n a for a tone a exp(2 pi i k t / n) */
+	for (int j = 0; j < count; j++) {
+		int i = 0;
+
+		while (i < tones && bins[i] != found[j]) {
+			i++;
+		}
+
+		error = fmax(error, (i == tones) ? INFINITY
+				: cabs(values[j] / n - amplitude[i]));
+	}
+
+	bina_sparse_fft_free(sparse);
+	free(x);
+	free(bins);
+	free(amplitude);
+	free(found);
+	free(values);
+
+	return error;
+}
@@ -0,0 +1,162 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* stft_test.c - Unit test functions for the short time Fourier transform
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_dft(int fft_len, int hop, int window, int flags,
+		int signal_length);
+
+int main(int argc, char *argv[])
+{
+	puts("stft_test");
+
+	CHECK(bina_stft_create(12, 4, BINA_WINDOW_HANN, 0) == NULL);
+	CHECK(bina_stft_create(16, 0, BINA_WINDOW_HANN, 0) == NULL);
+	CHECK(bina_stft_create(16, 4, 42, 0) == NULL);
+
+	CHECK(max_error_vs_dft(16, 4, BINA_WINDOW_HANN, 0, 200) < 1e-9);
+	CHECK(max_error_vs_dft(64, 64, BINA_WINDOW_RECTANGULAR, 0, 500) < 1e-9);
+	CHECK(max_error_vs_dft(32, 50, BINA_WINDOW_HAMMING, 0, 500) < 1e-9);
+	CHECK(max_error_vs_dft(256, 100, BINA_WINDOW_BLACKMAN,
+				BINA_FFT_COMPACT_TWIDDLE, 2000) < 1e-9);
+	CHECK(max_error_vs_dft(64, 16, BINA_WINDOW_HANN,
+				BINA_STFT_POWER, 1000) < 1e-9);
+	CHECK(max_error_vs_dft(64, 16, BINA_WINDOW_HANN,
+				BINA_STFT_LOG_POWER, 1000) < 1e-9);
+	CHECK(max_error_vs_dft(64, 16, BINA_WINDOW_HANN,
+				BINA_FFT_NONZERO_INPUTS(2), 500) < 1e-9);
+	CHECK(max_error_vs_dft(64, 16, BINA_WINDOW_HANN,
+				BINA_FFT_SCRAMBLED, 500) < 1e-9);
+
+	return 0;
+}
+
+/* Streams a random signal through an STFT in random sized chunks, checks
+ * the frames against direct DFTs of the windowed frames, and against the
+ * frames of bina_stft_spectrogram().
+ */
+static double max_error_vs_dft(int fft_len, int hop, int window, int flags,
+		int signal_length)
+{
+	int power = flags & (BINA_STFT_POWER | BINA_STFT_LOG_POWER);
+	int max_frames = (signal_length - fft_len) / hop + 1;
+	bina_complex *x = calloc(signal_length, sizeof(bina_complex));
+	bina_complex *frames = calloc((size_t) max_frames * fft_len,
+			sizeof(bina_complex));
+	bina_complex *offline = calloc((size_t) max_frames * fft_len,
+			sizeof(bina_complex));
+	bina_stft stft = bina_stft_create(fft_len, hop, window, flags);
+	double error = 0.0;
+	int count = 0;
+
+	if (stft == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < signal_length; i++) {
+		x[i] = (rand() / (double) RAND_MAX - 0.5)
+			+ (rand() / (double) RAND_MAX - 0.5) * I;
+	}
+
+	for (int i = 0; i < signal_length;) {
+		int n = 1 + rand() % (2 * fft_len);
+		int expect;
+		size_t frame_size = power ? fft_len * sizeof(double)
+			: fft_len * sizeof(bina_complex);
+
+		if (n > signal_length - i) {
+			n = signal_length - i;
+		}
+
+		expect = bina_stft_frame_count(stft, n);
+
+		if (bina_stft_process(stft, x + i, n, (unsigned char *) frames
+				+ count * frame_size) != expect) {
+			return INFINITY;
+		}
+
+		count += expect;
+		i += n;
+	}
+
+	if (count != max_frames
+			|| bina_stft_spectrogram(stft, x, signal_length,
+				offline) != count) {
+		return INFINITY;
+	}
+
+	for (int f = 0; f < count; f++) {
+		const bina_complex *frame = x + (size_t) f * hop;
+
+		for (int k = 0; k < fft_len; k++) {
+			long double complex sum = 0;
+			double value, expect;
+
+			for (int n = 0; n < fft_len; n++) {
+				long double t = 2.0L * M_PI * n / fft_len;
+				long double w = 1.0L;
+				long double a = 2.0L * M_PI * ((n * k) % fft_len)
+					/ fft_len;
+
+				switch (window) {
+				case BINA_WINDOW_HANN:
+					w = 0.5L - 0.5L * cosl(t);
+					break;
+				case BINA_WINDOW_HAMMING:
+					w = 0.54L - 0.46L * cosl(t);
+					break;
+				case BINA_WINDOW_BLACKMAN:
+					w = 0.42L - 0.5L * cosl(t)
+						+ 0.08L * cosl(2.0L * t);
+					break;
+				}
+
+				sum += frame[n] * w * (cosl(a) - sinl(a) * I);
+			}
+
+			if (power) {
+				const double *p = (const double *) frames;
+				const double *q = (const double *) offline;
+				double ref = cabs((bina_complex) sum);
+
+				ref *= ref;
+
+				if (flags & BINA_STFT_LOG_POWER) {
+					ref = 10.0 * log10(ref);
+				}
+
+				value = p[(size_t) f * fft_len + k];
+				expect = ref;
+				error = fmax(error, fabs(q[(size_t) f * fft_len + k]
+							- value));
+			} else {
+				bina_complex v = frames[(size_t) f * fft_len + k];
+
+				value = 0.0;
+				expect = cabs(v - (bina_complex) sum);
+				error = fmax(error, cabs(offline[(size_t) f
+							* fft_len + k] - v));
+			}
+
+			error = fmax(error, fabs(value - expect));
+		}
+	}
+
+	bina_stft_free(stft);
+	free(x);
+	free(frames);
+	free(offline);
+
+	return error;
+}
@@ -0,0 +1,161 @@
+/*******************************************************************************
+* bina-fft: A simple FFT implementation for education purpose
+* Copyright (C) 2012 - Ayan Shafqat, All rights reserved.
+* See LICENSE for more information.
+*
+* welch_test.c - Unit test functions for the Welch PSD estimator
+*******************************************************************************/
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binafft.h"
+#include "internal/check.h"
+
+static double max_error_vs_direct(int n, int hop, double alpha,
+		int signal_length, int flags);
+static double white_noise_level(int n);
+
+int main(int argc, char *argv[])
+{
+	puts("welch_test");
+
+	CHECK(bina_welch_create(12, 6, BINA_WINDOW_HANN, 0.0, 0) == NULL);
+	CHECK(bina_welch_create(16, 8, BINA_WINDOW_HANN, 1.5, 0) == NULL);
+
+	CHECK(max_error_vs_direct(2, 1, 0.0, 50, 0) < 1e-9);
+	CHECK(max_error_vs_direct(16, 8, 0.0, 300, 0) < 1e-9);
+	CHECK(max_error_vs_direct(64, 100, 0.0, 1000, 0) < 1e-9);
+	CHECK(max_error_vs_direct(32, 8, 0.25, 600, 0) < 1e-9);
+	CHECK(max_error_vs_direct(128, 64, 1.0, 1000, 0) < 1e-9);
+	CHECK(max_error_vs_direct(64, 32, 0.0, 1000,
+				BINA_FFT_NONZERO_INPUTS(2)) < 1e-9);
+	CHECK(max_error_vs_direct(64, 32, 0.0, 1000, BINA_FFT_SCRAMBLED)
+			< 1e-9);
+
+	/* Unit variance white noise has a one-sided density of 2 */
+	CHECK(fabs(white_noise_level(64) - 2.0) < 0.05);
+
+	return 0;
+}
+
+/* Feeds a random signal in random sized chunks and compares the estimate
+ * with one made from direct DFTs of the segments.
+ */
+static double max_error_vs_direct(int n, int hop, double alpha,
+		int signal_length, int flags)
+{
+	bina_real *x = calloc(signal_length, sizeof(bina_real));
+	double *psd = calloc(n / 2 + 1, sizeof(double));
+	double *ref = calloc(n / 2 + 1, sizeof(double));
+	double *w = calloc(n, sizeof(double));
+	bina_welch welch = bina_welch_create(n, hop, BINA_WINDOW_HANN, alpha,
+			flags);
+	double error = 0.0;
+	double u = 0.0;
+	int segments = 0;
+
+	if (welch == NULL) {
+		return INFINITY;
+	}
+
+	for (int i = 0; i < signal_length; i++) {
+		x[i] = rand() / (double) RAND_MAX - 0.5;
+	}
+
+	for (int i = 0; i < n; i++) {
+		w[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / n);
+		u += w[i] * w[i];
+	}
+
+	for (int i = 0; i < signal_length;) {
+		int len = 1 + rand() % (3 * n);
+
+		if (len > signal_length - i) {
+			len = signal_length - i;
+		}
+
+		bina_welch_process(welch, x + i, len);
+		i += len;
+	}
+
+	for (int start = 0; start + n <= signal_length; start += hop) {
+		for (int k = 0; k <= n / 2; k++) {
+			long double complex sum = 0;
+			double p;
+
+			for (int j = 0; j < n; j++) {
+				long double t = 2.0L * M_PI * ((j * k) % n) / n;
+				sum += x[start + j] * w[j] * (cosl(t) - sinl(t) * I);
+			}
+
+			p = cabs((bina_complex) sum);
+			p *= p;
+
+			if (alpha == 0.0) {
+				ref[k] += p;
+			} else if (segments == 0) {
+				ref[k] = p;
+			} else {
+				ref[k] = (1.0 - alpha) * ref[k] + alpha * p;
+			}
+		}
+
+		segments++;
+	}
+
+	if (bina_welch_psd(welch, psd) != segments) {
+		return INFINITY;
+	}
+
+	for (int k = 0; k <= n / 2; k++) {
+		double scale = (k == 0 || k == n / 2) ? 1.0 : 2.0;
+
+		scale /= u;
+
+		if (alpha == 0.0) {
+			scale /= segments;
+		}
+
+		error = fmax(error, fabs(psd[k] - ref[k] * scale));
+	}
+
+	bina_welch_free(welch);
+	free(x);
+	free(psd);
+	free(ref);
+	free(w);
+
+	return error;
+}
+
+/* Mean of the interior bins of the estimate for unit variance noise */
+static double white_noise_level(int n)
+{
+	int length = 1 << 18;
+	bina_real *x = calloc(length, sizeof(bina_real));
+	double *psd = calloc(n / 2 + 1, sizeof(double));
+	bina_welch welch = bina_welch_create(n, n / 2, BINA_WINDOW_HANN, 0.0,
+			0);
+	double level = 0.0;
+
+	/* Uniform noise on [-sqrt(3), sqrt(3)] has unit variance */
+	for (int i = 0; i < length; i++) {
+		x[i] = sqrt(3.0) * (2.0 * rand() / (double) RAND_MAX - 1.0);
+	}
+
+	bina_welch_process(welch, x, length);
+	bina_welch_psd(welch, psd);
+
+	for (int k = 1; k < n / 2; k++) {
+		level += psd[k] / (n / 2 - 1);
+	}
+
+	bina_welch_free(welch);
+	free(x);
+	free(psd);
+
+	return level;
+}